@@ -1,330 +1,3085 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"        // Librería base de FreeRTOS
 #include "freertos/task.h"            // Para manejo de tareas
 #include "freertos/queue.h"           // Para manejo de colas
 #include "freertos/semphr.h"          // Para semáforos
-#include "driver/gpio.h"              // Driver GPIO del ESP-IDF
 #include "esp_log.h"                  // Para logging y debug
+#include "esp_timer.h"                // Marcas de tiempo en microsegundos y temporizadores
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_system.h"               // Heap libre, para medir el arranque
+#endif
+
+// Modo simulación: un inyector genera miles de pulsos en los botones y verifica
+// que cada evento llegue exactamente una vez a su LED (0 = desactivado)
+#define MODO_SIMULACION  0
+
+// Modo de entrega de eventos desde la ISR
+#define ENTREGA_COLA          0   // Cola por LED (xQueueSendFromISR)
+#define ENTREGA_NOTIFICACION  1   // Notificación directa a la tarea, un bit por botón
+#define MODO_ENTREGA_ISR      ENTREGA_COLA
+
+// Control de los LEDs
+#define LEDS_TAREA_POR_LED    0   // Una tarea con su propia pila por LED (diseño original)
+#define LEDS_MOTOR_PATRONES   1   // Un solo planificador recorre patrones declarados como tablas
+#define MODO_LEDS             LEDS_MOTOR_PATRONES
+
+// Benchmark de ciclos: duración de la ISR y latencia ISR -> tarea (requiere MODO_SIMULACION)
+#define MODO_BENCHMARK_ISR  0
+
+#if MODO_BENCHMARK_ISR && !MODO_SIMULACION
+#error "MODO_BENCHMARK_ISR usa el inyector de pulsos de MODO_SIMULACION"
+#endif
+
+// Benchmark de latencia flanco -> LED: del flanco en el botón 1 a la escritura del
+// LED rojo, con tareas de carga de CPU a varias prioridades (requiere MODO_SIMULACION)
+#define MODO_BENCHMARK_LATENCIA  0
+
+#if MODO_BENCHMARK_LATENCIA && (!MODO_SIMULACION || MODO_BENCHMARK_ISR)
+#error "MODO_BENCHMARK_LATENCIA usa los pines simulados de MODO_SIMULACION y excluye MODO_BENCHMARK_ISR"
+#endif
+
+// Bajo consumo: gestión de energía con sueño ligero automático entre presiones
+// Requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE en menuconfig
+#define MODO_BAJO_CONSUMO  0
+
+// Prueba del anti-rebote: reproduce trazas simuladas con rebotes y ruido y mide
+// falsas aceptaciones y falsos rechazos de cada estrategia (no arranca las tareas)
+#define MODO_PRUEBA_REBOTES  0
+
+// Gestos: los dos flancos asentados de cada botón alimentan una máquina de estados
+// que clasifica presión corta, larga, doble clic y repetición al mantener
+#define MODO_GESTOS  0
+
+#if MODO_GESTOS && (MODO_SIMULACION || MODO_ENTREGA_ISR != ENTREGA_COLA || MODO_LEDS != LEDS_MOTOR_PATRONES)
+#error "MODO_GESTOS requiere entrega por cola y el motor de patrones, y excluye MODO_SIMULACION"
+#endif
+
+// Prueba de la máquina de gestos: reproduce líneas de tiempo de flancos sintéticos
+// y compara los gestos emitidos contra los esperados (no arranca las tareas)
+#define MODO_PRUEBA_GESTOS  0
+
+// Registro diferido: los logs de los lazos guardan formato y argumentos crudos en
+// un anillo por núcleo y una tarea de prioridad mínima los escribe (0 = ESP_LOGI directo)
+#define MODO_REGISTRO_DIFERIDO  0
+
+// Benchmark del registro: ciclos por llamada y pila usada con ESP_LOGI contra el
+// registro diferido (no arranca las tareas)
+#define MODO_BENCHMARK_REGISTRO  0
+
+// Microbenchmark de salidas: escritura por lotes en los registros de set/clear
+// contra gpio_set_level en un ciclo (no arranca las tareas)
+#define MODO_BENCHMARK_SALIDAS  0
+
+// Memoria estática: colas y tareas con las APIs ...Static y buffers reservados al
+// enlazar, sin heap ni caminos de error al crearlas (0 = memoria dinámica)
+#define MODO_ESTATICO  0
+
+// Perfil de pilas: mide la marca de agua de las tareas tras PERFIL_DURACION_MS e
+// imprime pilas_leds.h con lo usado más un margen. Si ese header está junto a este
+// archivo, sus tamaños reemplazan a los de por defecto (salvo al perfilar)
+#define MODO_PERFIL_PILAS  0
+
+#if __has_include("pilas_leds.h") && !MODO_PERFIL_PILAS
+#include "pilas_leds.h"
+#endif
+
+#if MODO_ESTATICO && !configSUPPORT_STATIC_ALLOCATION
+#error "MODO_ESTATICO requiere configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+// En el puerto Linux no hay sueño ligero; el modo solo aplica en el chip
+#define USAR_SUENO_LIGERO  (MODO_BAJO_CONSUMO && !CONFIG_IDF_TARGET_LINUX)
+
+#if USAR_SUENO_LIGERO && !(CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#error "MODO_BAJO_CONSUMO requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE"
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+// ============================================================================
+// CAPA DE SIMULACIÓN GPIO (puerto Linux de FreeRTOS, sin periféricos)
+// ============================================================================
+// Modelo mínimo en memoria del driver GPIO: un flanco escrito en un pin con
+// handler registrado invoca la ISR, igual que el lazo del pin en el chip.
+#include "esp_err.h"
+
+#include <time.h>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+#define ESP_INTR_FLAG_DEFAULT 0
+
+// Sin heap del chip que medir: el arranque reporta 0 B usados
+static inline uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+// Sin contador de ciclos en la PC: se usan nanosegundos del reloj monotónico
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+typedef enum {
+    GPIO_NUM_2 = 2, GPIO_NUM_4 = 4, GPIO_NUM_5 = 5,
+    GPIO_NUM_18 = 18, GPIO_NUM_19 = 19, GPIO_NUM_21 = 21,
+    GPIO_NUM_MAX = 40
+} gpio_num_t;
+typedef enum { GPIO_MODE_INPUT, GPIO_MODE_OUTPUT, GPIO_MODE_INPUT_OUTPUT_OD } gpio_mode_t;
+typedef enum { GPIO_PULLUP_DISABLE, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+typedef enum { GPIO_PULLDOWN_DISABLE, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+typedef enum { GPIO_INTR_DISABLE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE } gpio_int_type_t;
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+typedef void (*gpio_isr_t)(void *);
+
+static uint32_t sim_nivel_gpio[GPIO_NUM_MAX];   // Nivel actual de cada pin
+
+// Registro de salida de los GPIO 0-31: cada escritura al registro es un instante
+// en que cambian todos sus bits a la vez, y se guarda en la traza para verificar
+// que una actualización por lotes no deja ver estados intermedios
+#define GPIO_OUT_W1TS_REG     0
+#define GPIO_OUT_W1TC_REG     1
+#define SIM_TRAZA_SALIDA      8
+static uint32_t sim_registro_salida;
+static uint32_t sim_traza_salida[SIM_TRAZA_SALIDA];  // Estados del registro tras cada escritura
+static uint32_t sim_escrituras_salida;
+
+static void sim_registrar_salida(void)
+{
+    sim_traza_salida[sim_escrituras_salida % SIM_TRAZA_SALIDA] = sim_registro_salida;
+    sim_escrituras_salida++;
+}
+
+static void REG_WRITE(int registro, uint32_t valor)
+{
+    if(registro == GPIO_OUT_W1TS_REG) {
+        sim_registro_salida |= valor;
+    } else {
+        sim_registro_salida &= ~valor;
+    }
+    for(int pin = 0; pin < 32; pin++) {
+        if(valor & (1UL << pin)) {
+            sim_nivel_gpio[pin] = (sim_registro_salida >> pin) & 1;
+        }
+    }
+    sim_registrar_salida();
+}
+static gpio_int_type_t sim_intr_gpio[GPIO_NUM_MAX];  // Tipo de interrupción de cada pin
+static gpio_isr_t sim_isr_gpio[GPIO_NUM_MAX];    // Handler registrado por pin
+static void *sim_arg_isr_gpio[GPIO_NUM_MAX];     // Argumento del handler
+
+static esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    // Los pines con pull-up arrancan en alto (botón suelto)
+    for(int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if(cfg->pin_bit_mask & (1ULL << pin)) {
+            sim_intr_gpio[pin] = cfg->intr_type;
+            if(cfg->pull_up_en == GPIO_PULLUP_ENABLE) {
+                sim_nivel_gpio[pin] = 1;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t tipo)
+{
+    sim_intr_gpio[pin] = tipo;
+    return ESP_OK;
+}
+
+static int gpio_get_level(gpio_num_t pin)
+{
+    return sim_nivel_gpio[pin];
+}
+
+static esp_err_t gpio_set_level(gpio_num_t pin, uint32_t nivel)
+{
+    bool flanco_bajada = sim_nivel_gpio[pin] && !nivel;
+    bool cambio = sim_nivel_gpio[pin] != nivel;
+    sim_nivel_gpio[pin] = nivel;
+    if(pin < 32) {
+        // El driver escribe un pin por llamada: un estado del registro por pin
+        sim_registro_salida = (sim_registro_salida & ~(1UL << pin)) | ((uint32_t)(nivel != 0) << pin);
+        sim_registrar_salida();
+    }
+    bool dispara = (sim_intr_gpio[pin] == GPIO_INTR_NEGEDGE && flanco_bajada) ||
+                   (sim_intr_gpio[pin] == GPIO_INTR_ANYEDGE && cambio);
+    if(dispara && sim_isr_gpio[pin] != NULL) {
+        sim_isr_gpio[pin](sim_arg_isr_gpio[pin]);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t gpio_install_isr_service(int flags)
+{
+    return ESP_OK;
+}
+
+static esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t isr, void *arg)
+{
+    sim_isr_gpio[pin] = isr;
+    sim_arg_isr_gpio[pin] = arg;
+    return ESP_OK;
+}
+
+// Modelo del periférico LEDC: guarda la forma de onda programada en cada canal
+// para que la simulación la verifique sin silicio. Valida el divisor igual que
+// el chip (entero de 10 bits) con el reloj APB de 80 MHz
+#define APB_CLK_FREQ                 80000000
+#define SOC_CLK_RC_FAST_FREQ_APPROX  8500000
+#define LEDC_TIMER_BIT_MAX           21
+#define SIM_LEDC_TIMERS              4
+#define LEDC_TIMER_MAX               SIM_LEDC_TIMERS
+#define SIM_LEDC_CANALES             8
+
+typedef enum { LEDC_LOW_SPEED_MODE } ledc_mode_t;
+typedef int ledc_timer_t;
+typedef int ledc_channel_t;
+typedef uint32_t ledc_timer_bit_t;
+typedef enum { LEDC_USE_APB_CLK, LEDC_USE_RC_FAST_CLK } ledc_clk_cfg_t;
+typedef enum { LEDC_INTR_DISABLE } ledc_intr_type_t;
+typedef struct {
+    ledc_mode_t speed_mode;
+    ledc_timer_bit_t duty_resolution;
+    ledc_timer_t timer_num;
+    uint32_t freq_hz;
+    ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+typedef struct {
+    int gpio_num;
+    ledc_mode_t speed_mode;
+    ledc_channel_t channel;
+    ledc_intr_type_t intr_type;
+    ledc_timer_t timer_sel;
+    uint32_t duty;
+    int hpoint;
+} ledc_channel_config_t;
+
+static struct {
+    uint32_t freq_hz;
+    uint32_t resolucion;
+} sim_ledc_timer[SIM_LEDC_TIMERS];
+
+static struct {
+    int gpio;
+    ledc_timer_t timer;
+    uint32_t duty;              // Duty programado (en cuentas de la resolución del timer)
+    bool salida_activa;         // false después de ledc_stop
+    uint32_t nivel_reposo;      // Nivel fijo del pin con la salida detenida
+    uint32_t programaciones;    // Escrituras al periférico (costo de CPU del backend)
+} sim_ledc[SIM_LEDC_CANALES];
+
+static esp_err_t ledc_timer_config(const ledc_timer_config_t *cfg)
+{
+    uint64_t divisor = APB_CLK_FREQ / ((uint64_t) cfg->freq_hz << cfg->duty_resolution);
+    if(cfg->duty_resolution >= LEDC_TIMER_BIT_MAX || divisor < 1 || divisor > 1023) {
+        return ESP_FAIL;
+    }
+    sim_ledc_timer[cfg->timer_num].freq_hz = cfg->freq_hz;
+    sim_ledc_timer[cfg->timer_num].resolucion = cfg->duty_resolution;
+    return ESP_OK;
+}
+
+static esp_err_t ledc_channel_config(const ledc_channel_config_t *cfg)
+{
+    sim_ledc[cfg->channel].gpio = cfg->gpio_num;
+    sim_ledc[cfg->channel].timer = cfg->timer_sel;
+    sim_ledc[cfg->channel].duty = cfg->duty;
+    sim_ledc[cfg->channel].salida_activa = true;
+    sim_ledc[cfg->channel].programaciones++;
+    return ESP_OK;
+}
+
+static esp_err_t ledc_set_freq(ledc_mode_t modo, ledc_timer_t timer, uint32_t freq_hz)
+{
+    uint64_t divisor = APB_CLK_FREQ / ((uint64_t) freq_hz << sim_ledc_timer[timer].resolucion);
+    if(divisor < 1 || divisor > 1023) {
+        return ESP_FAIL;
+    }
+    sim_ledc_timer[timer].freq_hz = freq_hz;
+    return ESP_OK;
+}
+
+static uint32_t ledc_get_freq(ledc_mode_t modo, ledc_timer_t timer)
+{
+    return sim_ledc_timer[timer].freq_hz;
+}
+
+static esp_err_t ledc_timer_rst(ledc_mode_t modo, ledc_timer_t timer)
+{
+    return ESP_OK;
+}
+
+static esp_err_t ledc_set_duty(ledc_mode_t modo, ledc_channel_t canal, uint32_t duty)
+{
+    sim_ledc[canal].duty = duty;
+    return ESP_OK;
+}
+
+static uint32_t ledc_get_duty(ledc_mode_t modo, ledc_channel_t canal)
+{
+    return sim_ledc[canal].duty;
+}
+
+static esp_err_t ledc_update_duty(ledc_mode_t modo, ledc_channel_t canal)
+{
+    sim_ledc[canal].salida_activa = true;
+    sim_ledc[canal].programaciones++;
+    return ESP_OK;
+}
+
+static esp_err_t ledc_stop(ledc_mode_t modo, ledc_channel_t canal, uint32_t nivel_reposo)
+{
+    sim_ledc[canal].salida_activa = false;
+    sim_ledc[canal].nivel_reposo = nivel_reposo;
+    sim_ledc[canal].programaciones++;
+    sim_nivel_gpio[sim_ledc[canal].gpio] = nivel_reposo;
+    return ESP_OK;
+}
+#else
+#include "esp_attr.h"                 // IRAM_ATTR y DRAM_ATTR para la ISR y sus tablas
+#include "driver/gpio.h"              // Driver GPIO del ESP-IDF
+#include "driver/ledc.h"              // PWM por hardware para los parpadeos periódicos
+#include "soc/soc.h"                  // Frecuencia del reloj APB
+#include "soc/clk_tree_defs.h"        // Frecuencia aproximada de RC_FAST
+#include "soc/gpio_reg.h"             // Registros de set/clear de las salidas
+#include "esp_cpu.h"                  // Contador de ciclos para el benchmark
+#if USAR_SUENO_LIGERO
+#include "esp_pm.h"                   // Gestión de energía (sueño ligero automático)
+#include "esp_sleep.h"                // Fuentes de despertar
+#endif
+#endif
 
 // Definición de etiqueta para logging
 static const char *TAG = "GPIO_INTERRUPT_DEMO";
 
+#if MODO_REGISTRO_DIFERIDO || MODO_BENCHMARK_REGISTRO
+// Registro diferido: anillos por núcleo y tarea de drenado en registro_diferido.h
+#ifndef PILA_DRENADO
+#define PILA_DRENADO         3072
+#endif
+#include "registro_diferido.h"
+#endif
+
+// Logs de los lazos: al anillo con MODO_REGISTRO_DIFERIDO, si no directo a la UART
+#if MODO_REGISTRO_DIFERIDO
+#define LOGI_DIFERIDO(formato, ...)  REGISTRAR_DIFERIDO(formato, __VA_ARGS__)
+#else
+#define LOGI_DIFERIDO(formato, ...)  ESP_LOGI(TAG, formato, __VA_ARGS__)
+#endif
+
+// Tiempo de arranque: marcar_primera_tarea en arranque.h
+#include "arranque.h"
+
 // Definición de pines para LEDs (salidas)
 #define LED_ROJO_PIN     GPIO_NUM_2
 #define LED_AMARILLO_PIN GPIO_NUM_4
 #define LED_VERDE_PIN    GPIO_NUM_5
 
-// Definición de pines para botones (entradas con interrupciones)
-#define BOTON_1_PIN      GPIO_NUM_18
-#define BOTON_2_PIN      GPIO_NUM_19
-#define BOTON_3_PIN      GPIO_NUM_21
+// Definición de pines para botones (entradas con interrupciones)
+#define BOTON_1_PIN      GPIO_NUM_18
+#define BOTON_2_PIN      GPIO_NUM_19
+#define BOTON_3_PIN      GPIO_NUM_21
+
+// Máscara de bits para configuración GPIO de salida
+#define GPIO_OUTPUT_PIN_SEL ((1ULL<<LED_ROJO_PIN) | (1ULL<<LED_AMARILLO_PIN) | (1ULL<<LED_VERDE_PIN))
+_Static_assert(GPIO_OUTPUT_PIN_SEL < (1ULL << 32), "escribir_leds usa los registros de los GPIO 0-31");
+
+// LEDs que se escriben por registro; los pines conectados a un periférico (LEDC)
+// se quitan en configurar_salidas_led porque su nivel ya no lo da el registro
+static uint32_t mascara_leds_registro = (uint32_t) GPIO_OUTPUT_PIN_SEL;
+
+/**
+ * Actualiza varios LEDs en una sola operación
+ * Los bits que se encienden se escriben de una vez en W1TS y los que se apagan
+ * en W1TC: todos los LEDs que cambian en la misma dirección lo hacen en el mismo
+ * instante, sin leer y reescribir el registro (no pisa pines de otras tareas)
+ * 
+ * @param mascara: LEDs a actualizar (bits de GPIO_OUTPUT_PIN_SEL)
+ * @param valor: Nivel de cada LED de la máscara
+ */
+static inline void IRAM_ATTR escribir_leds(uint32_t mascara, uint32_t valor)
+{
+    mascara &= mascara_leds_registro;
+    uint32_t encender = mascara & valor;
+    uint32_t apagar = mascara & ~valor;
+    if(encender) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, encender);
+    }
+    if(apagar) {
+        REG_WRITE(GPIO_OUT_W1TC_REG, apagar);
+    }
+}
+
+// La máscara de entradas se arma a partir de config_botones (ver motor de anti-rebote)
+
+// Definición de eventos para la cola de interrupciones
+typedef enum {
+    EVENTO_BOTON_1 = 1,    // Evento del botón 1
+    EVENTO_BOTON_2,        // Evento del botón 2
+    EVENTO_BOTON_3         // Evento del botón 3
+} evento_interrupcion_t;
+
+// Gesto de cada evento. Sin MODO_GESTOS todo evento es GESTO_PRESION y se entrega
+// en cuanto se acepta el flanco de presión
+typedef enum {
+    GESTO_PRESION,      // Presión sin clasificar
+    GESTO_CORTO,        // Presión corta sin segunda presión dentro de la ventana de doble clic
+    GESTO_LARGO,        // La presión llegó al umbral largo (se emite sin esperar a soltar)
+    GESTO_DOBLE,        // Segunda presión corta dentro de la ventana de doble clic
+    GESTO_REPETICION,   // Cada periodo de repetición mientras sigue presionado después del largo
+    NUM_GESTOS
+} tipo_gesto_t;
+
+// Evento que viaja por las colas: ocupa lo mismo que el enum al que reemplaza
+typedef struct {
+    uint8_t evento;         // Botón (evento_interrupcion_t)
+    uint8_t gesto;          // tipo_gesto_t
+    uint16_t duracion_ms;   // Tiempo presionado al emitir el gesto (satura en 65535)
+} evento_boton_t;
+_Static_assert(sizeof(evento_boton_t) == sizeof(uint32_t), "evento_boton_t debe seguir ocupando 4 bytes");
+
+#define EVENTO_PRESION(evento)  ((evento_boton_t) { (evento), GESTO_PRESION, 0 })
+
+// Número de botones/LEDs; cada evento se indexa como (evento - 1)
+#define NUM_BOTONES          3
+#define PROFUNDIDAD_COLA_LED 10
+
+// Bit de notificación asociado a cada botón
+#define BIT_BOTON(indice)    (1UL << (indice))
+
+// Tareas que consumen eventos de botón y tamaño de pila de cada una
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+#define NUM_TAREAS_LED       1   // El motor de patrones atiende todos los botones
+#else
+#define NUM_TAREAS_LED       NUM_BOTONES
+#endif
+#ifndef PILA_TAREA_LED
+#define PILA_TAREA_LED       2048
+#endif
+#define PRIORIDAD_TAREA_LED  10
+
+// Variables globales
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+// Cada LED tiene su propia cola: la ISR enruta el evento directamente a su dueño,
+// así ninguna tarea consume (y descarta) eventos que pertenecen a otro LED.
+// Con el motor de patrones todas las entradas apuntan a la única cola del planificador
+static QueueHandle_t colas_led[NUM_BOTONES] = {NULL};
+#else
+// Presiones pendientes por botón: la notificación solo despierta a la tarea, el
+// contador evita que dos presiones seguidas se fusionen en un solo bit
+static volatile uint32_t presiones_pendientes[NUM_BOTONES];
+#endif
+static TaskHandle_t tareas_led[NUM_BOTONES] = {NULL};  // Tarea dueña de cada botón
+#if MODO_LEDS == LEDS_TAREA_POR_LED
+static bool led_amarillo_parpadeando = false;   // Estado del parpadeo LED amarillo
+static const uint32_t PERIODO_PARPADEO_MS = 500;  // Medio periodo del parpadeo amarillo
+static bool secuencia_verde_activa = false;     // Estado de secuencia LED verde
+#endif
+
+// ============================================================================
+// MOTOR DE ANTI-REBOTE (DEBOUNCE)
+// ============================================================================
+
+// Estrategia de anti-rebote de cada entrada
+typedef enum {
+    ANTIRREBOTE_FLANCO,         // Acepta el primer flanco e ignora los siguientes durante la ventana
+    ANTIRREBOTE_ASENTAMIENTO    // Acepta cuando la línea lleva la ventana completa sin cambiar
+} modo_antirrebote_t;
+
+// Configuración de cada entrada: agregar un botón es agregar una fila
+typedef struct {
+    gpio_num_t pin;                 // Pin de entrada
+    evento_interrupcion_t evento;   // Evento que genera (LED dueño)
+    uint32_t ventana_us;            // Ventana de anti-rebote en microsegundos
+    modo_antirrebote_t modo;        // Estrategia de anti-rebote
+} config_boton_t;
+
+// En DRAM, como ranura_por_pin: la ISR la lee aunque la caché de flash esté deshabilitada
+static const DRAM_ATTR config_boton_t config_botones[] = {
+#if MODO_SIMULACION
+    // Los pulsos simulados no rebotan: se aceptan todos
+    { BOTON_1_PIN, EVENTO_BOTON_1, 0, ANTIRREBOTE_FLANCO },
+    { BOTON_2_PIN, EVENTO_BOTON_2, 0, ANTIRREBOTE_FLANCO },
+    { BOTON_3_PIN, EVENTO_BOTON_3, 0, ANTIRREBOTE_FLANCO },
+#elif MODO_GESTOS
+    // Los gestos miden la duración de la presión: necesitan los dos flancos asentados
+    { BOTON_1_PIN, EVENTO_BOTON_1, 20000, ANTIRREBOTE_ASENTAMIENTO },
+    { BOTON_2_PIN, EVENTO_BOTON_2, 20000, ANTIRREBOTE_ASENTAMIENTO },
+    { BOTON_3_PIN, EVENTO_BOTON_3, 20000, ANTIRREBOTE_ASENTAMIENTO },
+#else
+    { BOTON_1_PIN, EVENTO_BOTON_1, 200000, ANTIRREBOTE_FLANCO },
+    { BOTON_2_PIN, EVENTO_BOTON_2, 200000, ANTIRREBOTE_FLANCO },
+    { BOTON_3_PIN, EVENTO_BOTON_3,  20000, ANTIRREBOTE_ASENTAMIENTO },
+#endif
+};
+#define NUM_ENTRADAS (sizeof(config_botones) / sizeof(config_botones[0]))
+_Static_assert(NUM_ENTRADAS <= 127, "ranura_por_pin guarda la ranura en un int8_t");
+
+// Estado de anti-rebote de cada entrada (una ranura por pin configurado)
+typedef struct {
+    int64_t ultimo_aceptado_us;         // Flanco: instante de la última presión aceptada
+    bool presionado_estable;            // Asentamiento: último nivel estable aceptado
+    esp_timer_handle_t temporizador;    // Asentamiento: vence cuando la línea lleva la ventana quieta
+#if MODO_GESTOS
+    uint32_t cambio_us;                 // Asentamiento: instante del último cambio de la línea
+#endif
+} estado_boton_t;
+
+static estado_boton_t estado_botones[NUM_ENTRADAS];
+
+// Tabla indexada por número de pin que consulta la ISR: ranura del pin en
+// config_botones o -1 si el pin no es una entrada. Se llena al registrar las
+// entradas y, al no ser const, queda en DRAM como config_botones
+static int8_t ranura_por_pin[GPIO_NUM_MAX];
+
+/**
+ * Anti-rebote por flanco
+ * Se acepta el flanco si pasó la ventana completa desde la última presión aceptada
+ * 
+ * @param estado: Estado de la entrada
+ * @param config: Configuración de la entrada
+ * @param ahora_us: Instante del flanco en microsegundos
+ * @return true si el flanco es una presión válida
+ */
+static inline bool IRAM_ATTR antirrebote_flanco(estado_boton_t *estado, const config_boton_t *config,
+                                                int64_t ahora_us)
+{
+    if(ahora_us - estado->ultimo_aceptado_us >= config->ventana_us) {
+        estado->ultimo_aceptado_us = ahora_us;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Anti-rebote por asentamiento
+ * Se llama cuando la línea lleva la ventana completa sin cambios. Solo el paso
+ * de suelto a presionado genera una presión.
+ * 
+ * @param estado: Estado de la entrada
+ * @param presionado: Nivel estable de la línea (true = presionado)
+ * @return true si el nivel estable es una nueva presión
+ */
+static inline bool antirrebote_asentar(estado_boton_t *estado, bool presionado)
+{
+    bool nueva_presion = presionado && !estado->presionado_estable;
+    estado->presionado_estable = presionado;
+    return nueva_presion;
+}
+
+#if MODO_GESTOS || MODO_PRUEBA_GESTOS
+// ============================================================================
+// MÁQUINA DE GESTOS
+// ============================================================================
+// Recibe los cambios asentados de la línea (presión y liberación con su instante)
+// y el vencimiento de su plazo, y emite gestos. No usa tareas ni sondeo: el
+// temporizador de cada botón solo se arma mientras hay un plazo pendiente.
+// Los instantes son uint32_t en microsegundos: se leen y escriben de una vez y
+// las restas siguen siendo correctas cuando el contador da la vuelta (~71 min).
+
+// Umbrales de los gestos
+typedef struct {
+    uint32_t largo_us;                  // Presión larga a partir de este tiempo presionado
+    uint32_t ventana_doble_us;          // Espera de la segunda presión (0 = sin doble clic)
+    uint32_t periodo_repeticion_us;     // Repetición después del largo (0 = sin repetición)
+} config_gestos_t;
+
+static const config_gestos_t config_gestos = { 600000, 300000, 150000 };
+
+typedef enum {
+    FASE_REPOSO,
+    FASE_PRESIONADO,    // Primera presión, antes del umbral largo
+    FASE_ESPERA_DOBLE,  // Soltó una presión corta y espera la segunda
+    FASE_SEGUNDA,       // Segunda presión dentro de la ventana
+    FASE_MANTENIDO      // Pasó el umbral largo; repite mientras siga presionado
+} fase_gesto_t;
+
+// Estado de gestos de un botón
+typedef struct {
+    uint8_t fase;           // fase_gesto_t
+    bool con_plazo;         // Hay un vencimiento pendiente en plazo_us
+    uint32_t plazo_us;      // Vencimiento absoluto de la fase actual
+    uint32_t presion_us;    // Instante de la presión en curso
+    uint32_t primera_us;    // Duración de la primera presión mientras se espera el doble clic
+} estado_gesto_t;
+
+// Un vencimiento puede cerrar un clic pendiente y emitir un largo a la vez
+#define MAX_GESTOS_POR_PASO  2
+
+static inline void emitir_gesto(evento_boton_t *salida, int *n, tipo_gesto_t gesto, uint32_t duracion_us)
+{
+    uint32_t ms = duracion_us / 1000;
+    salida[*n].gesto = gesto;
+    salida[*n].duracion_ms = ms > UINT16_MAX ? UINT16_MAX : ms;
+    (*n)++;
+}
+
+/**
+ * Aplica un cambio asentado de la línea a la máquina de gestos
+ * 
+ * @param g: Estado de gestos del botón
+ * @param cfg: Umbrales de los gestos
+ * @param presionado: Nivel nuevo de la línea (true = presionado)
+ * @param t_us: Instante del cambio
+ * @param salida: Gestos emitidos (gesto y duración; el botón lo pone quien entrega)
+ * @return Número de gestos emitidos
+ */
+static int gesto_cambio(estado_gesto_t *g, const config_gestos_t *cfg, bool presionado,
+                        uint32_t t_us, evento_boton_t salida[MAX_GESTOS_POR_PASO])
+{
+    int n = 0;
+    
+    if(presionado) {
+        if(g->fase == FASE_REPOSO || g->fase == FASE_ESPERA_DOBLE) {
+            g->fase = (g->fase == FASE_REPOSO) ? FASE_PRESIONADO : FASE_SEGUNDA;
+            g->presion_us = t_us;
+            g->plazo_us = t_us + cfg->largo_us;
+            g->con_plazo = true;
+        }
+        return n;
+    }
+    
+    uint32_t duracion_us = t_us - g->presion_us;
+    if(g->fase == FASE_PRESIONADO && cfg->ventana_doble_us > 0) {
+        // Todavía puede ser la primera mitad de un doble clic
+        g->fase = FASE_ESPERA_DOBLE;
+        g->primera_us = duracion_us;
+        g->plazo_us = t_us + cfg->ventana_doble_us;
+        return n;
+    }
+    if(g->fase == FASE_PRESIONADO) {
+        emitir_gesto(salida, &n, GESTO_CORTO, duracion_us);
+    } else if(g->fase == FASE_SEGUNDA) {
+        emitir_gesto(salida, &n, GESTO_DOBLE, duracion_us);
+    } else if(g->fase != FASE_MANTENIDO) {
+        return n;   // Liberación sin presión registrada (la línea arrancó presionada)
+    }
+    // Al soltar un largo no se emite nada: el largo y las repeticiones ya salieron
+    g->fase = FASE_REPOSO;
+    g->con_plazo = false;
+    return n;
+}
+
+/**
+ * Atiende el vencimiento del plazo de la máquina de gestos
+ * Ignora la llamada si el plazo ya no está vigente (el temporizador venció
+ * justo cuando un cambio lo reprogramaba)
+ * 
+ * @param g: Estado de gestos del botón
+ * @param cfg: Umbrales de los gestos
+ * @param t_us: Instante actual
+ * @param salida: Gestos emitidos (gesto y duración; el botón lo pone quien entrega)
+ * @return Número de gestos emitidos
+ */
+static int gesto_vencimiento(estado_gesto_t *g, const config_gestos_t *cfg, uint32_t t_us,
+                             evento_boton_t salida[MAX_GESTOS_POR_PASO])
+{
+    int n = 0;
+    
+    if(!g->con_plazo || (int32_t)(t_us - g->plazo_us) < 0) {
+        return n;
+    }
+    
+    if(g->fase == FASE_ESPERA_DOBLE) {
+        // No llegó la segunda presión: era un clic corto
+        emitir_gesto(salida, &n, GESTO_CORTO, g->primera_us);
+        g->fase = FASE_REPOSO;
+        g->con_plazo = false;
+        return n;
+    }
+    
+    if(g->fase == FASE_MANTENIDO) {
+        emitir_gesto(salida, &n, GESTO_REPETICION, t_us - g->presion_us);
+    } else {
+        if(g->fase == FASE_SEGUNDA) {
+            // Clic seguido de una presión larga: el primero fue un clic corto
+            emitir_gesto(salida, &n, GESTO_CORTO, g->primera_us);
+        }
+        emitir_gesto(salida, &n, GESTO_LARGO, t_us - g->presion_us);
+        g->fase = FASE_MANTENIDO;
+    }
+    
+    // La siguiente repetición se cuenta desde el plazo, no desde t_us: el retraso
+    // del temporizador no se acumula
+    g->plazo_us += cfg->periodo_repeticion_us;
+    g->con_plazo = cfg->periodo_repeticion_us > 0;
+    return n;
+}
+#endif
+
+// Contadores de entrega por botón (la ISR, el temporizador de asentamiento y la tarea dueña)
+static volatile uint32_t eventos_entregados[NUM_BOTONES];   // Entregados al LED
+static volatile uint32_t eventos_desbordados[NUM_BOTONES];  // Rechazados por cola llena
+static volatile uint32_t eventos_procesados[NUM_BOTONES];   // Consumidos por la tarea del LED
+
+// Despertares de cada tarea de LED: totales y ociosos (despertó sin evento ni cambio
+// programado del LED). Con tareas dirigidas por eventos los ociosos deben quedar en 0
+static volatile uint32_t despertares[NUM_TAREAS_LED];
+static volatile uint32_t despertares_ociosos[NUM_TAREAS_LED];
+
+// Error de cada cambio de LED respecto de su instante ideal en microsegundos
+// (positivo = tarde). Se mide igual en los dos diseños para poder compararlos
+typedef struct {
+    uint32_t muestras;
+    int32_t minimo_us;
+    int32_t maximo_us;
+    int64_t suma_abs_us;
+} estadistica_jitter_t;
+
+static void registrar_jitter(estadistica_jitter_t *j, int64_t error_us)
+{
+    if(j->muestras == 0 || error_us < j->minimo_us) j->minimo_us = (int32_t) error_us;
+    if(j->muestras == 0 || error_us > j->maximo_us) j->maximo_us = (int32_t) error_us;
+    j->suma_abs_us += error_us < 0 ? -error_us : error_us;
+    j->muestras++;
+}
+
+static void imprimir_jitter(const char *nombre, const estadistica_jitter_t *j)
+{
+    if(j->muestras > 0) {
+        ESP_LOGI(TAG, "Jitter LED %s: min=%ld prom|e|=%ld max=%ld us (%" PRIu32 " cambios)", nombre,
+                 (long) j->minimo_us, (long)(j->suma_abs_us / j->muestras),
+                 (long) j->maximo_us, j->muestras);
+    }
+}
+
+#if MODO_BENCHMARK_ISR
+// Estadística simple en ciclos de CPU
+typedef struct {
+    uint32_t muestras;
+    uint32_t minimo;
+    uint32_t maximo;
+    uint64_t suma;
+} estadistica_ciclos_t;
+
+static estadistica_ciclos_t duracion_isr;                     // Solo la escribe la ISR
+static estadistica_ciclos_t latencia_despertar[NUM_BOTONES];  // Solo la escribe la tarea dueña
+
+static inline void IRAM_ATTR registrar_ciclos(estadistica_ciclos_t *e, uint32_t ciclos)
+{
+    if(e->muestras == 0 || ciclos < e->minimo) e->minimo = ciclos;
+    if(ciclos > e->maximo) e->maximo = ciclos;
+    e->suma += ciclos;
+    e->muestras++;
+}
+#endif
+
+#if MODO_BENCHMARK_ISR || MODO_BENCHMARK_LATENCIA
+static volatile uint32_t ciclo_entrada_isr[NUM_BOTONES];      // Ciclo de entrada de la última ISR aceptada
+#endif
+
+#if MODO_BENCHMARK_LATENCIA
+// Muestras por escenario de carga y tramos medidos de cada una
+#define BENCH_LAT_PULSOS  500
+
+typedef enum {
+    TRAMO_DESPERTAR,    // Entrada de la ISR -> la tarea recibe el evento
+    TRAMO_PROCESO,      // Recepción -> escritura del LED
+    TRAMO_TOTAL,        // Entrada de la ISR -> escritura del LED
+    NUM_TRAMOS
+} tramo_latencia_t;
+
+static uint32_t lat_muestras[NUM_TRAMOS][BENCH_LAT_PULSOS];  // En ciclos
+static volatile uint32_t lat_num_muestras;
+static uint32_t lat_ciclo_recepcion;    // Lo escribe y lo lee solo la tarea del LED rojo
+
+/**
+ * Marca que la tarea del LED rojo recibió el evento del botón 1
+ */
+static inline void marcar_recepcion_latencia(void)
+{
+    lat_ciclo_recepcion = esp_cpu_get_cycle_count();
+}
+
+/**
+ * Registra una muestra al escribir el LED rojo
+ * Con el inyector en ping-pong solo hay un evento en vuelo, así que las tres
+ * marcas corresponden a la misma presión
+ */
+static void registrar_latencia_led(void)
+{
+    uint32_t ahora = esp_cpu_get_cycle_count();
+    uint32_t n = lat_num_muestras;
+    if(n >= BENCH_LAT_PULSOS) {
+        return;
+    }
+    uint32_t isr = ciclo_entrada_isr[EVENTO_BOTON_1 - 1];
+    lat_muestras[TRAMO_DESPERTAR][n] = lat_ciclo_recepcion - isr;
+    lat_muestras[TRAMO_PROCESO][n] = ahora - lat_ciclo_recepcion;
+    lat_muestras[TRAMO_TOTAL][n] = ahora - isr;
+    lat_num_muestras = n + 1;
+}
+#endif
+
+#if MODO_SIMULACION
+// En simulación los patrones se aceleran para poder inyectar miles de eventos
+#define ESCALA_TIEMPO_PATRONES 100
+#else
+#define ESCALA_TIEMPO_PATRONES 1
+#endif
+
+/**
+ * Entrega un evento a la tarea dueña desde la ISR
+ * Según MODO_ENTREGA_ISR usa la cola del LED o una notificación directa con el
+ * bit del botón. No copia más que el evento ni reserva memoria.
+ * 
+ * @param evento: Evento a entregar
+ * @param xHigherPriorityTaskWoken: Se pone en pdTRUE si se despertó una tarea de mayor prioridad
+ */
+static inline void IRAM_ATTR entregar_evento_desde_isr(evento_interrupcion_t evento,
+                                                       BaseType_t *xHigherPriorityTaskWoken)
+{
+    int indice = evento - 1;
+    
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+    // xQueueSendFromISR es la versión thread-safe para usar en ISRs
+    evento_boton_t item = EVENTO_PRESION(evento);
+    if(xQueueSendFromISR(colas_led[indice], &item, xHigherPriorityTaskWoken) == pdTRUE) {
+        __atomic_fetch_add(&eventos_entregados[indice], 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&eventos_desbordados[indice], 1, __ATOMIC_RELAXED);
+    }
+#else
+    TaskHandle_t tarea = tareas_led[indice];
+    if(tarea == NULL) {
+        return;  // La tarea dueña todavía no se ha creado
+    }
+    
+    // Cuenta la presión antes de notificar para que la tarea nunca la pierda
+    __atomic_fetch_add(&presiones_pendientes[indice], 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&eventos_entregados[indice], 1, __ATOMIC_RELAXED);
+    xTaskNotifyFromISR(tarea, BIT_BOTON(indice), eSetBits, xHigherPriorityTaskWoken);
+#endif
+}
+
+/**
+ * Entrega un evento a la tarea dueña desde una tarea
+ * Lo usan el temporizador de asentamiento y la máquina de gestos, que corren en
+ * la tarea de esp_timer
+ * 
+ * @param evento: Evento a entregar (botón, gesto y duración)
+ */
+static void entregar_evento(evento_boton_t evento)
+{
+    int indice = evento.evento - 1;
+    
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+    if(xQueueSend(colas_led[indice], &evento, 0) == pdTRUE) {
+        __atomic_fetch_add(&eventos_entregados[indice], 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&eventos_desbordados[indice], 1, __ATOMIC_RELAXED);
+    }
+#else
+    if(tareas_led[indice] == NULL) {
+        return;  // La tarea dueña todavía no se ha creado
+    }
+    __atomic_fetch_add(&presiones_pendientes[indice], 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&eventos_entregados[indice], 1, __ATOMIC_RELAXED);
+    xTaskNotify(tareas_led[indice], BIT_BOTON(indice), eSetBits);
+#endif
+}
+
+#if USAR_SUENO_LIGERO
+/**
+ * Detección de flancos con interrupciones por nivel
+ * En sueño ligero el ESP32 solo despierta por nivel, no por flanco. Cada vez que
+ * entra la ISR se invierte el nivel esperado del pin: en bajo se espera la
+ * liberación (alto) y en alto se vuelve a esperar una presión (bajo).
+ * El servicio de ISR se instala sin ESP_INTR_FLAG_IRAM, por eso puede llamar al driver.
+ * 
+ * @param gpio_num: Pin que generó la interrupción
+ * @return true si fue una presión (el pin está en bajo)
+ */
+static bool IRAM_ATTR flanco_por_nivel(uint32_t gpio_num)
+{
+    bool presionado = gpio_get_level(gpio_num) == 0;
+    gpio_wakeup_enable(gpio_num, presionado ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    return presionado;
+}
+#endif
+
+/**
+ * Rutina de Servicio de Interrupción (ISR) para GPIO
+ * Esta función se ejecuta cuando ocurre una interrupción en cualquier GPIO configurado
+ * Busca la entrada en la tabla indexada por pin, aplica su anti-rebote con marcas
+ * de tiempo en microsegundos y entrega el evento al LED dueño del botón
+ * 
+ * @param arg: Argumento pasado durante la instalación del ISR (número de pin)
+ */
+static void IRAM_ATTR gpio_isr_handler(void* arg)
+{
+#if MODO_BENCHMARK_ISR || MODO_BENCHMARK_LATENCIA
+    uint32_t ciclo_entrada = esp_cpu_get_cycle_count();
+#endif
+    // Convierte el argumento a número de GPIO y busca su ranura
+    uint32_t gpio_num = (uint32_t) arg;
+    int ranura = ranura_por_pin[gpio_num];
+    if(ranura < 0) {
+        return;  // Pin no reconocido, salir de la ISR
+    }
+    
+    const config_boton_t *config = &config_botones[ranura];
+    estado_boton_t *estado = &estado_botones[ranura];
+    
+#if USAR_SUENO_LIGERO
+    bool presionado = flanco_por_nivel(gpio_num);
+#else
+    bool presionado = true;  // Las entradas por flanco solo interrumpen al presionar
+#endif
+    
+    if(config->modo == ANTIRREBOTE_ASENTAMIENTO) {
+#if MODO_GESTOS
+        // Instante exacto del flanco; el asentamiento lo entrega a los gestos al vencer
+        estado->cambio_us = (uint32_t) esp_timer_get_time();
+#endif
+        // Cada cambio de la línea reinicia la ventana; el temporizador decide al vencer
+        esp_timer_stop(estado->temporizador);
+        esp_timer_start_once(estado->temporizador, config->ventana_us);
+        return;
+    }
+    
+    // Obtiene el tiempo actual en microsegundos (desde el arranque del sistema)
+    int64_t ahora_us = esp_timer_get_time();
+    
+    // Implementación de anti-rebote: verifica si ha pasado suficiente tiempo
+    if(presionado && antirrebote_flanco(estado, config, ahora_us)) {
+        
+#if MODO_BENCHMARK_ISR || MODO_BENCHMARK_LATENCIA
+        // Antes de entregar: la tarea puede correr en otro núcleo en cuanto recibe
+        ciclo_entrada_isr[config->evento - 1] = ciclo_entrada;
+#endif
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        entregar_evento_desde_isr(config->evento, &xHigherPriorityTaskWoken);
+        
+#if MODO_BENCHMARK_ISR
+        registrar_ciclos(&duracion_isr, esp_cpu_get_cycle_count() - ciclo_entrada);
+#endif
+        
+        // Si una tarea de mayor prioridad fue desbloqueada, forzar cambio de contexto
+        if(xHigherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+    // Si no ha pasado suficiente tiempo, la interrupción se ignora (anti-rebote)
+}
+
+#if MODO_GESTOS
+// Estado de gestos y temporizador de plazo de cada entrada. Solo los tocan los
+// callbacks de esp_timer, que corren uno a la vez en la misma tarea: sin bloqueos
+static estado_gesto_t estado_gestos[NUM_ENTRADAS];
+static esp_timer_handle_t temporizadores_gesto[NUM_ENTRADAS];
+
+/**
+ * Entrega los gestos emitidos por una entrada y reprograma su plazo
+ * 
+ * @param ranura: Ranura de la entrada en config_botones
+ * @param gestos: Gestos emitidos por la máquina
+ * @param n: Número de gestos
+ */
+static void entregar_gestos(int ranura, evento_boton_t *gestos, int n)
+{
+    const estado_gesto_t *g = &estado_gestos[ranura];
+    
+    for(int i = 0; i < n; i++) {
+        gestos[i].evento = config_botones[ranura].evento;
+        entregar_evento(gestos[i]);
+    }
+    
+    esp_timer_stop(temporizadores_gesto[ranura]);
+    if(g->con_plazo) {
+        int32_t restante = (int32_t)(g->plazo_us - (uint32_t) esp_timer_get_time());
+        esp_timer_start_once(temporizadores_gesto[ranura], restante > 0 ? restante : 1);
+    }
+}
+
+/**
+ * Callback del plazo de gestos (umbral largo, ventana de doble clic o repetición)
+ * 
+ * @param arg: Ranura de la entrada en config_botones
+ */
+static void temporizador_gesto_cb(void *arg)
+{
+    int ranura = (int)(intptr_t) arg;
+    evento_boton_t gestos[MAX_GESTOS_POR_PASO];
+    int n = gesto_vencimiento(&estado_gestos[ranura], &config_gestos,
+                              (uint32_t) esp_timer_get_time(), gestos);
+    entregar_gestos(ranura, gestos, n);
+}
+#endif
+
+/**
+ * Callback del temporizador de asentamiento
+ * Vence cuando la línea lleva la ventana completa sin cambiar; lee el nivel
+ * estable y, si es una nueva presión, entrega el evento (con MODO_GESTOS pasa
+ * cada cambio, presión o liberación, a la máquina de gestos)
+ * 
+ * @param arg: Ranura de la entrada en config_botones
+ */
+static void temporizador_asentamiento_cb(void *arg)
+{
+    int ranura = (int)(intptr_t) arg;
+    const config_boton_t *config = &config_botones[ranura];
+    bool presionado = gpio_get_level(config->pin) == 0;
+    
+#if MODO_GESTOS
+    // Los gestos usan el instante del último cambio de la línea. Una liberación
+    // menos de una ventana antes del umbral largo puede salir como largo: el plazo
+    // vence antes de que la liberación termine de asentarse
+    estado_boton_t *estado = &estado_botones[ranura];
+    if(presionado != estado->presionado_estable) {
+        estado->presionado_estable = presionado;
+        evento_boton_t gestos[MAX_GESTOS_POR_PASO];
+        int n = gesto_cambio(&estado_gestos[ranura], &config_gestos, presionado, estado->cambio_us, gestos);
+        entregar_gestos(ranura, gestos, n);
+    }
+#else
+    if(antirrebote_asentar(&estado_botones[ranura], presionado)) {
+        entregar_evento(EVENTO_PRESION(config->evento));
+    }
+#endif
+}
+
+#if MODO_LEDS == LEDS_TAREA_POR_LED
+/**
+ * Espera eventos del botón asociado a un LED
+ * Oculta a las tareas el modo de entrega (cola o notificación directa)
+ * 
+ * @param indice: Índice del botón (evento - 1)
+ * @param timeout: Tiempo máximo de espera en ticks
+ * @return Número de presiones recibidas (0 si venció el timeout)
+ */
+static uint32_t esperar_eventos(int indice, TickType_t timeout)
+{
+    uint32_t recibidos = 0;
+    
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+    evento_boton_t evento_recibido;
+    if(xQueueReceive(colas_led[indice], &evento_recibido, timeout)) {
+        recibidos = 1;
+    }
+#else
+    uint32_t bits;
+    if(xTaskNotifyWait(0, BIT_BOTON(indice), &bits, timeout) == pdTRUE) {
+        // Toma todas las presiones acumuladas desde la última vez
+        recibidos = __atomic_exchange_n(&presiones_pendientes[indice], 0, __ATOMIC_ACQUIRE);
+    }
+#endif
+    
+#if MODO_BENCHMARK_ISR
+    if(recibidos > 0) {
+        registrar_ciclos(&latencia_despertar[indice], esp_cpu_get_cycle_count() - ciclo_entrada_isr[indice]);
+    }
+#endif
+    
+    despertares[indice]++;
+    eventos_procesados[indice] += recibidos;
+    return recibidos;
+}
+
+/**
+ * Tarea para controlar el LED rojo
+ * Maneja el encendido/apagado alternado del LED rojo
+ */
+static void tarea_led_rojo(void *pvParameters)
+{
+    marcar_primera_tarea();
+    ESP_LOGI(TAG, "Tarea LED Rojo iniciada");
+    
+    // Estado inicial del LED rojo (apagado)
+    bool estado_led_rojo = false;
+    
+    // Bucle infinito de la tarea
+    while(1) {
+        // Espera indefinidamente eventos del botón 1: sin presiones la tarea no despierta
+        uint32_t presiones = esperar_eventos(EVENTO_BOTON_1 - 1, portMAX_DELAY);
+        
+        if(presiones == 0) {
+            despertares_ociosos[EVENTO_BOTON_1 - 1]++;
+        }
+#if MODO_BENCHMARK_LATENCIA
+        else {
+            marcar_recepcion_latencia();
+        }
+#endif
+        
+        // Procesa cada presión recibida
+        for(uint32_t i = 0; i < presiones; i++) {
+            
+            // Cambia el estado del LED (toggle)
+            estado_led_rojo = !estado_led_rojo;
+            
+            // Establece el nivel del GPIO según el nuevo estado
+            gpio_set_level(LED_ROJO_PIN, estado_led_rojo);
+#if MODO_BENCHMARK_LATENCIA
+            registrar_latencia_led();
+#endif
+            
+            // Log del cambio de estado
+            LOGI_DIFERIDO("LED Rojo: %s", estado_led_rojo ? "ENCENDIDO" : "APAGADO");
+        }
+    }
+}
+
+/**
+ * Tarea para controlar el LED amarillo
+ * Maneja el parpadeo continuo del LED amarillo
+ */
+static void tarea_led_amarillo(void *pvParameters)
+{
+    marcar_primera_tarea();
+    ESP_LOGI(TAG, "Tarea LED Amarillo iniciada");
+    
+    // Estado actual del LED durante el parpadeo
+    bool estado_parpadeo = false;
+    
+    // Tick del próximo cambio programado del LED
+    TickType_t proximo_cambio = 0;
+    
+    // Bucle infinito de la tarea
+    while(1) {
+        // Sin parpadeo la tarea se bloquea indefinidamente; con parpadeo solo
+        // hasta el siguiente cambio programado del LED
+        TickType_t espera = portMAX_DELAY;
+        if(led_amarillo_parpadeando) {
+            TickType_t ahora = xTaskGetTickCount();
+            espera = ((int32_t)(proximo_cambio - ahora) > 0) ? (proximo_cambio - ahora) : 0;
+        }
+        
+        uint32_t presiones = esperar_eventos(EVENTO_BOTON_2 - 1, espera);
+        bool hubo_trabajo = presiones > 0;
+        
+        for(uint32_t i = 0; i < presiones; i++) {
+            
+            // Cambia el estado del parpadeo
+            led_amarillo_parpadeando = !led_amarillo_parpadeando;
+            
+            LOGI_DIFERIDO("Parpadeo LED Amarillo: %s",
+                    led_amarillo_parpadeando ? "ACTIVADO" : "DESACTIVADO");
+            
+            if(led_amarillo_parpadeando) {
+                // El primer cambio ocurre de inmediato
+                proximo_cambio = xTaskGetTickCount();
+            } else {
+                // Si se desactiva el parpadeo, apaga el LED
+                gpio_set_level(LED_AMARILLO_PIN, 0);
+                estado_parpadeo = false;
+            }
+        }
+        
+        // Lógica de parpadeo: solo cambia el LED cuando llegó su momento
+        TickType_t ahora = xTaskGetTickCount();
+        if(led_amarillo_parpadeando && (int32_t)(ahora - proximo_cambio) >= 0) {
+            // Alterna el estado del LED
+            estado_parpadeo = !estado_parpadeo;
+            gpio_set_level(LED_AMARILLO_PIN, estado_parpadeo);
+            hubo_trabajo = true;
+            
+            // Programa el siguiente cambio sin acumular deriva; si se atrasó más de
+            // un periodo, se resincroniza con el tiempo actual
+            proximo_cambio += pdMS_TO_TICKS(PERIODO_PARPADEO_MS);
+            if((int32_t)(ahora - proximo_cambio) >= 0) {
+                proximo_cambio = ahora + pdMS_TO_TICKS(PERIODO_PARPADEO_MS);
+            }
+        }
+        
+        if(!hubo_trabajo) {
+            despertares_ociosos[EVENTO_BOTON_2 - 1]++;
+        }
+    }
+}
+
+// Jitter de la secuencia verde con retardos encadenados
+static estadistica_jitter_t jitter_verde;
+
+/**
+ * Retardo de un paso de la secuencia verde
+ * Cada vTaskDelay cuenta desde que la tarea despertó, así que el error de un
+ * paso se arrastra a los siguientes; se registra contra el instante ideal
+ * 
+ * @param ms: Duración del paso en milisegundos
+ * @param ideal_us: Instante ideal del paso actual, se avanza a la del siguiente
+ */
+static void esperar_paso_verde(uint32_t ms, int64_t *ideal_us)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms / ESCALA_TIEMPO_PATRONES));
+    *ideal_us += (int64_t) ms * 1000 / ESCALA_TIEMPO_PATRONES;
+    registrar_jitter(&jitter_verde, esp_timer_get_time() - *ideal_us);
+}
+
+/**
+ * Tarea para controlar el LED verde
+ * Maneja una secuencia de parpadeo específica del LED verde
+ */
+static void tarea_led_verde(void *pvParameters)
+{
+    marcar_primera_tarea();
+    ESP_LOGI(TAG, "Tarea LED Verde iniciada");
+    
+    // Bucle infinito de la tarea
+    while(1) {
+        // Espera indefinidamente eventos del botón 3; durante la secuencia la tarea
+        // solo despierta en cada cambio programado del LED
+        uint32_t presiones = esperar_eventos(EVENTO_BOTON_3 - 1, portMAX_DELAY);
+        
+        if(presiones == 0) {
+            despertares_ociosos[EVENTO_BOTON_3 - 1]++;
+        }
+        
+        for(uint32_t n = 0; n < presiones; n++) {
+            
+            // Verifica que no hay otra secuencia en curso
+            if(!secuencia_verde_activa) {
+                
+                // Activa la bandera de secuencia
+                secuencia_verde_activa = true;
+                
+                ESP_LOGI(TAG, "Secuencia LED Verde iniciada");
+                
+                // Instante ideal de cada cambio, para medir el jitter de los retardos encadenados
+                int64_t ideal_us = esp_timer_get_time();
+                
+                // Ejecuta secuencia: 3 parpadeos rápidos
+                for(int i = 0; i < 3; i++) {
+                    gpio_set_level(LED_VERDE_PIN, 1);    // Enciende LED
+                    esperar_paso_verde(200, &ideal_us);  // Espera 200ms
+                    gpio_set_level(LED_VERDE_PIN, 0);    // Apaga LED
+                    esperar_paso_verde(200, &ideal_us);  // Espera 200ms
+                }
+                
+                // Pausa entre secuencias
+                esperar_paso_verde(1000, &ideal_us);
+                
+                // Ejecuta secuencia: encendido prolongado
+                gpio_set_level(LED_VERDE_PIN, 1);        // Enciende LED
+                esperar_paso_verde(2000, &ideal_us);     // Mantiene encendido 2 segundos
+                gpio_set_level(LED_VERDE_PIN, 0);        // Apaga LED
+                
+                // Marca el final de la secuencia
+                secuencia_verde_activa = false;
+                
+                ESP_LOGI(TAG, "Secuencia LED Verde completada");
+                imprimir_jitter("Verde", &jitter_verde);
+            }
+        }
+    }
+}
+
+#else
+// ============================================================================
+// MOTOR DE PATRONES DE LEDS
+// ============================================================================
+// Cada patrón es una tabla de pasos (nivel y duración). Una sola tarea recorre
+// los patrones de todos los canales con vencimientos absolutos en ticks y se
+// bloquea hasta el cambio más próximo o hasta el siguiente evento de botón.
+// Agregar un LED es agregar una fila a config_canales: cuesta sizeof(estado_canal_t)
+// bytes de RAM, no una pila de tarea.
+
+// Paso de un patrón. Un paso con 'veces' distinto de 0 es de control: retrocede
+// 'atras' pasos hasta completar 'veces' pasadas del bloque (sin anidar)
+typedef struct {
+    uint8_t nivel;          // Nivel de la salida durante el paso
+    uint8_t veces;          // Pasadas del bloque (solo pasos de control)
+    uint8_t atras;          // Pasos que retrocede (solo pasos de control)
+    uint16_t duracion_ms;   // Duración del paso (0 = mantener hasta el próximo evento)
+} paso_patron_t;
+
+#define PASO(nivel, ms)         { (nivel), 0, 0, (ms) }
+#define REPETIR(atras, veces)   { 0, (veces), (atras), 0 }
+
+// Un patrón cíclico vuelve al primer paso; uno finito deja el LED apagado al terminar
+typedef struct {
+    const char *nombre;
+    const paso_patron_t *pasos;
+    uint8_t num_pasos;
+    bool ciclico;
+} patron_t;
+
+#define PATRON(nombre, pasos, ciclico) \
+    { (nombre), (pasos), sizeof(pasos) / sizeof((pasos)[0]), (ciclico) }
+
+static const paso_patron_t pasos_apagado[]   = { PASO(0, 0) };
+static const paso_patron_t pasos_encendido[] = { PASO(1, 0) };
+static const paso_patron_t pasos_parpadeo[]  = { PASO(1, 500), PASO(0, 500) };
+static const paso_patron_t pasos_secuencia[] = {
+    PASO(1, 200), PASO(0, 200), REPETIR(2, 3),  // 3 parpadeos rápidos
+    PASO(0, 1000),                              // Pausa
+    PASO(1, 2000),                              // Encendido prolongado
+};
+
+static const patron_t PATRON_APAGADO   = PATRON("apagado", pasos_apagado, false);
+static const patron_t PATRON_ENCENDIDO = PATRON("encendido", pasos_encendido, false);
+static const patron_t PATRON_PARPADEO  = PATRON("parpadeo", pasos_parpadeo, true);
+static const patron_t PATRON_SECUENCIA = PATRON("secuencia", pasos_secuencia, false);
+
+// Qué hace un evento que llega mientras el canal reproduce un patrón finito.
+// Los patrones cíclicos y los pasos que se mantienen siempre se reemplazan
+typedef enum {
+    POLITICA_INTERRUMPIR,   // El patrón nuevo reemplaza de inmediato al actual
+    POLITICA_ENCOLAR,       // El patrón nuevo empieza cuando termine el actual
+    POLITICA_REINICIAR      // El patrón actual vuelve a su primer paso
+} politica_patron_t;
+
+// Quién genera la forma de onda de cada canal
+typedef enum {
+    SALIDA_GPIO,    // El motor escribe cada cambio con gpio_set_level
+    SALIDA_LEDC     // Los patrones periódicos se delegan al PWM LEDC; los demás, por software
+} salida_led_t;
+
+// Configuración de cada canal: qué LED, qué botón lo controla y qué reproduce.
+// Una presión (o un clic corto con MODO_GESTOS) dispara patron/alterno; los demás
+// gestos multiplexan otras funciones en el mismo botón
+typedef struct {
+    const char *nombre;
+    gpio_num_t pin;
+    evento_interrupcion_t evento;   // Botón que controla el canal
+    const patron_t *patron;         // Patrón que dispara el evento
+    const patron_t *alterno;        // Si no es NULL, el evento alterna entre patron y alterno
+    politica_patron_t politica;
+    salida_led_t salida;
+    const patron_t *doble;          // Patrón del doble clic (NULL = sin acción)
+    const patron_t *largo;          // Patrón de la presión larga (NULL = sin acción)
+    bool repetir;                   // Cada repetición al mantener cuenta como un clic corto
+} config_canal_t;
+
+static const config_canal_t config_canales[] = {
+    { "Rojo",     LED_ROJO_PIN,     EVENTO_BOTON_1, &PATRON_ENCENDIDO, &PATRON_APAGADO, POLITICA_INTERRUMPIR, SALIDA_GPIO,
+      &PATRON_PARPADEO, &PATRON_APAGADO,   false },
+    { "Amarillo", LED_AMARILLO_PIN, EVENTO_BOTON_2, &PATRON_PARPADEO,  &PATRON_APAGADO, POLITICA_INTERRUMPIR, SALIDA_LEDC,
+      NULL,             &PATRON_ENCENDIDO, false },
+    { "Verde",    LED_VERDE_PIN,    EVENTO_BOTON_3, &PATRON_SECUENCIA, NULL,            POLITICA_ENCOLAR,     SALIDA_GPIO,
+      NULL,             NULL,              true },
+};
+#define NUM_CANALES (sizeof(config_canales) / sizeof(config_canales[0]))
+
+// Estado de reproducción de cada canal; solo lo toca la tarea del motor
+typedef struct {
+    const patron_t *activo;     // Patrón en reproducción (NULL = reposo)
+    const patron_t *en_cola;    // Patrón encolado por POLITICA_ENCOLAR
+    uint16_t pendientes;        // Reproducciones encoladas de en_cola
+    uint8_t paso;               // Paso actual de activo
+    uint8_t vueltas;            // Pasadas restantes del bloque REPETIR en curso
+    bool programado;            // El paso actual tiene vencimiento
+    int8_t ledc;                // Canal LEDC que maneja el pin (-1 = solo software)
+    TickType_t vencimiento;     // Tick en que termina el paso actual
+    int64_t ideal_us;           // Instante ideal en que termina el paso actual
+} estado_canal_t;
+
+static estado_canal_t estado_canales[NUM_CANALES];
+static estadistica_jitter_t jitter_canales[NUM_CANALES];
+
+// Canales con un cambio programado (lo consulta la simulación para saber si el motor quedó quieto)
+static volatile uint32_t canales_programados;
+
+static void iniciar_patron(int canal, const patron_t *patron, TickType_t base, int64_t base_us);
+
+// Reloj del LEDC: en sueño ligero el APB se apaga y solo RC_FAST sigue contando
+#if USAR_SUENO_LIGERO
+#define RELOJ_LEDC       LEDC_USE_RC_FAST_CLK
+#define RELOJ_LEDC_HZ    SOC_CLK_RC_FAST_FREQ_APPROX
+#else
+#define RELOJ_LEDC       LEDC_USE_APB_CLK
+#define RELOJ_LEDC_HZ    APB_CLK_FREQ
+#endif
+
+// Resolución del timer de cada canal LEDC (fija desde configurar_salidas_led)
+static uint8_t resolucion_ledc[LEDC_TIMER_MAX];
+
+/**
+ * Describe un patrón como onda cuadrada para el LEDC
+ * Solo son representables los patrones cíclicos de un paso encendido seguido de
+ * uno apagado cuyo periodo da una frecuencia entera en Hz
+ * 
+ * @param patron: Patrón a convertir
+ * @param frecuencia_hz: Frecuencia de la onda
+ * @param encendido_ms: Tiempo en alto de cada periodo
+ * @param periodo_ms: Periodo de la onda
+ * @return true si el LEDC puede reproducir el patrón
+ */
+static bool onda_periodica(const patron_t *patron, uint32_t *frecuencia_hz,
+                           uint32_t *encendido_ms, uint32_t *periodo_ms)
+{
+    if(!patron->ciclico || patron->num_pasos != 2) {
+        return false;
+    }
+    const paso_patron_t *on = &patron->pasos[0];
+    const paso_patron_t *off = &patron->pasos[1];
+    if(on->veces || off->veces || on->nivel != 1 || off->nivel != 0 ||
+       on->duracion_ms == 0 || off->duracion_ms == 0) {
+        return false;
+    }
+    
+    *encendido_ms = on->duracion_ms / ESCALA_TIEMPO_PATRONES;
+    *periodo_ms = (on->duracion_ms + off->duracion_ms) / ESCALA_TIEMPO_PATRONES;
+    if(*encendido_ms == 0 || *periodo_ms == 0 || 1000 % *periodo_ms != 0) {
+        return false;
+    }
+    *frecuencia_hz = 1000 / *periodo_ms;
+    return true;
+}
+
+// Cambios de LED pendientes de la pasada actual del motor
+static uint32_t salidas_mascara;
+static uint32_t salidas_valor;
+
+/**
+ * Escribe un nivel fijo en la salida de un canal
+ * Un pin del LEDC queda conectado al periférico: su nivel fijo es el nivel de
+ * reposo del canal detenido. Los demás se acumulan para aplicar_salidas
+ * 
+ * @param canal: Índice en config_canales
+ * @param nivel: Nivel a escribir
+ */
+static void escribir_salida(int canal, uint32_t nivel)
+{
+    int8_t ledc = estado_canales[canal].ledc;
+    if(ledc >= 0) {
+        ledc_stop(LEDC_LOW_SPEED_MODE, ledc, nivel);
+    } else {
+        // Se acumula y se aplica junto con los demás cambios de la pasada del motor
+        uint32_t bit = 1UL << config_canales[canal].pin;
+        salidas_mascara |= bit;
+        salidas_valor = nivel ? (salidas_valor | bit) : (salidas_valor & ~bit);
+    }
+}
+
+/**
+ * Aplica en una sola escritura los cambios de LED acumulados
+ */
+static void aplicar_salidas(void)
+{
+    if(salidas_mascara != 0) {
+        escribir_leds(salidas_mascara, salidas_valor);
+#if MODO_BENCHMARK_LATENCIA
+        if(salidas_mascara & (1UL << LED_ROJO_PIN)) {
+            registrar_latencia_led();
+        }
+#endif
+        salidas_mascara = 0;
+    }
+}
+
+/**
+ * Arranca un patrón periódico en el LEDC
+ * Una vez programado el parpadeo no cuesta CPU: el motor no agenda vencimientos
+ * 
+ * @param canal: Índice en config_canales
+ * @param patron: Patrón a reproducir
+ * @return true si el LEDC quedó reproduciendo el patrón; false para usar software
+ */
+static bool iniciar_patron_ledc(int canal, const patron_t *patron)
+{
+    int8_t ledc = estado_canales[canal].ledc;
+    uint32_t frecuencia_hz, encendido_ms, periodo_ms;
+    if(ledc < 0 || !onda_periodica(patron, &frecuencia_hz, &encendido_ms, &periodo_ms)) {
+        return false;
+    }
+    
+    // Un timer por canal LEDC, con el mismo número que el canal
+    if(ledc_get_freq(LEDC_LOW_SPEED_MODE, ledc) != frecuencia_hz &&
+       ledc_set_freq(LEDC_LOW_SPEED_MODE, ledc, frecuencia_hz) != ESP_OK) {
+        return false;
+    }
+    
+    // El periodo arranca en la fase encendida, igual que el primer paso del patrón
+    uint32_t duty = (uint32_t)(((uint64_t) encendido_ms << resolucion_ledc[ledc]) / periodo_ms);
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, ledc, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, ledc);
+    ledc_timer_rst(LEDC_LOW_SPEED_MODE, ledc);
+    return true;
+}
+
+/**
+ * Configura el LEDC de los canales con SALIDA_LEDC
+ * Usa la menor resolución con la que el divisor del timer cabe en 10 bits para
+ * la frecuencia del patrón del canal. Si el chip no la alcanza o no quedan
+ * timers, el canal sigue con el parpadeo por software
+ */
+static void configurar_salidas_led(void)
+{
+    int siguiente_ledc = 0;
+    
+    for(size_t c = 0; c < NUM_CANALES; c++) {
+        const config_canal_t *config = &config_canales[c];
+        estado_canal_t *e = &estado_canales[c];
+        e->ledc = -1;
+        
+        uint32_t frecuencia_hz, encendido_ms, periodo_ms;
+        if(config->salida != SALIDA_LEDC) {
+            continue;
+        }
+        if(siguiente_ledc >= LEDC_TIMER_MAX ||
+           !onda_periodica(config->patron, &frecuencia_hz, &encendido_ms, &periodo_ms)) {
+            ESP_LOGW(TAG, "LED %s: patrón no apto para LEDC, parpadeo por software", config->nombre);
+            continue;
+        }
+        
+        uint32_t resolucion = 1;
+        while(resolucion < LEDC_TIMER_BIT_MAX - 1 &&
+              RELOJ_LEDC_HZ / ((uint64_t) frecuencia_hz << resolucion) > 1023) {
+            resolucion++;
+        }
+        
+        ledc_timer_config_t timer = {
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .duty_resolution = resolucion,
+            .timer_num = siguiente_ledc,
+            .freq_hz = frecuencia_hz,
+            .clk_cfg = RELOJ_LEDC
+        };
+        if(ledc_timer_config(&timer) != ESP_OK) {
+            ESP_LOGW(TAG, "LED %s: el LEDC no alcanza %" PRIu32 " Hz, parpadeo por software",
+                     config->nombre, frecuencia_hz);
+            continue;
+        }
+        
+        ledc_channel_config_t canal_ledc = {
+            .gpio_num = config->pin,
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .channel = siguiente_ledc,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = siguiente_ledc,
+            .duty = 0,
+            .hpoint = 0
+        };
+        ESP_ERROR_CHECK(ledc_channel_config(&canal_ledc));
+#if USAR_SUENO_LIGERO
+        // El pin sigue conectado al LEDC mientras el chip duerme
+        ESP_ERROR_CHECK(gpio_sleep_sel_dis(config->pin));
+#endif
+        
+        e->ledc = siguiente_ledc;
+        resolucion_ledc[siguiente_ledc] = resolucion;
+        mascara_leds_registro &= ~(1UL << config->pin);
+        siguiente_ledc++;
+        escribir_salida(c, 0);
+        
+        ESP_LOGI(TAG, "LED %s: LEDC canal %d, %" PRIu32 " Hz con %" PRIu32 " bits", config->nombre,
+                 e->ledc, frecuencia_hz, resolucion);
+    }
+    
+#if USAR_SUENO_LIGERO
+    // RC_FAST encendido en sueño ligero para que el PWM no se detenga
+    if(siguiente_ledc > 0) {
+        ESP_ERROR_CHECK(esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_ON));
+    }
+#endif
+}
+
+/**
+ * Lleva un canal a su próximo paso con duración
+ * Resuelve los pasos de control, escribe el nivel y programa el vencimiento a
+ * partir de 'base' (el vencimiento anterior), así el error no se acumula
+ * 
+ * @param canal: Índice en config_canales
+ * @param base: Tick en que empieza el paso
+ */
+static void entrar_paso(int canal, TickType_t base)
+{
+    const config_canal_t *config = &config_canales[canal];
+    estado_canal_t *e = &estado_canales[canal];
+    const patron_t *p = e->activo;
+    
+    while(1) {
+        if(e->paso >= p->num_pasos) {
+            if(p->ciclico) {
+                e->paso = 0;
+                continue;
+            }
+            
+            // Fin del patrón finito: sigue el encolado sin hueco o el LED queda apagado
+            if(e->pendientes > 0) {
+                e->pendientes--;
+                iniciar_patron(canal, e->en_cola, base, e->ideal_us);
+                return;
+            }
+            escribir_salida(canal, 0);
+            e->activo = NULL;
+            e->programado = false;
+            LOGI_DIFERIDO("LED %s: patrón %s completado", config->nombre, p->nombre);
+            imprimir_jitter(config->nombre, &jitter_canales[canal]);
+            return;
+        }
+        
+        const paso_patron_t *paso = &p->pasos[e->paso];
+        if(paso->veces > 0) {
+            // Primera llegada al control: arranca la cuenta de pasadas del bloque
+            if(e->vueltas == 0) {
+                e->vueltas = paso->veces;
+            }
+            if(--e->vueltas > 0) {
+                e->paso -= paso->atras;
+            } else {
+                e->paso++;
+            }
+            continue;
+        }
+        
+        escribir_salida(canal, paso->nivel);
+        if(paso->duracion_ms == 0) {
+            e->programado = false;  // Se mantiene hasta el próximo evento
+            return;
+        }
+        
+        // Al menos un tick para que un paso muy corto no deje al motor girando
+        TickType_t ticks = pdMS_TO_TICKS(paso->duracion_ms / ESCALA_TIEMPO_PATRONES);
+        e->vencimiento = base + (ticks > 0 ? ticks : 1);
+        e->ideal_us += (int64_t) paso->duracion_ms * 1000 / ESCALA_TIEMPO_PATRONES;
+        e->programado = true;
+        return;
+    }
+}
+
+/**
+ * Empieza un patrón desde su primer paso
+ * 
+ * @param canal: Índice en config_canales
+ * @param patron: Patrón a reproducir
+ * @param base: Tick en que empieza
+ * @param base_us: Instante ideal en que empieza (referencia del jitter)
+ */
+static void iniciar_patron(int canal, const patron_t *patron, TickType_t base, int64_t base_us)
+{
+    estado_canal_t *e = &estado_canales[canal];
+    e->activo = patron;
+    e->paso = 0;
+    e->vueltas = 0;
+    e->ideal_us = base_us;
+    
+    // Los patrones periódicos de un canal con LEDC no agendan vencimientos
+    if(iniciar_patron_ledc(canal, patron)) {
+        e->programado = false;
+        return;
+    }
+    entrar_paso(canal, base);
+}
+
+/**
+ * Aplica un evento de botón a un canal
+ * La presión, el clic corto y (si el canal lo pide) la repetición siguen la
+ * política del canal; el doble clic y la presión larga reemplazan siempre el
+ * patrón actual y descartan lo encolado
+ * 
+ * @param canal: Índice en config_canales
+ * @param gesto: Gesto del evento
+ */
+static void aplicar_evento(int canal, tipo_gesto_t gesto)
+{
+    const config_canal_t *config = &config_canales[canal];
+    estado_canal_t *e = &estado_canales[canal];
+    
+    if(gesto == GESTO_DOBLE || gesto == GESTO_LARGO) {
+        const patron_t *patron = (gesto == GESTO_DOBLE) ? config->doble : config->largo;
+        if(patron != NULL) {
+            e->pendientes = 0;
+            LOGI_DIFERIDO("LED %s: patrón %s (%s)", config->nombre, patron->nombre,
+                     gesto == GESTO_DOBLE ? "doble clic" : "presión larga");
+            iniciar_patron(canal, patron, xTaskGetTickCount(), esp_timer_get_time());
+        }
+        return;
+    }
+    if(gesto == GESTO_REPETICION && !config->repetir) {
+        return;
+    }
+    
+    const patron_t *siguiente = config->patron;
+    if(config->alterno != NULL && e->activo == config->patron) {
+        siguiente = config->alterno;
+    }
+    
+    // Solo un patrón finito con cambios pendientes está "ocupado"
+    bool ocupado = e->activo != NULL && e->programado && !e->activo->ciclico;
+    
+    if(ocupado && config->politica == POLITICA_ENCOLAR) {
+        // La cola guarda un solo patrón con su número de reproducciones
+        if(e->en_cola != siguiente) {
+            e->en_cola = siguiente;
+            e->pendientes = 0;
+        }
+        if(e->pendientes < UINT16_MAX) {
+            e->pendientes++;
+        }
+        return;
+    }
+    
+    if(ocupado && config->politica == POLITICA_REINICIAR) {
+        siguiente = e->activo;
+    }
+    
+    e->pendientes = 0;
+    LOGI_DIFERIDO("LED %s: patrón %s", config->nombre, siguiente->nombre);
+    iniciar_patron(canal, siguiente, xTaskGetTickCount(), esp_timer_get_time());
+}
+
+/**
+ * Espera eventos de cualquier botón
+ * Oculta al motor el modo de entrega (cola compartida o notificación directa).
+ * Los eventos de una pasada se cuentan por botón y gesto; a velocidad humana una
+ * pasada trae a lo sumo un gesto por botón, así que agruparlos no cambia el orden
+ * 
+ * @param timeout: Tiempo máximo de espera en ticks
+ * @param eventos: Eventos recibidos por botón y gesto (se suman)
+ * @return true si llegó al menos un evento
+ */
+static bool esperar_eventos_motor(TickType_t timeout, uint32_t eventos[NUM_BOTONES][NUM_GESTOS])
+{
+    bool hubo_eventos = false;
+    
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+    // Bloquea por el primer evento y vacía el resto de la cola sin esperar
+    evento_boton_t evento_recibido;
+    while(xQueueReceive(colas_led[0], &evento_recibido, timeout)) {
+        eventos[evento_recibido.evento - 1][evento_recibido.gesto]++;
+        timeout = 0;
+    }
+#else
+    uint32_t bits;
+    if(xTaskNotifyWait(0, UINT32_MAX, &bits, timeout) == pdTRUE) {
+        for(int i = 0; i < NUM_BOTONES; i++) {
+            if(bits & BIT_BOTON(i)) {
+                eventos[i][GESTO_PRESION] += __atomic_exchange_n(&presiones_pendientes[i], 0, __ATOMIC_ACQUIRE);
+            }
+        }
+    }
+#endif
+    
+#if MODO_BENCHMARK_LATENCIA
+    if(eventos[EVENTO_BOTON_1 - 1][GESTO_PRESION] > 0) {
+        marcar_recepcion_latencia();
+    }
+#endif
+    
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        uint32_t recibidos = 0;
+        for(int g = 0; g < NUM_GESTOS; g++) {
+            recibidos += eventos[i][g];
+        }
+        if(recibidos == 0) {
+            continue;
+        }
+#if MODO_BENCHMARK_ISR
+        registrar_ciclos(&latencia_despertar[i], esp_cpu_get_cycle_count() - ciclo_entrada_isr[i]);
+#endif
+        eventos_procesados[i] += recibidos;
+        hubo_eventos = true;
+    }
+    
+    despertares[0]++;
+    return hubo_eventos;
+}
+
+/**
+ * Tarea del motor de patrones
+ * Atiende los eventos de todos los botones y ejecuta los cambios vencidos de
+ * todos los canales. Sin patrones programados se bloquea indefinidamente.
+ */
+static void tarea_motor_patrones(void *pvParameters)
+{
+    marcar_primera_tarea();
+    ESP_LOGI(TAG, "Motor de patrones iniciado: %u canales", (unsigned) NUM_CANALES);
+    
+    while(1) {
+        // Se bloquea hasta el vencimiento más próximo de cualquier canal
+        TickType_t espera = portMAX_DELAY;
+        TickType_t ahora = xTaskGetTickCount();
+        for(size_t c = 0; c < NUM_CANALES; c++) {
+            if(estado_canales[c].programado) {
+                int32_t restante = (int32_t)(estado_canales[c].vencimiento - ahora);
+                TickType_t t = restante > 0 ? (TickType_t) restante : 0;
+                if(t < espera) {
+                    espera = t;
+                }
+            }
+        }
+        
+        uint32_t eventos[NUM_BOTONES][NUM_GESTOS] = {{0}};
+        bool hubo_trabajo = esperar_eventos_motor(espera, eventos);
+        
+        // Cada evento se aplica a los canales de su botón
+        for(size_t c = 0; c < NUM_CANALES; c++) {
+            for(int g = 0; g < NUM_GESTOS; g++) {
+                uint32_t n = eventos[config_canales[c].evento - 1][g];
+                for(uint32_t k = 0; k < n; k++) {
+                    aplicar_evento(c, g);
+                }
+            }
+        }
+        
+        // Ejecuta los cambios vencidos; si el motor se atrasó, pone al día cada canal
+        ahora = xTaskGetTickCount();
+        int64_t ahora_us = esp_timer_get_time();
+        uint32_t programados = 0;
+        for(size_t c = 0; c < NUM_CANALES; c++) {
+            estado_canal_t *e = &estado_canales[c];
+            while(e->programado && (int32_t)(ahora - e->vencimiento) >= 0) {
+                registrar_jitter(&jitter_canales[c], ahora_us - e->ideal_us);
+                e->paso++;
+                entrar_paso(c, e->vencimiento);
+                hubo_trabajo = true;
+            }
+            programados += e->programado;
+        }
+        canales_programados = programados;
+        
+        // Todos los LEDs que cambiaron en esta pasada cambian juntos
+        aplicar_salidas();
+        
+        if(!hubo_trabajo) {
+            despertares_ociosos[0]++;
+        }
+    }
+}
+#endif
+
+/**
+ * Función para configurar los pines GPIO
+ * Configura los pines de entrada (botones) y salida (LEDs)
+ */
+static void configurar_gpio(void)
+{
+    ESP_LOGI(TAG, "Configurando pines GPIO...");
+    
+    // Estructura de configuración para pines de salida (LEDs)
+    gpio_config_t io_conf_output = {};
+    
+    // Máscara de bits con los pines a configurar como salida
+    io_conf_output.pin_bit_mask = GPIO_OUTPUT_PIN_SEL;
+    
+    // Configura como modo salida
+    io_conf_output.mode = GPIO_MODE_OUTPUT;
+    
+    // Deshabilita resistencia pull-up
+    io_conf_output.pull_up_en = GPIO_PULLUP_DISABLE;
+    
+    // Deshabilita resistencia pull-down
+    io_conf_output.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    
+    // Deshabilita interrupciones para salidas
+    io_conf_output.intr_type = GPIO_INTR_DISABLE;
+    
+    // Aplica la configuración
+    ESP_ERROR_CHECK(gpio_config(&io_conf_output));
+    
+    // Estructura de configuración para pines de entrada (botones)
+    gpio_config_t io_conf_input = {};
+    
+    // Máscara de bits con los pines a configurar como entrada (todas las filas de config_botones)
+    for(size_t i = 0; i < NUM_ENTRADAS; i++) {
+        io_conf_input.pin_bit_mask |= 1ULL << config_botones[i].pin;
+    }
+    
+    // Configura como modo entrada
+    // En simulación el pin también es salida open-drain: escribir 0 genera el
+    // mismo flanco descendente que un botón real
+#if MODO_SIMULACION
+    io_conf_input.mode = GPIO_MODE_INPUT_OUTPUT_OD;
+#else
+    io_conf_input.mode = GPIO_MODE_INPUT;
+#endif
+    
+    // Habilita resistencia pull-up interna (botón conectado a GND)
+    io_conf_input.pull_up_en = GPIO_PULLUP_ENABLE;
+    
+    // Deshabilita resistencia pull-down
+    io_conf_input.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    
+    // Configura interrupción en flanco descendente (presión del botón)
+    // Las entradas por asentamiento pasan a ambos flancos en configurar_interrupciones
+    io_conf_input.intr_type = GPIO_INTR_NEGEDGE;
+    
+    // Aplica la configuración
+    ESP_ERROR_CHECK(gpio_config(&io_conf_input));
+    
+    ESP_LOGI(TAG, "Configuración GPIO completada");
+}
+
+/**
+ * Función para configurar las interrupciones GPIO
+ * Instala el servicio de interrupciones y asocia handlers
+ */
+static void configurar_interrupciones(void)
+{
+    ESP_LOGI(TAG, "Configurando interrupciones GPIO...");
+    
+    // Instala el servicio de interrupciones GPIO
+    // ESP_INTR_FLAG_DEFAULT: usa la prioridad por defecto
+    ESP_ERROR_CHECK(gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT));
+    
+    // Ningún pin es entrada hasta que se registre su ranura
+    memset(ranura_por_pin, -1, sizeof(ranura_por_pin));
+    
+    // Registra cada entrada de config_botones; no hay código por botón
+    for(size_t i = 0; i < NUM_ENTRADAS; i++) {
+        const config_boton_t *config = &config_botones[i];
+        estado_boton_t *estado = &estado_botones[i];
+        
+        // La primera presión siempre se acepta
+        estado->ultimo_aceptado_us = -(int64_t)config->ventana_us;
+        estado->presionado_estable = false;
+        
+        if(config->modo == ANTIRREBOTE_ASENTAMIENTO) {
+            // Un temporizador por entrada que vence cuando la línea se asienta
+            const esp_timer_create_args_t args = {
+                .callback = temporizador_asentamiento_cb,
+                .arg = (void*)(intptr_t) i,
+                .name = "asentamiento"
+            };
+            ESP_ERROR_CHECK(esp_timer_create(&args, &estado->temporizador));
+            
+#if !USAR_SUENO_LIGERO
+            // Cualquier cambio de la línea reinicia la ventana
+            ESP_ERROR_CHECK(gpio_set_intr_type(config->pin, GPIO_INTR_ANYEDGE));
+#endif
+        }
+        
+#if MODO_GESTOS
+        if(config->modo != ANTIRREBOTE_ASENTAMIENTO) {
+            ESP_LOGE(TAG, "GPIO %d: los gestos requieren anti-rebote por asentamiento", config->pin);
+            continue;
+        }
+        
+        // Plazo de la máquina de gestos; se arma solo mientras hay uno pendiente
+        const esp_timer_create_args_t args_gesto = {
+            .callback = temporizador_gesto_cb,
+            .arg = (void*)(intptr_t) i,
+            .name = "gesto"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&args_gesto, &temporizadores_gesto[i]));
+#endif
+        
+        ranura_por_pin[config->pin] = (int8_t) i;
+        
+        // Asocia el handler de interrupción al botón
+        ESP_ERROR_CHECK(gpio_isr_handler_add(config->pin, gpio_isr_handler, (void*) config->pin));
+        
+        ESP_LOGI(TAG, "GPIO %d: anti-rebote por %s, ventana %" PRIu32 " us", config->pin,
+                 config->modo == ANTIRREBOTE_FLANCO ? "flanco" : "asentamiento",
+                 config->ventana_us);
+    }
+    
+    ESP_LOGI(TAG, "Interrupciones GPIO configuradas correctamente");
+}
+
+#if USAR_SUENO_LIGERO
+/**
+ * Función para configurar el modo de bajo consumo
+ * Habilita el sueño ligero automático: con tickless idle, cuando todas las tareas
+ * están bloqueadas el chip duerme hasta el siguiente evento programado o hasta
+ * que un botón lo despierte por nivel
+ */
+static void configurar_bajo_consumo(void)
+{
+    ESP_LOGI(TAG, "Configurando sueño ligero automático...");
+    
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    
+    // Los botones despiertan al chip con nivel bajo (presión)
+    for(size_t i = 0; i < NUM_ENTRADAS; i++) {
+        ESP_ERROR_CHECK(gpio_wakeup_enable(config_botones[i].pin, GPIO_INTR_LOW_LEVEL));
+    }
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+    
+    ESP_LOGI(TAG, "Sueño ligero automático habilitado");
+}
+#endif
+
+/**
+ * Imprime la RAM que cuesta el control de los LEDs
+ * Se compara compilando una vez con cada valor de MODO_LEDS: el diseño de tarea
+ * por LED paga una pila y un TCB por LED, el motor solo su estado por canal
+ */
+static void imprimir_presupuesto_ram(void)
+{
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    size_t por_canal = sizeof(estado_canal_t) + sizeof(estadistica_jitter_t);
+    size_t total = PILA_TAREA_LED + sizeof(StaticTask_t) + NUM_CANALES * por_canal;
+    ESP_LOGI(TAG, "RAM LEDs (motor de patrones): %u B = pila %u B + TCB %u B + %u canales x %u B",
+             (unsigned) total, (unsigned) PILA_TAREA_LED, (unsigned) sizeof(StaticTask_t),
+             (unsigned) NUM_CANALES, (unsigned) por_canal);
+#else
+    size_t por_led = PILA_TAREA_LED + sizeof(StaticTask_t);
+    ESP_LOGI(TAG, "RAM LEDs (tarea por LED): %u B = %d tareas x (pila %u B + TCB %u B)",
+             (unsigned)(NUM_TAREAS_LED * por_led), NUM_TAREAS_LED,
+             (unsigned) PILA_TAREA_LED, (unsigned) sizeof(StaticTask_t));
+#endif
+}
+
+#if MODO_BENCHMARK_ISR
+/**
+ * Imprime el resultado del benchmark de ciclos
+ * Se compara compilando una vez con cada valor de MODO_ENTREGA_ISR
+ */
+static void imprimir_benchmark_isr(void)
+{
+    ESP_LOGI(TAG, "=== Benchmark ISR (%s) ===",
+             MODO_ENTREGA_ISR == ENTREGA_COLA ? "cola por LED" : "notificación directa");
+    if(duracion_isr.muestras > 0) {
+        ESP_LOGI(TAG, "Duración ISR: min=%" PRIu32 " prom=%" PRIu32 " max=%" PRIu32 " ciclos (%" PRIu32 " muestras)",
+                 duracion_isr.minimo, (uint32_t)(duracion_isr.suma / duracion_isr.muestras),
+                 duracion_isr.maximo, duracion_isr.muestras);
+    }
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        const estadistica_ciclos_t *e = &latencia_despertar[i];
+        if(e->muestras > 0) {
+            ESP_LOGI(TAG, "Latencia ISR->tarea botón %d: min=%" PRIu32 " prom=%" PRIu32 " max=%" PRIu32 " ciclos",
+                     i + 1, e->minimo, (uint32_t)(e->suma / e->muestras), e->maximo);
+        }
+    }
+}
+#endif
+
+#if MODO_SIMULACION
+// Número de pulsos simulados por botón
+#define SIM_PULSOS_POR_BOTON 2000
+
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+/**
+ * Presiona y suelta un botón simulado y espera a que el motor procese la presión
+ * 
+ * @param evento: Evento del botón
+ */
+static void pulsar_boton_simulado(evento_interrupcion_t evento)
+{
+    for(size_t i = 0; i < NUM_ENTRADAS; i++) {
+        if(config_botones[i].evento == evento) {
+            uint32_t antes = eventos_procesados[evento - 1];
+            gpio_set_level(config_botones[i].pin, 0);
+            gpio_set_level(config_botones[i].pin, 1);
+            while(eventos_procesados[evento - 1] == antes) {
+                vTaskDelay(1);
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));  // El motor aplica el evento después de contarlo
+            return;
+        }
+    }
+}
+
+/**
+ * Verifica el backend LEDC con el parpadeo de cada canal que lo usa
+ * Activa el patrón con su botón, lee del periférico la frecuencia y el duty
+ * programados y comprueba que el motor no quede con vencimientos ni despierte
+ * mientras el LED parpadea; luego lo apaga con otra presión
+ * 
+ * @return true si todos los canales LEDC reprodujeron su patrón sin costo de CPU
+ */
+static bool verificar_parpadeo_ledc(void)
+{
+    bool todo_ok = true;
+    
+    for(size_t c = 0; c < NUM_CANALES; c++) {
+        const config_canal_t *config = &config_canales[c];
+        int8_t ledc = estado_canales[c].ledc;
+        uint32_t frecuencia_hz, encendido_ms, periodo_ms;
+        if(ledc < 0 || !onda_periodica(config->patron, &frecuencia_hz, &encendido_ms, &periodo_ms)) {
+            continue;
+        }
+        
+        pulsar_boton_simulado(config->evento);
+        uint32_t duty_esperado = (uint32_t)(((uint64_t) encendido_ms << resolucion_ledc[ledc]) / periodo_ms);
+        uint32_t frecuencia = ledc_get_freq(LEDC_LOW_SPEED_MODE, ledc);
+        uint32_t duty = ledc_get_duty(LEDC_LOW_SPEED_MODE, ledc);
+        
+        // Mientras el LEDC parpadea el motor no debe despertar
+        uint32_t despertares_antes = despertares[0];
+        uint32_t programados = canales_programados;
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        uint32_t despertares_parpadeando = despertares[0] - despertares_antes;
+        
+        pulsar_boton_simulado(config->evento);
+        bool ok = frecuencia == frecuencia_hz && duty == duty_esperado &&
+                  programados == 0 && despertares_parpadeando == 0;
+#if CONFIG_IDF_TARGET_LINUX
+        // El modelo del periférico registra que la salida quedó detenida en bajo
+        ok = ok && !sim_ledc[ledc].salida_activa && sim_ledc[ledc].nivel_reposo == 0;
+#endif
+        
+        if(ok) {
+            ESP_LOGI(TAG, "LEDC LED %s OK: %" PRIu32 " Hz, duty %" PRIu32 "/%lu, 0 despertares en 1 s de parpadeo",
+                     config->nombre, frecuencia, duty, 1UL << resolucion_ledc[ledc]);
+        } else {
+            ESP_LOGE(TAG, "LEDC LED %s FALLIDO: %" PRIu32 " Hz (esperado %" PRIu32 "), duty %" PRIu32
+                     " (esperado %" PRIu32 "), programados=%" PRIu32 ", despertares=%" PRIu32,
+                     config->nombre, frecuencia, frecuencia_hz,
+                     duty, duty_esperado, programados, despertares_parpadeando);
+            todo_ok = false;
+        }
+    }
+    
+    return todo_ok;
+}
+#endif
+
+/**
+ * Tarea de simulación de interrupciones
+ * Genera pulsos intercalados en los tres botones llevando el pin a 0 y de vuelta
+ * a 1, espera a que las tareas vacíen sus colas y compara lo generado contra lo
+ * procesado por cada LED. Solo espera cuando la cola del dueño está llena, para
+ * medir pérdidas de enrutamiento y no de capacidad.
+ */
+static void tarea_simulacion_interrupciones(void *pvParameters)
+{
+    const gpio_num_t pines[NUM_BOTONES] = {BOTON_1_PIN, BOTON_2_PIN, BOTON_3_PIN};
+    uint32_t generados[NUM_BOTONES] = {0};
+    
+    ESP_LOGI(TAG, "Simulación: %d pulsos por botón", SIM_PULSOS_POR_BOTON);
+    
+    for(int n = 0; n < SIM_PULSOS_POR_BOTON; n++) {
+        for(int i = 0; i < NUM_BOTONES; i++) {
+            // Espera mientras el dueño tenga una cola llena de eventos sin procesar
+            while(eventos_entregados[i] - eventos_procesados[i] >= PROFUNDIDAD_COLA_LED) {
+                vTaskDelay(1);
+            }
+            gpio_set_level(pines[i], 0);    // Flanco descendente -> interrupción
+            gpio_set_level(pines[i], 1);    // Suelta el botón
+            generados[i]++;
+#if MODO_BENCHMARK_ISR
+            // Un evento a la vez para que la latencia medida corresponda a un solo pulso
+            while(eventos_procesados[i] != generados[i]) {
+                vTaskDelay(1);
+            }
+#endif
+        }
+    }
+    
+    // Espera a que todas las tareas consuman sus eventos
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        while(eventos_procesados[i] != eventos_entregados[i]) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    // Y a que el motor termine los patrones encolados
+    while(canales_programados != 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+#endif
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    uint32_t perdidos_total = 0;
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        uint32_t perdidos = generados[i] - eventos_procesados[i];
+        perdidos_total += perdidos;
+        ESP_LOGI(TAG, "Botón %d: generados=%" PRIu32 " entregados=%" PRIu32 " desbordados=%" PRIu32
+                 " procesados=%" PRIu32 " perdidos=%" PRIu32,
+                 i + 1, generados[i], eventos_entregados[i], eventos_desbordados[i],
+                 eventos_procesados[i], perdidos);
+    }
+    
+    if(perdidos_total == 0) {
+        ESP_LOGI(TAG, "Simulación OK: todos los eventos llegaron a su LED exactamente una vez");
+    } else {
+        ESP_LOGE(TAG, "Simulación FALLIDA: %" PRIu32 " eventos perdidos", perdidos_total);
+    }
+    
+    // Ventana sin presiones: ninguna tarea de LED debe despertar
+    // (el amarillo termina apagado porque recibió un número par de presiones)
+    uint32_t despertares_antes = 0, despertares_despues = 0;
+    for(int i = 0; i < NUM_TAREAS_LED; i++) {
+        despertares_antes += despertares[i];
+    }
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    for(int i = 0; i < NUM_TAREAS_LED; i++) {
+        despertares_despues += despertares[i];
+        ESP_LOGI(TAG, "Tarea LED %d: despertares=%" PRIu32 " ociosos=%" PRIu32 " pila libre mínima=%u B",
+                 i + 1, despertares[i], despertares_ociosos[i],
+                 (unsigned) uxTaskGetStackHighWaterMark(tareas_led[i]));
+    }
+    ESP_LOGI(TAG, "Despertares en 2 s sin presiones: %" PRIu32, despertares_despues - despertares_antes);
+    imprimir_presupuesto_ram();
+    
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    verificar_parpadeo_ledc();
+#endif
+    
+#if MODO_BENCHMARK_ISR
+    imprimir_benchmark_isr();
+#endif
+    
+    vTaskDelete(NULL);
+}
+#endif
+
+#if MODO_BENCHMARK_LATENCIA
+// ============================================================================
+// BENCHMARK DE LATENCIA FLANCO -> LED
+// ============================================================================
+// Una tarea de prioridad alta presiona el botón 1 simulado en instantes
+// aleatorios (ping-pong: espera la escritura del LED antes de la siguiente) y
+// repite la medición con una tarea de carga de CPU a distintas prioridades,
+// fijada al mismo núcleo que la ISR y las tareas de LED.
+
+#define PRIORIDAD_BENCH_LATENCIA  20    // Por encima de la carga para poder presionar siempre
+#define RAFAGA_CARGA_MS           8     // La carga ocupa la CPU y cede un tick
+#define LIMITE_P99_SIN_CARGA_US   1000  // Regresión si el p99 sin carga lo supera
+
+#if CONFIG_IDF_TARGET_LINUX
+#define CICLOS_POR_US  1000     // El contador del modelo cuenta nanosegundos
+#else
+#define CICLOS_POR_US  CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#endif
+
+// Escenarios de carga; prioridad 0 = sin carga
+typedef struct {
+    const char *nombre;
+    UBaseType_t prioridad;
+} escenario_carga_t;
+
+static const escenario_carga_t escenarios_carga[] = {
+    { "sin carga",                0 },
+    { "carga prio 5 (< LED)",     5 },
+    { "carga prio 10 (= LED)",   PRIORIDAD_TAREA_LED },
+    { "carga prio 15 (> LED)",   15 },
+};
+
+static const char *nombres_tramos[NUM_TRAMOS] = {
+    "ISR -> recepción", "recepción -> GPIO", "ISR -> GPIO"
+};
+
+/**
+ * Tarea de carga de CPU
+ * Gira RAFAGA_CARGA_MS sin bloquearse y cede un tick, así las tareas de menor
+ * prioridad (incluida la idle) siguen corriendo
+ */
+static void tarea_carga_cpu(void *pvParameters)
+{
+    while(1) {
+        int64_t fin = esp_timer_get_time() + RAFAGA_CARGA_MS * 1000;
+        while(esp_timer_get_time() < fin) {
+        }
+        vTaskDelay(1);
+    }
+}
+
+static int comparar_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Imprime mínimo, mediana, p99 y máximo de cada tramo y el histograma del total
+ * en cubetas de potencias de 2 microsegundos
+ * 
+ * @param n: Número de muestras
+ * @return p99 del tramo total en microsegundos
+ */
+static uint32_t imprimir_latencias(uint32_t n)
+{
+    uint32_t p99_total = 0;
+    
+    for(int t = 0; t < NUM_TRAMOS; t++) {
+        uint32_t *m = lat_muestras[t];
+        qsort(m, n, sizeof(uint32_t), comparar_u32);
+        uint32_t p99 = m[(n - 1) * 99 / 100];
+        ESP_LOGI(TAG, "  %s: min=%" PRIu32 ".%" PRIu32 " p50=%" PRIu32 ".%" PRIu32 " p99=%" PRIu32 ".%" PRIu32
+                 " max=%" PRIu32 ".%" PRIu32 " us", nombres_tramos[t],
+                 m[0] / CICLOS_POR_US, m[0] * 10 / CICLOS_POR_US % 10,
+                 m[n / 2] / CICLOS_POR_US, m[n / 2] * 10 / CICLOS_POR_US % 10,
+                 p99 / CICLOS_POR_US, p99 * 10 / CICLOS_POR_US % 10,
+                 m[n - 1] / CICLOS_POR_US, m[n - 1] * 10 / CICLOS_POR_US % 10);
+        if(t == TRAMO_TOTAL) {
+            p99_total = p99 / CICLOS_POR_US;
+        }
+    }
+    
+    // Histograma del total: cubeta k = [2^(k-1), 2^k) us, la cubeta 0 = menos de 1 us
+    uint32_t cubetas[24] = {0};
+    for(uint32_t i = 0; i < n; i++) {
+        uint32_t us = lat_muestras[TRAMO_TOTAL][i] / CICLOS_POR_US;
+        int k = 0;
+        while(us > 0 && k < 23) {
+            us >>= 1;
+            k++;
+        }
+        cubetas[k]++;
+    }
+    for(int k = 0; k < 24; k++) {
+        if(cubetas[k] == 0) {
+            continue;
+        }
+        char barra[41];
+        uint32_t largo = cubetas[k] * 40 / n;
+        memset(barra, '#', largo);
+        barra[largo] = '\0';
+        ESP_LOGI(TAG, "  [%6lu, %6lu) us %5" PRIu32 " %s", k == 0 ? 0UL : 1UL << (k - 1), 1UL << k,
+                 cubetas[k], barra);
+    }
+    
+    return p99_total;
+}
+
+/**
+ * Tarea del benchmark de latencia
+ * Corre BENCH_LAT_PULSOS presiones por escenario de carga e imprime el resultado
+ * 
+ * @param pvParameters: Núcleo de la ISR y las tareas de LED (donde se fija la carga)
+ */
+static void tarea_benchmark_latencia(void *pvParameters)
+{
+    const BaseType_t nucleo = (BaseType_t)(intptr_t) pvParameters;
+    
+    ESP_LOGI(TAG, "=== Benchmark de latencia flanco -> LED (%d presiones por escenario) ===",
+             BENCH_LAT_PULSOS);
+    
+    for(size_t e = 0; e < sizeof(escenarios_carga) / sizeof(escenarios_carga[0]); e++) {
+        const escenario_carga_t *esc = &escenarios_carga[e];
+        TaskHandle_t carga = NULL;
+        if(esc->prioridad > 0) {
+            xTaskCreatePinnedToCore(tarea_carga_cpu, "tarea_carga_cpu", 2048, NULL,
+                                    esc->prioridad, &carga, nucleo);
+        }
+        
+        lat_num_muestras = 0;
+        uint32_t perdidas = 0;
+        for(uint32_t n = 0; n < BENCH_LAT_PULSOS; n++) {
+            // Separación aleatoria de 1 a 3 ticks para no quedar en fase con la carga
+            vTaskDelay(1 + rand() % 3);
+            
+            gpio_set_level(BOTON_1_PIN, 0);    // Flanco descendente -> interrupción
+            gpio_set_level(BOTON_1_PIN, 1);    // Suelta el botón
+            
+            // Espera la escritura del LED; con la carga más alta puede tardar una ráfaga
+            int espera = 0;
+            while(lat_num_muestras == n && espera < 100) {
+                vTaskDelay(1);
+                espera++;
+            }
+            if(lat_num_muestras == n) {
+                perdidas++;
+                break;
+            }
+        }
+        
+        if(carga != NULL) {
+            vTaskDelete(carga);
+        }
+        
+        ESP_LOGI(TAG, "Escenario %s: %" PRIu32 " muestras", esc->nombre, lat_num_muestras);
+        if(lat_num_muestras == 0 || perdidas > 0) {
+            ESP_LOGE(TAG, "Benchmark FALLIDO: el LED no respondió a una presión");
+            continue;
+        }
+        uint32_t p99 = imprimir_latencias(lat_num_muestras);
+        
+        if(esc->prioridad == 0) {
+            if(p99 <= LIMITE_P99_SIN_CARGA_US) {
+                ESP_LOGI(TAG, "Latencia OK: p99 sin carga %" PRIu32 " us <= %d us", p99, LIMITE_P99_SIN_CARGA_US);
+            } else {
+                ESP_LOGE(TAG, "Latencia FALLIDA: p99 sin carga %" PRIu32 " us > %d us", p99, LIMITE_P99_SIN_CARGA_US);
+            }
+        }
+    }
+    
+    vTaskDelete(NULL);
+}
+#endif
+
+#if MODO_PRUEBA_REBOTES
+// ============================================================================
+// PRUEBA DEL ANTI-REBOTE CON TRAZAS SIMULADAS
+// ============================================================================
+// Cada traza es una lista de cambios de nivel con su instante en microsegundos y
+// la lista de presiones reales (intervalo en que el dedo estuvo sobre el botón).
+// Las mismas funciones antirrebote_flanco y antirrebote_asentar que usa la ISR
+// se alimentan con la traza y se comparan sus aceptaciones contra la verdad.
+
+#define MAX_CAMBIOS_TRAZA    4096
+#define MAX_PRESIONES_TRAZA  64
+
+typedef struct {
+    int64_t t_us;       // Instante del cambio
+    uint8_t nivel;      // Nivel de la línea después del cambio (0 = presionado)
+} cambio_linea_t;
+
+typedef struct {
+    const char *nombre;
+    cambio_linea_t cambios[MAX_CAMBIOS_TRAZA];
+    int num_cambios;
+    int64_t presion_inicio_us[MAX_PRESIONES_TRAZA];  // Primer contacto
+    int64_t presion_fin_us[MAX_PRESIONES_TRAZA];     // Último cambio de la liberación
+    int num_presiones;
+} traza_rebote_t;
+
+// Escenarios de la prueba
+typedef struct {
+    const char *nombre;
+    uint32_t presion_ms;        // Tiempo que se mantiene presionado
+    uint32_t separacion_ms;     // Tiempo entre presiones
+    uint32_t max_rebotes;       // Cambios extra en cada flanco (0 = línea limpia)
+    uint32_t max_rebote_us;     // Duración máxima de cada rebote
+    uint32_t glitches;          // Pulsos de ruido cortos entre presiones
+} escenario_rebote_t;
+
+static const escenario_rebote_t escenarios_rebote[] = {
+    { "limpio",        100, 300, 0,    0, 0 },
+    { "rebote",        100, 300, 8, 1500, 0 },
+    { "ruido",         100, 300, 2,  500, 3 },
+    { "rapido",         60,  80, 6, 1000, 0 },
+};
+
+// Estrategias evaluadas sobre cada escenario
+static const config_boton_t configs_prueba[] = {
+    { BOTON_1_PIN, EVENTO_BOTON_1, 200000, ANTIRREBOTE_FLANCO },
+    { BOTON_1_PIN, EVENTO_BOTON_1,  20000, ANTIRREBOTE_FLANCO },
+    { BOTON_1_PIN, EVENTO_BOTON_1,  20000, ANTIRREBOTE_ASENTAMIENTO },
+    { BOTON_1_PIN, EVENTO_BOTON_1,   5000, ANTIRREBOTE_ASENTAMIENTO },
+};
+
+#define NUM_ESCENARIOS_REBOTE  (sizeof(escenarios_rebote) / sizeof(escenarios_rebote[0]))
+#define NUM_CONFIGS_PRUEBA     (sizeof(configs_prueba) / sizeof(configs_prueba[0]))
+
+// Máximo de errores aceptado para cada escenario y estrategia
+typedef struct {
+    uint32_t falsos_aceptados;
+    uint32_t falsos_rechazados;
+} limite_rebote_t;
 
-// Máscara de bits para configuración GPIO de salida
-#define GPIO_OUTPUT_PIN_SEL ((1ULL<<LED_ROJO_PIN) | (1ULL<<LED_AMARILLO_PIN) | (1ULL<<LED_VERDE_PIN))
+// Las trazas son deterministas, así que los límites son exactos. El asentamiento
+// no puede fallar. Los flancos tienen sus errores conocidos: con 20 ms los rebotes
+// de la liberación pasan la ventana y cuentan como otra presión, y con 200 ms el
+// ruido aceptado tapa la presión real siguiente y las presiones rápidas se pierden
+static const limite_rebote_t limites_rebote[][NUM_CONFIGS_PRUEBA] = {
+    //  flanco 200 ms   flanco 20 ms   asent. 20 ms   asent. 5 ms
+    { {  0,  0 },      {   0, 0 },     { 0, 0 },      { 0, 0 } },     // limpio
+    { {  0,  0 },      {  54, 0 },     { 0, 0 },      { 0, 0 } },     // rebote
+    { { 64, 27 },      { 213, 0 },     { 0, 0 },      { 0, 0 } },     // ruido
+    { {  0, 24 },      {  43, 0 },     { 0, 0 },      { 0, 0 } },     // rapido
+};
+_Static_assert(sizeof(limites_rebote) / sizeof(limites_rebote[0]) == NUM_ESCENARIOS_REBOTE,
+               "Una fila de límites por escenario");
 
-// Máscara de bits para configuración GPIO de entrada
-#define GPIO_INPUT_PIN_SEL  ((1ULL<<BOTON_1_PIN) | (1ULL<<BOTON_2_PIN) | (1ULL<<BOTON_3_PIN))
+static traza_rebote_t traza_prueba;
+static uint32_t semilla_prueba;
 
-// Definición de eventos para la cola de interrupciones
-typedef enum {
-    EVENTO_BOTON_1 = 1,    // Evento del botón 1
-    EVENTO_BOTON_2,        // Evento del botón 2
-    EVENTO_BOTON_3         // Evento del botón 3
-} evento_interrupcion_t;
+// Generador pseudoaleatorio determinista para que la prueba sea repetible
+static uint32_t aleatorio_prueba(uint32_t maximo)
+{
+    semilla_prueba = semilla_prueba * 1103515245u + 12345u;
+    return maximo ? (semilla_prueba >> 8) % maximo : 0;
+}
 
-// Variables globales
-static QueueHandle_t cola_eventos_gpio = NULL;  // Cola para eventos de GPIO
-static bool led_amarillo_parpadeando = false;   // Estado del parpadeo LED amarillo
-static bool secuencia_verde_activa = false;     // Estado de secuencia LED verde
+static void agregar_cambio(traza_rebote_t *traza, int64_t t_us, uint8_t nivel)
+{
+    if(traza->num_cambios < MAX_CAMBIOS_TRAZA) {
+        traza->cambios[traza->num_cambios++] = (cambio_linea_t) { t_us, nivel };
+    }
+}
+
+// Flanco con rebote: la línea oscila antes de quedarse en el nivel final
+static int64_t agregar_flanco_con_rebote(traza_rebote_t *traza, const escenario_rebote_t *esc,
+                                         int64_t t_us, uint8_t nivel_final)
+{
+    agregar_cambio(traza, t_us, nivel_final);
+    uint32_t rebotes = aleatorio_prueba(esc->max_rebotes + 1) & ~1u;  // Par: termina en nivel_final
+    for(uint32_t i = 0; i < rebotes; i++) {
+        t_us += 20 + aleatorio_prueba(esc->max_rebote_us);
+        agregar_cambio(traza, t_us, (i % 2 == 0) ? !nivel_final : nivel_final);
+    }
+    return t_us;
+}
 
-// Variables para anti-rebote (debounce)
-static volatile uint32_t ultimo_tiempo_boton1 = 0;  // Último tiempo de presión botón 1
-static volatile uint32_t ultimo_tiempo_boton2 = 0;  // Último tiempo de presión botón 2
-static volatile uint32_t ultimo_tiempo_boton3 = 0;  // Último tiempo de presión botón 3
-static const uint32_t TIEMPO_DEBOUNCE_MS = 200;     // Tiempo mínimo entre presiones (200ms)
+static void generar_traza(traza_rebote_t *traza, const escenario_rebote_t *esc)
+{
+    traza->nombre = esc->nombre;
+    traza->num_cambios = 0;
+    traza->num_presiones = 0;
+    
+    int64_t t_us = 10000;
+    for(int p = 0; p < MAX_PRESIONES_TRAZA; p++) {
+        traza->presion_inicio_us[p] = t_us;
+        int64_t fin_presion = agregar_flanco_con_rebote(traza, esc, t_us, 0);
+        t_us = fin_presion + esc->presion_ms * 1000;
+        traza->presion_fin_us[p] = agregar_flanco_con_rebote(traza, esc, t_us, 1);
+        traza->num_presiones++;
+        
+        // Pulsos de ruido de 20 a 200 us repartidos en la separación
+        int64_t t_ruido = traza->presion_fin_us[p];
+        for(uint32_t g = 0; g < esc->glitches; g++) {
+            t_ruido += esc->separacion_ms * 1000 / (esc->glitches + 1);
+            agregar_cambio(traza, t_ruido, 0);
+            agregar_cambio(traza, t_ruido + 20 + aleatorio_prueba(180), 1);
+        }
+        t_us = traza->presion_fin_us[p] + esc->separacion_ms * 1000;
+    }
+}
+
+// Clasifica una aceptación: true si cae dentro de una presión real todavía no contada
+static bool clasificar_aceptacion(const traza_rebote_t *traza, bool *contada, int64_t t_us)
+{
+    for(int p = 0; p < traza->num_presiones; p++) {
+        if(t_us >= traza->presion_inicio_us[p] && t_us <= traza->presion_fin_us[p]) {
+            if(contada[p]) {
+                return false;   // Segunda aceptación de la misma presión
+            }
+            contada[p] = true;
+            return true;
+        }
+    }
+    return false;   // Aceptación fuera de cualquier presión (ruido)
+}
 
 /**
- * Rutina de Servicio de Interrupción (ISR) para GPIO
- * Esta función se ejecuta cuando ocurre una interrupción en cualquier GPIO configurado
- * Incluye lógica de anti-rebote por software
- * 
- * @param arg: Argumento pasado durante la instalación del ISR (número de pin)
+ * Reproduce una traza con una estrategia de anti-rebote
+ * El temporizador de asentamiento se modela como un vencimiento que se cancela
+ * si llega otro cambio antes.
  */
-static void IRAM_ATTR gpio_isr_handler(void* arg)
+static void evaluar_traza(const traza_rebote_t *traza, const config_boton_t *config,
+                          uint32_t *falsos_aceptados, uint32_t *falsos_rechazados)
 {
-    // Convierte el argumento a número de GPIO
-    uint32_t gpio_num = (uint32_t) arg;
-    evento_interrupcion_t evento;
-    
-    // Obtiene el tiempo actual en milisegundos (desde el arranque del sistema)
-    uint32_t tiempo_actual = xTaskGetTickCountFromISR() * portTICK_PERIOD_MS;
-    
-    // Variables para almacenar el último tiempo según el botón
-    volatile uint32_t* ultimo_tiempo;
+    estado_boton_t estado = {
+        .ultimo_aceptado_us = -(int64_t)config->ventana_us,
+        .presionado_estable = false
+    };
+    bool contada[MAX_PRESIONES_TRAZA] = {false};
+    uint8_t nivel = 1;
+    int64_t vencimiento = -1;
+    *falsos_aceptados = 0;
     
-    // Determina qué evento enviar y qué variable de tiempo usar según el pin
-    switch(gpio_num) {
-        case BOTON_1_PIN:
-            evento = EVENTO_BOTON_1;
-            ultimo_tiempo = &ultimo_tiempo_boton1;
-            break;
-        case BOTON_2_PIN:
-            evento = EVENTO_BOTON_2;
-            ultimo_tiempo = &ultimo_tiempo_boton2;
-            break;
-        case BOTON_3_PIN:
-            evento = EVENTO_BOTON_3;
-            ultimo_tiempo = &ultimo_tiempo_boton3;
+    for(int i = 0; i <= traza->num_cambios; i++) {
+        bool fin = (i == traza->num_cambios);
+        int64_t t_us = fin ? INT64_MAX : traza->cambios[i].t_us;
+        
+        // Vence el asentamiento pendiente antes de este cambio
+        if(vencimiento >= 0 && vencimiento <= t_us) {
+            if(antirrebote_asentar(&estado, nivel == 0) &&
+               !clasificar_aceptacion(traza, contada, vencimiento)) {
+                (*falsos_aceptados)++;
+            }
+            vencimiento = -1;
+        }
+        if(fin) {
             break;
-        default:
-            return;  // Pin no reconocido, salir de la ISR
+        }
+        
+        nivel = traza->cambios[i].nivel;
+        if(config->modo == ANTIRREBOTE_ASENTAMIENTO) {
+            vencimiento = t_us + config->ventana_us;
+        } else if(nivel == 0 && antirrebote_flanco(&estado, config, t_us) &&
+                  !clasificar_aceptacion(traza, contada, t_us)) {
+            (*falsos_aceptados)++;
+        }
     }
     
-    // Implementación de anti-rebote: verifica si ha pasado suficiente tiempo
-    if((tiempo_actual - *ultimo_tiempo) >= TIEMPO_DEBOUNCE_MS) {
-        
-        // Actualiza el tiempo de la última presión válida
-        *ultimo_tiempo = tiempo_actual;
-        
-        // Envía el evento a la cola desde la ISR
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        
-        // xQueueSendFromISR es la versión thread-safe para usar en ISRs
-        xQueueSendFromISR(cola_eventos_gpio, &evento, &xHigherPriorityTaskWoken);
-        
-        // Si una tarea de mayor prioridad fue desbloqueada, forzar cambio de contexto
-        if(xHigherPriorityTaskWoken) {
-            portYIELD_FROM_ISR();
+    *falsos_rechazados = 0;
+    for(int p = 0; p < traza->num_presiones; p++) {
+        if(!contada[p]) {
+            (*falsos_rechazados)++;
         }
     }
-    // Si no ha pasado suficiente tiempo, la interrupción se ignora (anti-rebote)
 }
 
 /**
- * Tarea para controlar el LED rojo
- * Maneja el encendido/apagado alternado del LED rojo
+ * Ejecuta todas las combinaciones escenario x estrategia, imprime la tabla y
+ * compara cada resultado contra limites_rebote
  */
-static void tarea_led_rojo(void *pvParameters)
+static void ejecutar_prueba_rebotes(void)
 {
-    ESP_LOGI(TAG, "Tarea LED Rojo iniciada");
+    uint32_t fallidos = 0;
     
-    // Estado inicial del LED rojo (apagado)
-    bool estado_led_rojo = false;
+    ESP_LOGI(TAG, "=== Prueba de anti-rebote con trazas simuladas ===");
     
-    // Bucle infinito de la tarea
-    while(1) {
-        evento_interrupcion_t evento_recibido;
-        
-        // Espera por eventos en la cola con timeout de 100ms
-        if(xQueueReceive(cola_eventos_gpio, &evento_recibido, pdMS_TO_TICKS(100))) {
+    for(size_t e = 0; e < NUM_ESCENARIOS_REBOTE; e++) {
+        for(size_t c = 0; c < NUM_CONFIGS_PRUEBA; c++) {
+            const config_boton_t *config = &configs_prueba[c];
+            const limite_rebote_t *limite = &limites_rebote[e][c];
             
-            // Procesa solo eventos del botón 1
-            if(evento_recibido == EVENTO_BOTON_1) {
-                
-                // Cambia el estado del LED (toggle)
-                estado_led_rojo = !estado_led_rojo;
-                
-                // Establece el nivel del GPIO según el nuevo estado
-                gpio_set_level(LED_ROJO_PIN, estado_led_rojo);
-                
-                // Log del cambio de estado
-                ESP_LOGI(TAG, "LED Rojo: %s", estado_led_rojo ? "ENCENDIDO" : "APAGADO");
-                
-                // NO reenvía el evento - lo consume completamente
+            // Misma semilla para cada estrategia: todas ven la misma traza
+            semilla_prueba = 1234 + e;
+            generar_traza(&traza_prueba, &escenarios_rebote[e]);
+            
+            uint32_t falsos_aceptados, falsos_rechazados;
+            evaluar_traza(&traza_prueba, config, &falsos_aceptados, &falsos_rechazados);
+            
+            bool ok = falsos_aceptados <= limite->falsos_aceptados &&
+                      falsos_rechazados <= limite->falsos_rechazados;
+            if(ok) {
+                ESP_LOGI(TAG, "%-7s %-12s %6" PRIu32 " us: presiones=%d falsos_aceptados=%" PRIu32
+                         " falsos_rechazados=%" PRIu32 ": OK",
+                         traza_prueba.nombre,
+                         config->modo == ANTIRREBOTE_FLANCO ? "flanco" : "asentamiento",
+                         config->ventana_us, traza_prueba.num_presiones,
+                         falsos_aceptados, falsos_rechazados);
+            } else {
+                ESP_LOGE(TAG, "%-7s %-12s %6" PRIu32 " us: presiones=%d falsos_aceptados=%" PRIu32
+                         " falsos_rechazados=%" PRIu32 ": FALLIDA (máximo %" PRIu32 "/%" PRIu32 ")",
+                         traza_prueba.nombre,
+                         config->modo == ANTIRREBOTE_FLANCO ? "flanco" : "asentamiento",
+                         config->ventana_us, traza_prueba.num_presiones,
+                         falsos_aceptados, falsos_rechazados,
+                         limite->falsos_aceptados, limite->falsos_rechazados);
+                fallidos++;
             }
-            // Si no es el evento para esta tarea, NO hace nada
-            // El evento se descarta y no se reenvía
         }
-        
-        // Pequeña pausa para permitir que otras tareas se ejecuten
-        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    if(fallidos == 0) {
+        ESP_LOGI(TAG, "Prueba de anti-rebote OK");
+    } else {
+        ESP_LOGE(TAG, "Prueba de anti-rebote FALLIDA: %" PRIu32 " combinaciones fuera de su límite", fallidos);
+    }
+}
+#endif
+
+#if MODO_PRUEBA_GESTOS
+// ============================================================================
+// PRUEBA DE LA MÁQUINA DE GESTOS CON LÍNEAS DE TIEMPO SINTÉTICAS
+// ============================================================================
+// Cada caso es una lista de cambios asentados (instante y nivel) y la lista de
+// gestos esperados con el instante en que deben emitirse. El temporizador se
+// modela como en la prueba de rebotes: el plazo vence antes del siguiente cambio
+// si llega primero. Cada caso corre dos veces, la segunda con el reloj a punto
+// de dar la vuelta para probar las restas en uint32_t.
+
+#define MAX_GESTOS_CASO  8
+
+typedef struct {
+    uint32_t t_ms;      // Instante del cambio
+    uint8_t nivel;      // Nivel de la línea después del cambio (0 = presionado)
+} cambio_gesto_t;
+
+typedef struct {
+    uint32_t t_ms;          // Instante en que se emite
+    tipo_gesto_t gesto;
+    uint16_t duracion_ms;
+} gesto_esperado_t;
+
+typedef struct {
+    const char *nombre;
+    const config_gestos_t *config;
+    const cambio_gesto_t *cambios;
+    int num_cambios;
+    const gesto_esperado_t *esperados;
+    int num_esperados;
+} caso_gesto_t;
+
+#define CASO_GESTO(nombre, config, cambios, esperados) \
+    { (nombre), (config), (cambios), sizeof(cambios) / sizeof((cambios)[0]), \
+      (esperados), sizeof(esperados) / sizeof((esperados)[0]) }
+
+static const config_gestos_t gestos_sin_doble = { 600000, 0, 150000 };
+static const config_gestos_t gestos_sin_repeticion = { 600000, 300000, 0 };
+
+// Con config_gestos: largo 600 ms, ventana de doble clic 300 ms, repetición 150 ms
+static const cambio_gesto_t cambios_corto[]       = { {0, 0}, {120, 1} };
+static const gesto_esperado_t esperados_corto[]   = { {420, GESTO_CORTO, 120} };
+
+static const cambio_gesto_t cambios_doble[]       = { {0, 0}, {100, 1}, {250, 0}, {330, 1} };
+static const gesto_esperado_t esperados_doble[]   = { {330, GESTO_DOBLE, 80} };
+
+static const cambio_gesto_t cambios_largo[]       = { {0, 0}, {700, 1} };
+static const gesto_esperado_t esperados_largo[]   = { {600, GESTO_LARGO, 600} };
+
+static const cambio_gesto_t cambios_repeticion[]  = { {0, 0}, {1000, 1} };
+static const gesto_esperado_t esperados_repeticion[] = {
+    {600, GESTO_LARGO, 600}, {750, GESTO_REPETICION, 750}, {900, GESTO_REPETICION, 900}
+};
+
+static const cambio_gesto_t cambios_clic_largo[]  = { {0, 0}, {100, 1}, {200, 0}, {1000, 1} };
+static const gesto_esperado_t esperados_clic_largo[] = {
+    {800, GESTO_CORTO, 100}, {800, GESTO_LARGO, 600}, {950, GESTO_REPETICION, 750}
+};
+
+static const cambio_gesto_t cambios_dos_cortos[]  = { {0, 0}, {100, 1}, {500, 0}, {600, 1} };
+static const gesto_esperado_t esperados_dos_cortos[] = { {400, GESTO_CORTO, 100}, {900, GESTO_CORTO, 100} };
+
+// La segunda presión llega justo al cerrar la ventana: ya no es doble clic
+static const cambio_gesto_t cambios_limite[]      = { {0, 0}, {100, 1}, {400, 0}, {450, 1} };
+static const gesto_esperado_t esperados_limite[]  = { {400, GESTO_CORTO, 100}, {750, GESTO_CORTO, 50} };
+
+static const cambio_gesto_t cambios_triple[]      = { {0, 0}, {100, 1}, {200, 0}, {300, 1}, {400, 0}, {500, 1} };
+static const gesto_esperado_t esperados_triple[]  = { {300, GESTO_DOBLE, 100}, {800, GESTO_CORTO, 100} };
+
+static const gesto_esperado_t esperados_sin_doble[] = { {120, GESTO_CORTO, 120} };
+
+static const caso_gesto_t casos_gesto[] = {
+    CASO_GESTO("corto",          &config_gestos,         cambios_corto,      esperados_corto),
+    CASO_GESTO("doble",          &config_gestos,         cambios_doble,      esperados_doble),
+    CASO_GESTO("largo",          &config_gestos,         cambios_largo,      esperados_largo),
+    CASO_GESTO("repeticion",     &config_gestos,         cambios_repeticion, esperados_repeticion),
+    CASO_GESTO("clic+largo",     &config_gestos,         cambios_clic_largo, esperados_clic_largo),
+    CASO_GESTO("dos cortos",     &config_gestos,         cambios_dos_cortos, esperados_dos_cortos),
+    CASO_GESTO("limite doble",   &config_gestos,         cambios_limite,     esperados_limite),
+    CASO_GESTO("triple",         &config_gestos,         cambios_triple,     esperados_triple),
+    CASO_GESTO("sin doble",      &gestos_sin_doble,      cambios_corto,      esperados_sin_doble),
+    CASO_GESTO("sin repeticion", &gestos_sin_repeticion, cambios_repeticion, esperados_largo),
+};
+
+static const char *nombres_gestos[NUM_GESTOS] = { "presion", "corto", "largo", "doble", "repeticion" };
+
+// Guarda los gestos emitidos con su instante relativo al inicio del caso
+static void anotar_gestos(gesto_esperado_t *emitidos, int *num_emitidos, const evento_boton_t *salida,
+                          int n, uint32_t t_us, uint32_t base_us)
+{
+    for(int i = 0; i < n && *num_emitidos < MAX_GESTOS_CASO; i++) {
+        emitidos[*num_emitidos].t_ms = (t_us - base_us) / 1000;
+        emitidos[*num_emitidos].gesto = salida[i].gesto;
+        emitidos[*num_emitidos].duracion_ms = salida[i].duracion_ms;
+        (*num_emitidos)++;
     }
 }
 
 /**
- * Tarea para controlar el LED amarillo
- * Maneja el parpadeo continuo del LED amarillo
+ * Reproduce un caso sobre la máquina de gestos y lo compara con lo esperado
+ * 
+ * @param caso: Caso a reproducir
+ * @param base_us: Instante del reloj que corresponde a t_ms = 0
+ * @return true si los gestos emitidos coinciden en tipo, duración e instante
  */
-static void tarea_led_amarillo(void *pvParameters)
+static bool ejecutar_caso_gesto(const caso_gesto_t *caso, uint32_t base_us)
 {
-    ESP_LOGI(TAG, "Tarea LED Amarillo iniciada");
+    estado_gesto_t g = { .fase = FASE_REPOSO };
+    gesto_esperado_t emitidos[MAX_GESTOS_CASO];
+    int num_emitidos = 0;
+    evento_boton_t salida[MAX_GESTOS_POR_PASO];
     
-    // Estado actual del LED durante el parpadeo
-    bool estado_parpadeo = false;
-    
-    // Bucle infinito de la tarea
-    while(1) {
-        evento_interrupcion_t evento_recibido;
+    for(int i = 0; i <= caso->num_cambios; i++) {
+        bool fin = (i == caso->num_cambios);
+        uint32_t t_us = fin ? 0 : base_us + caso->cambios[i].t_ms * 1000;
         
-        // Espera eventos con timeout de 500ms para permitir parpadeo
-        if(xQueueReceive(cola_eventos_gpio, &evento_recibido, pdMS_TO_TICKS(500))) {
-            
-            // Procesa eventos del botón 2
-            if(evento_recibido == EVENTO_BOTON_2) {
-                
-                // Cambia el estado del parpadeo
-                led_amarillo_parpadeando = !led_amarillo_parpadeando;
-                
-                ESP_LOGI(TAG, "Parpadeo LED Amarillo: %s", 
-                        led_amarillo_parpadeando ? "ACTIVADO" : "DESACTIVADO");
-                
-                // Si se desactiva el parpadeo, apaga el LED
-                if(!led_amarillo_parpadeando) {
-                    gpio_set_level(LED_AMARILLO_PIN, 0);
-                    estado_parpadeo = false;
-                }
-                
-                // NO reenvía el evento - lo consume completamente
-            }
-            // Si no es el evento para esta tarea, NO hace nada
-            // El evento se descarta y no se reenvía
+        // Vencimientos anteriores a este cambio; al final, los que queden (acotados
+        // por MAX_GESTOS_CASO si el caso termina con el botón presionado)
+        while(g.con_plazo && num_emitidos < MAX_GESTOS_CASO &&
+              (fin || (int32_t)(t_us - g.plazo_us) >= 0)) {
+            uint32_t plazo = g.plazo_us;
+            int n = gesto_vencimiento(&g, caso->config, plazo, salida);
+            anotar_gestos(emitidos, &num_emitidos, salida, n, plazo, base_us);
+        }
+        if(fin) {
+            break;
         }
         
-        // Lógica de parpadeo cuando está activado
-        if(led_amarillo_parpadeando) {
-            // Alterna el estado del LED
-            estado_parpadeo = !estado_parpadeo;
-            gpio_set_level(LED_AMARILLO_PIN, estado_parpadeo);
+        int n = gesto_cambio(&g, caso->config, caso->cambios[i].nivel == 0, t_us, salida);
+        anotar_gestos(emitidos, &num_emitidos, salida, n, t_us, base_us);
+    }
+    
+    bool ok = num_emitidos == caso->num_esperados;
+    for(int i = 0; ok && i < num_emitidos; i++) {
+        ok = emitidos[i].gesto == caso->esperados[i].gesto &&
+             emitidos[i].duracion_ms == caso->esperados[i].duracion_ms &&
+             emitidos[i].t_ms == caso->esperados[i].t_ms;
+    }
+    
+    if(!ok) {
+        for(int i = 0; i < num_emitidos; i++) {
+            ESP_LOGE(TAG, "  emitido: %s %u ms en t=%" PRIu32 " ms", nombres_gestos[emitidos[i].gesto],
+                     emitidos[i].duracion_ms, emitidos[i].t_ms);
         }
     }
+    return ok;
 }
 
 /**
- * Tarea para controlar el LED verde
- * Maneja una secuencia de parpadeo específica del LED verde
+ * Ejecuta todos los casos de gestos e imprime el resultado de cada uno
  */
-static void tarea_led_verde(void *pvParameters)
+static void ejecutar_prueba_gestos(void)
 {
-    ESP_LOGI(TAG, "Tarea LED Verde iniciada");
+    // Sin desplazamiento y con el reloj a 0.5 s de dar la vuelta
+    const uint32_t bases_us[] = { 0, UINT32_MAX - 500000 };
+    uint32_t fallidos = 0;
     
-    // Bucle infinito de la tarea
-    while(1) {
-        evento_interrupcion_t evento_recibido;
-        
-        // Espera por eventos con timeout de 100ms
-        if(xQueueReceive(cola_eventos_gpio, &evento_recibido, pdMS_TO_TICKS(100))) {
-            
-            // Procesa eventos del botón 3
-            if(evento_recibido == EVENTO_BOTON_3) {
-                
-                // Verifica que no hay otra secuencia en curso
-                if(!secuencia_verde_activa) {
-                    
-                    // Activa la bandera de secuencia
-                    secuencia_verde_activa = true;
-                    
-                    ESP_LOGI(TAG, "Secuencia LED Verde iniciada");
-                    
-                    // Ejecuta secuencia: 3 parpadeos rápidos
-                    for(int i = 0; i < 3; i++) {
-                        gpio_set_level(LED_VERDE_PIN, 1);    // Enciende LED
-                        vTaskDelay(pdMS_TO_TICKS(200));      // Espera 200ms
-                        gpio_set_level(LED_VERDE_PIN, 0);    // Apaga LED
-                        vTaskDelay(pdMS_TO_TICKS(200));      // Espera 200ms
-                    }
-                    
-                    // Pausa entre secuencias
-                    vTaskDelay(pdMS_TO_TICKS(1000));
-                    
-                    // Ejecuta secuencia: encendido prolongado
-                    gpio_set_level(LED_VERDE_PIN, 1);        // Enciende LED
-                    vTaskDelay(pdMS_TO_TICKS(2000));         // Mantiene encendido 2 segundos
-                    gpio_set_level(LED_VERDE_PIN, 0);        // Apaga LED
-                    
-                    // Marca el final de la secuencia
-                    secuencia_verde_activa = false;
-                    
-                    ESP_LOGI(TAG, "Secuencia LED Verde completada");
-                }
-                
-                // NO reenvía el evento - lo consume completamente
+    ESP_LOGI(TAG, "=== Prueba de gestos con líneas de tiempo sintéticas ===");
+    
+    for(size_t c = 0; c < sizeof(casos_gesto) / sizeof(casos_gesto[0]); c++) {
+        for(size_t b = 0; b < sizeof(bases_us) / sizeof(bases_us[0]); b++) {
+            bool ok = ejecutar_caso_gesto(&casos_gesto[c], bases_us[b]);
+            if(ok) {
+                ESP_LOGI(TAG, "%-14s base=%10" PRIu32 " us: OK (%d gestos)", casos_gesto[c].nombre,
+                         bases_us[b], casos_gesto[c].num_esperados);
+            } else {
+                ESP_LOGE(TAG, "%-14s base=%10" PRIu32 " us: FALLIDA", casos_gesto[c].nombre, bases_us[b]);
+                fallidos++;
             }
-            // Si no es el evento para esta tarea, NO hace nada
-            // El evento se descarta y no se reenvía
         }
-        
-        // Pequeña pausa para permitir que otras tareas se ejecuten
-        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    if(fallidos == 0) {
+        ESP_LOGI(TAG, "Prueba de gestos OK");
+    } else {
+        ESP_LOGE(TAG, "Prueba de gestos FALLIDA: %" PRIu32 " ejecuciones no coinciden", fallidos);
     }
 }
+#endif
+
+#if MODO_BENCHMARK_SALIDAS
+// ============================================================================
+// MICROBENCHMARK DE SALIDAS POR LOTES
+// ============================================================================
+#define BENCH_SALIDAS_ITERACIONES  10000
 
+#if CONFIG_IDF_TARGET_LINUX
 /**
- * Función para configurar los pines GPIO
- * Configura los pines de entrada (botones) y salida (LEDs)
+ * Cuenta las escrituras del modelo del registro que dejaron ver un estado de los
+ * LEDs que no era ni el de partida ni el pedido
+ * 
+ * @param escrituras_antes: sim_escrituras_salida antes de la actualización
+ * @param desde: Estado de los LEDs antes de actualizar
+ * @param hasta: Estado pedido
+ * @return Número de estados intermedios visibles
  */
-static void configurar_gpio(void)
+static uint32_t estados_intermedios(uint32_t escrituras_antes, uint32_t desde, uint32_t hasta)
 {
-    ESP_LOGI(TAG, "Configurando pines GPIO...");
-    
-    // Estructura de configuración para pines de salida (LEDs)
-    gpio_config_t io_conf_output = {};
-    
-    // Máscara de bits con los pines a configurar como salida
-    io_conf_output.pin_bit_mask = GPIO_OUTPUT_PIN_SEL;
+    uint32_t intermedios = 0;
+    for(uint32_t n = escrituras_antes; n < sim_escrituras_salida; n++) {
+        uint32_t estado = sim_traza_salida[n % SIM_TRAZA_SALIDA] & (uint32_t) GPIO_OUTPUT_PIN_SEL;
+        if(estado != desde && estado != hasta) {
+            intermedios++;
+        }
+    }
+    return intermedios;
+}
+#endif
+
+/**
+ * Compara escribir_leds contra gpio_set_level en un ciclo
+ * Mide los ciclos por actualización de los tres LEDs y, en el puerto Linux,
+ * verifica con el modelo del registro cuántos estados intermedios quedan visibles
+ */
+static void ejecutar_benchmark_salidas(void)
+{
+    const gpio_num_t leds[] = {LED_ROJO_PIN, LED_AMARILLO_PIN, LED_VERDE_PIN};
+    const uint32_t todos = (uint32_t) GPIO_OUTPUT_PIN_SEL;
     
-    // Configura como modo salida
-    io_conf_output.mode = GPIO_MODE_OUTPUT;
+    ESP_LOGI(TAG, "=== Benchmark de salidas (%d actualizaciones de 3 LEDs) ===", BENCH_SALIDAS_ITERACIONES);
     
-    // Deshabilita resistencia pull-up
-    io_conf_output.pull_up_en = GPIO_PULLUP_DISABLE;
+    // Una llamada al driver por LED
+    uint32_t inicio = esp_cpu_get_cycle_count();
+    for(int n = 0; n < BENCH_SALIDAS_ITERACIONES; n++) {
+        for(int i = 0; i < 3; i++) {
+            gpio_set_level(leds[i], n & 1);
+        }
+    }
+    uint32_t ciclos_driver = esp_cpu_get_cycle_count() - inicio;
     
-    // Deshabilita resistencia pull-down
-    io_conf_output.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    // Una escritura de registro por actualización
+    inicio = esp_cpu_get_cycle_count();
+    for(int n = 0; n < BENCH_SALIDAS_ITERACIONES; n++) {
+        escribir_leds(todos, (n & 1) ? todos : 0);
+    }
+    uint32_t ciclos_lote = esp_cpu_get_cycle_count() - inicio;
     
-    // Deshabilita interrupciones para salidas
-    io_conf_output.intr_type = GPIO_INTR_DISABLE;
+    ESP_LOGI(TAG, "gpio_set_level x3: %" PRIu32 " ciclos por actualización",
+             ciclos_driver / BENCH_SALIDAS_ITERACIONES);
+    ESP_LOGI(TAG, "escribir_leds:     %" PRIu32 " ciclos por actualización",
+             ciclos_lote / BENCH_SALIDAS_ITERACIONES);
     
-    // Aplica la configuración
-    ESP_ERROR_CHECK(gpio_config(&io_conf_output));
+#if CONFIG_IDF_TARGET_LINUX
+    // Todos los LEDs de apagado a encendido
+    escribir_leds(todos, 0);
+    uint32_t antes = sim_escrituras_salida;
+    for(int i = 0; i < 3; i++) {
+        gpio_set_level(leds[i], 1);
+    }
+    uint32_t intermedios_driver = estados_intermedios(antes, 0, todos);
     
-    // Estructura de configuración para pines de entrada (botones)
-    gpio_config_t io_conf_input = {};
+    escribir_leds(todos, 0);
+    antes = sim_escrituras_salida;
+    escribir_leds(todos, todos);
+    uint32_t escrituras_lote = sim_escrituras_salida - antes;
+    uint32_t intermedios_lote = estados_intermedios(antes, 0, todos);
     
-    // Máscara de bits con los pines a configurar como entrada
-    io_conf_input.pin_bit_mask = GPIO_INPUT_PIN_SEL;
+    // Cambio mixto: el rojo se enciende y el verde se apaga (una escritura por dirección)
+    const uint32_t rojo = 1UL << LED_ROJO_PIN, verde = 1UL << LED_VERDE_PIN;
+    escribir_leds(todos, verde);
+    antes = sim_escrituras_salida;
+    escribir_leds(rojo | verde, rojo);
+    uint32_t intermedios_mixto = estados_intermedios(antes, verde, rojo);
     
-    // Configura como modo entrada
-    io_conf_input.mode = GPIO_MODE_INPUT;
+    ESP_LOGI(TAG, "Estados intermedios visibles: gpio_set_level x3=%" PRIu32 ", escribir_leds=%" PRIu32
+             " (%" PRIu32 " escritura), escribir_leds mixto=%" PRIu32,
+             intermedios_driver, intermedios_lote, escrituras_lote, intermedios_mixto);
+    if(intermedios_lote == 0 && escrituras_lote == 1) {
+        ESP_LOGI(TAG, "Escritura por lotes OK: los LEDs que cambian juntos cambian en una sola escritura");
+    } else {
+        ESP_LOGE(TAG, "Escritura por lotes FALLIDA: la actualización no fue atómica");
+    }
+#endif
+}
+#endif
+
+#if MODO_BENCHMARK_REGISTRO
+// ============================================================================
+// BENCHMARK DEL REGISTRO DIFERIDO
+// ============================================================================
+// Cada variante corre en su propia tarea con la misma pila, así la marca de agua
+// de la pila corresponde solo a esa forma de registrar. Se hacen menos llamadas
+// que la capacidad del anillo para medir el camino normal y no el de descarte.
+
+#define BENCH_REGISTRO_LLAMADAS  (REGISTRO_CAPACIDAD / 2)
+#define PILA_BENCH_REGISTRO      4096
+
+typedef struct {
+    bool diferido;                  // Variante: registro diferido o ESP_LOGI
+    uint32_t ciclos_total;
+    uint32_t ciclos_max;
+    UBaseType_t pila_libre;         // Marca de agua al terminar
+    TaskHandle_t quien_espera;      // Se le notifica al terminar
+} resultado_bench_registro_t;
+
+/**
+ * Tarea del benchmark del registro
+ * Hace las llamadas con el mismo mensaje que la tarea del LED rojo
+ * 
+ * @param pvParameters: resultado_bench_registro_t de la variante
+ */
+static void tarea_bench_registro(void *pvParameters)
+{
+    resultado_bench_registro_t *res = pvParameters;
     
-    // Habilita resistencia pull-up interna (botón conectado a GND)
-    io_conf_input.pull_up_en = GPIO_PULLUP_ENABLE;
+    for(int i = 0; i < BENCH_REGISTRO_LLAMADAS; i++) {
+        const char *estado = (i & 1) ? "ENCENDIDO" : "APAGADO";
+        uint32_t inicio = esp_cpu_get_cycle_count();
+        if(res->diferido) {
+            REGISTRAR_DIFERIDO("LED Rojo: %s", estado);
+        } else {
+            ESP_LOGI(TAG, "LED Rojo: %s", estado);
+        }
+        uint32_t ciclos = esp_cpu_get_cycle_count() - inicio;
+        res->ciclos_total += ciclos;
+        if(ciclos > res->ciclos_max) {
+            res->ciclos_max = ciclos;
+        }
+    }
     
-    // Deshabilita resistencia pull-down
-    io_conf_input.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    res->pila_libre = uxTaskGetStackHighWaterMark(NULL);
+    xTaskNotifyGive(res->quien_espera);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Compara ESP_LOGI contra el registro diferido: ciclos por llamada y pila usada
+ */
+static void ejecutar_benchmark_registro(void)
+{
+    resultado_bench_registro_t resultados[] = {
+        { .diferido = false },
+        { .diferido = true },
+    };
     
-    // Configura interrupción en flanco descendente (presión del botón)
-    io_conf_input.intr_type = GPIO_INTR_NEGEDGE;
+    ESP_LOGI(TAG, "=== Benchmark de registro: %d llamadas por variante ===", BENCH_REGISTRO_LLAMADAS);
     
-    // Aplica la configuración
-    ESP_ERROR_CHECK(gpio_config(&io_conf_input));
+    for(size_t i = 0; i < sizeof(resultados) / sizeof(resultados[0]); i++) {
+        resultados[i].quien_espera = xTaskGetCurrentTaskHandle();
+        xTaskCreate(tarea_bench_registro, "bench_registro", PILA_BENCH_REGISTRO, &resultados[i],
+                    PRIORIDAD_TAREA_LED, NULL);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
     
-    ESP_LOGI(TAG, "Configuración GPIO completada");
+    for(size_t i = 0; i < sizeof(resultados) / sizeof(resultados[0]); i++) {
+        const resultado_bench_registro_t *res = &resultados[i];
+        ESP_LOGI(TAG, "%-9s: prom=%" PRIu32 " max=%" PRIu32 " ciclos por llamada, pila usada %u de %u B",
+                 res->diferido ? "diferido" : "ESP_LOGI",
+                 res->ciclos_total / BENCH_REGISTRO_LLAMADAS, res->ciclos_max,
+                 (unsigned)(PILA_BENCH_REGISTRO - res->pila_libre), (unsigned) PILA_BENCH_REGISTRO);
+    }
 }
+#endif
+
+#if MODO_PERFIL_PILAS
+// ============================================================================
+// PERFIL DE PILAS
+// ============================================================================
+// Después de PERFIL_DURACION_MS de trabajo normal se lee la marca de agua de cada
+// tarea (lo mínimo que le quedó libre) y se imprime un header con la pila usada
+// más un margen, entre dos marcas para copiarlo junto a este archivo. En el
+// puerto Linux además se escribe directo en el directorio de trabajo.
+// Solo cuenta lo que se ejecutó: durante la medición hay que usar los botones
+// (o MODO_SIMULACION) y los mismos modos que se van a compilar después
+// El margen y el generador del header están en perfil_pilas.h
+
+#define ARCHIVO_PILAS             "pilas_leds.h"
+
+#include "perfil_pilas.h"
 
 /**
- * Función para configurar las interrupciones GPIO
- * Instala el servicio de interrupciones y asocia handlers
+ * Espera a que el programa trabaje un rato, mide las pilas y publica el header
+ * Las tareas de LED comparten PILA_TAREA_LED: cuenta la que menos pila dejó libre
  */
-static void configurar_interrupciones(void)
+static void tarea_perfil_pilas(void *pvParameters)
 {
-    ESP_LOGI(TAG, "Configurando interrupciones GPIO...");
-    
-    // Instala el servicio de interrupciones GPIO
-    // ESP_INTR_FLAG_DEFAULT: usa la prioridad por defecto
-    ESP_ERROR_CHECK(gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT));
+    perfil_pila_t perfiles[2];
+    size_t n = 0;
     
-    // Asocia el handler de interrupción al botón 1
-    ESP_ERROR_CHECK(gpio_isr_handler_add(BOTON_1_PIN, gpio_isr_handler, (void*) BOTON_1_PIN));
+    vTaskDelay(pdMS_TO_TICKS(PERFIL_DURACION_MS));
     
-    // Asocia el handler de interrupción al botón 2
-    ESP_ERROR_CHECK(gpio_isr_handler_add(BOTON_2_PIN, gpio_isr_handler, (void*) BOTON_2_PIN));
+    perfiles[n++] = (perfil_pila_t) { "PILA_TAREA_LED", PILA_TAREA_LED,
+                                      libre_minimo_pilas(tareas_led, NUM_TAREAS_LED, PILA_TAREA_LED),
+                                      NUM_TAREAS_LED };
+#if MODO_REGISTRO_DIFERIDO
+    perfiles[n++] = (perfil_pila_t) { "PILA_DRENADO", PILA_DRENADO, uxTaskGetStackHighWaterMark(tarea_drenado), 1 };
+#endif
     
-    // Asocia el handler de interrupción al botón 3
-    ESP_ERROR_CHECK(gpio_isr_handler_add(BOTON_3_PIN, gpio_isr_handler, (void*) BOTON_3_PIN));
-    
-    ESP_LOGI(TAG, "Interrupciones GPIO configuradas correctamente");
+    publicar_header_pilas(ARCHIVO_PILAS,
+                          MODO_LEDS == LEDS_MOTOR_PATRONES ? "motor de patrones" : "una tarea por LED",
+                          perfiles, n);
+    vTaskDelete(NULL);
+}
+#endif
+
+#if MODO_ESTATICO
+// ============================================================================
+// MEMORIA ESTÁTICA
+// ============================================================================
+// Toda la memoria de las colas y tareas del programa, con los mismos tamaños que
+// usa el modo dinámico. La RAM queda en .bss y se conoce al enlazar; las APIs
+// ...Static no pueden fallar con buffers válidos. Los esp_timer del antirrebote
+// y de los gestos no tienen versión estática y siguen saliendo del heap.
+
+#if MODO_ENTREGA_ISR == ENTREGA_COLA
+// El motor usa todo el almacén en una cola; la tarea por LED, una porción por cola
+static uint8_t almacen_colas_led[NUM_BOTONES * PROFUNDIDAD_COLA_LED * sizeof(evento_boton_t)];
+static StaticQueue_t estructuras_cola_led[NUM_BOTONES];
+#endif
+
+static StackType_t pilas_tareas_led[NUM_TAREAS_LED][PILA_TAREA_LED];
+static StaticTask_t tcbs_tareas_led[NUM_TAREAS_LED];
+
+#if MODO_REGISTRO_DIFERIDO
+static StackType_t pila_drenado[PILA_DRENADO];
+static StaticTask_t tcb_drenado;
+#endif
+#endif
+
+/**
+ * Crea una tarea que consume eventos de botón
+ * En modo estático usa la pila y el TCB de su índice y no puede fallar
+ * 
+ * @param funcion: Función de la tarea
+ * @param nombre: Nombre de la tarea
+ * @param indice: Índice de la tarea (0 a NUM_TAREAS_LED - 1)
+ * @param nucleo: Núcleo donde fijarla o tskNO_AFFINITY
+ * @return Handle de la tarea (NULL si no hubo memoria en modo dinámico)
+ */
+static TaskHandle_t crear_tarea_led(TaskFunction_t funcion, const char *nombre, int indice, BaseType_t nucleo)
+{
+#if MODO_ESTATICO
+    return xTaskCreateStaticPinnedToCore(funcion, nombre, PILA_TAREA_LED, NULL, PRIORIDAD_TAREA_LED,
+                                         pilas_tareas_led[indice], &tcbs_tareas_led[indice], nucleo);
+#else
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(funcion, nombre, PILA_TAREA_LED, NULL, PRIORIDAD_TAREA_LED, &handle, nucleo);
+    return handle;
+#endif
 }
 
 /**
@@ -333,19 +3088,92 @@ static void configurar_interrupciones(void)
  */
 void app_main(void)
 {
+    arranque_app_main_us = (uint32_t) esp_timer_get_time();
     ESP_LOGI(TAG, "=== Iniciando Práctica 3.1: Control de LEDs e Interrupciones ===");
     
-    // Crea la cola para eventos de GPIO
-    // Capacidad: 10 elementos, tamaño: sizeof(evento_interrupcion_t)
-    cola_eventos_gpio = xQueueCreate(10, sizeof(evento_interrupcion_t));
+#if MODO_PRUEBA_REBOTES
+    // Solo se corre la prueba del anti-rebote, sin hardware ni tareas
+    ejecutar_prueba_rebotes();
+    return;
+#endif
+    
+#if MODO_PRUEBA_GESTOS
+    // Solo se corre la prueba de la máquina de gestos, sin hardware ni tareas
+    ejecutar_prueba_gestos();
+    return;
+#endif
+    
+#if MODO_BENCHMARK_SALIDAS
+    // Solo se corre el benchmark de salidas sobre los LEDs, sin interrupciones ni tareas
+    configurar_gpio();
+    ejecutar_benchmark_salidas();
+    return;
+#endif
+    
+#if MODO_REGISTRO_DIFERIDO && MODO_ESTATICO
+    // Prioridad mínima: los registros se escriben cuando no hay nada más que hacer
+    tarea_drenado = xTaskCreateStatic(tarea_drenado_registro, "drenado_registro", PILA_DRENADO, NULL,
+                                      1, pila_drenado, &tcb_drenado);
+#elif MODO_REGISTRO_DIFERIDO || MODO_BENCHMARK_REGISTRO
+    // Prioridad mínima: los registros se escriben cuando no hay nada más que hacer
+    xTaskCreate(tarea_drenado_registro, "drenado_registro", PILA_DRENADO, NULL,
+                1, &tarea_drenado);
+#endif
     
-    // Verifica que la cola se haya creado correctamente
-    if(cola_eventos_gpio == NULL) {
-        ESP_LOGE(TAG, "Error: No se pudo crear la cola de eventos GPIO");
+#if MODO_BENCHMARK_REGISTRO
+    // Solo se corre el benchmark del registro, sin hardware ni tareas de LED
+    ejecutar_benchmark_registro();
+    return;
+#endif
+    
+    size_t heap_antes = esp_get_free_heap_size();
+    
+#if MODO_ENTREGA_ISR == ENTREGA_COLA && MODO_ESTATICO
+    // Colas en memoria estática: sin heap y sin caminos de error
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    colas_led[0] = xQueueCreateStatic(NUM_BOTONES * PROFUNDIDAD_COLA_LED, sizeof(evento_boton_t),
+                                      almacen_colas_led, &estructuras_cola_led[0]);
+    for(int i = 1; i < NUM_BOTONES; i++) {
+        colas_led[i] = colas_led[0];
+    }
+#else
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        colas_led[i] = xQueueCreateStatic(PROFUNDIDAD_COLA_LED, sizeof(evento_boton_t),
+                                          &almacen_colas_led[i * PROFUNDIDAD_COLA_LED * sizeof(evento_boton_t)],
+                                          &estructuras_cola_led[i]);
+    }
+#endif
+    
+    ESP_LOGI(TAG, "Colas de eventos GPIO creadas en memoria estática");
+#elif MODO_ENTREGA_ISR == ENTREGA_COLA && MODO_LEDS == LEDS_MOTOR_PATRONES
+    // Una sola cola para el motor de patrones, con lugar para la cola de cada botón
+    colas_led[0] = xQueueCreate(NUM_BOTONES * PROFUNDIDAD_COLA_LED, sizeof(evento_boton_t));
+    if(colas_led[0] == NULL) {
+        ESP_LOGE(TAG, "Error: No se pudo crear la cola de eventos del motor de patrones");
         return;
     }
+    for(int i = 1; i < NUM_BOTONES; i++) {
+        colas_led[i] = colas_led[0];
+    }
     
     ESP_LOGI(TAG, "Cola de eventos GPIO creada exitosamente");
+#elif MODO_ENTREGA_ISR == ENTREGA_COLA
+    // Crea una cola de eventos por LED
+    // Capacidad: 10 elementos cada una, tamaño: sizeof(evento_boton_t)
+    for(int i = 0; i < NUM_BOTONES; i++) {
+        colas_led[i] = xQueueCreate(PROFUNDIDAD_COLA_LED, sizeof(evento_boton_t));
+        
+        // Verifica que la cola se haya creado correctamente
+        if(colas_led[i] == NULL) {
+            ESP_LOGE(TAG, "Error: No se pudo crear la cola de eventos del LED %d", i + 1);
+            return;
+        }
+    }
+    
+    ESP_LOGI(TAG, "Colas de eventos GPIO creadas exitosamente");
+#else
+    ESP_LOGI(TAG, "Entrega de eventos por notificación directa a las tareas");
+#endif
     
     // Configura los pines GPIO
     configurar_gpio();
@@ -353,34 +3181,82 @@ void app_main(void)
     // Configura las interrupciones
     configurar_interrupciones();
     
-    // Establece estado inicial de todos los LEDs (apagados)
-    gpio_set_level(LED_ROJO_PIN, 0);
-    gpio_set_level(LED_AMARILLO_PIN, 0);
-    gpio_set_level(LED_VERDE_PIN, 0);
+#if USAR_SUENO_LIGERO
+    // Configura el sueño ligero y los botones como fuente de despertar
+    configurar_bajo_consumo();
+#endif
     
-    // Inicializa las variables de tiempo para anti-rebote
-    ultimo_tiempo_boton1 = 0;
-    ultimo_tiempo_boton2 = 0;
-    ultimo_tiempo_boton3 = 0;
+    // Establece estado inicial de todos los LEDs (apagados) en una sola escritura
+    escribir_leds(GPIO_OUTPUT_PIN_SEL, 0);
     
     ESP_LOGI(TAG, "Estado inicial de LEDs establecido (todos apagados)");
-    ESP_LOGI(TAG, "Sistema anti-rebote configurado con %lu ms de retardo", TIEMPO_DEBOUNCE_MS);
     
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    // Conecta al LEDC los canales que parpadean por hardware
+    configurar_salidas_led();
+#endif
+    
+    // En el benchmark las tareas se fijan al núcleo que atiende la ISR, porque el
+    // contador de ciclos de cada núcleo es independiente
+#if MODO_BENCHMARK_ISR || MODO_BENCHMARK_LATENCIA
+    const BaseType_t nucleo_tareas = xPortGetCoreID();
+#else
+    const BaseType_t nucleo_tareas = tskNO_AFFINITY;
+#endif
+    
+#if MODO_LEDS == LEDS_MOTOR_PATRONES
+    // Crea la única tarea que reproduce los patrones de todos los LEDs
+    // Parámetros: función, nombre, índice de la tarea, núcleo
+    // Es la dueña de todos los botones: la ISR la notifica con el bit de cada uno
+    tareas_led[0] = crear_tarea_led(tarea_motor_patrones, "tarea_motor_patrones", 0, nucleo_tareas);
+    for(int i = 1; i < NUM_BOTONES; i++) {
+        tareas_led[i] = tareas_led[0];
+    }
+#else
     // Crea la tarea para controlar el LED rojo
-    // Parámetros: función, nombre, stack size, parámetros, prioridad, handle
-    xTaskCreate(tarea_led_rojo, "tarea_led_rojo", 2048, NULL, 10, NULL);
+    // Parámetros: función, nombre, índice de la tarea, núcleo
+    // El handle se guarda para que la ISR pueda notificar a la tarea dueña
+    tareas_led[EVENTO_BOTON_1 - 1] = crear_tarea_led(tarea_led_rojo, "tarea_led_rojo", EVENTO_BOTON_1 - 1,
+                                                     nucleo_tareas);
     
     // Crea la tarea para controlar el LED amarillo
-    xTaskCreate(tarea_led_amarillo, "tarea_led_amarillo", 2048, NULL, 10, NULL);
+    tareas_led[EVENTO_BOTON_2 - 1] = crear_tarea_led(tarea_led_amarillo, "tarea_led_amarillo", EVENTO_BOTON_2 - 1,
+                                                     nucleo_tareas);
     
     // Crea la tarea para controlar el LED verde
-    xTaskCreate(tarea_led_verde, "tarea_led_verde", 2048, NULL, 10, NULL);
+    tareas_led[EVENTO_BOTON_3 - 1] = crear_tarea_led(tarea_led_verde, "tarea_led_verde", EVENTO_BOTON_3 - 1,
+                                                     nucleo_tareas);
+#endif
+    
+    imprimir_presupuesto_ram();
+    ESP_LOGI(TAG, "Arranque (memoria %s): objetos creados a los %" PRIu32 " us, heap usado %ld B",
+             MODO_ESTATICO ? "estática" : "dinámica", (uint32_t) esp_timer_get_time(),
+             (long) heap_antes - (long) esp_get_free_heap_size());
     
     ESP_LOGI(TAG, "Todas las tareas creadas. Sistema listo para uso.");
     ESP_LOGI(TAG, "Presiona los botones para controlar los LEDs:");
     ESP_LOGI(TAG, "  - Botón 1: Alternar LED rojo");
     ESP_LOGI(TAG, "  - Botón 2: Activar/desactivar parpadeo LED amarillo");
     ESP_LOGI(TAG, "  - Botón 3: Ejecutar secuencia en LED verde");
+#if MODO_GESTOS
+    ESP_LOGI(TAG, "  - Botón 1 doble clic: parpadeo rojo; presión larga: apagar rojo");
+    ESP_LOGI(TAG, "  - Botón 2 presión larga: LED amarillo fijo");
+    ESP_LOGI(TAG, "  - Botón 3 mantenido: encola una secuencia verde por repetición");
+#endif
+    
+#if MODO_BENCHMARK_LATENCIA
+    // El benchmark reemplaza a la simulación; la carga se fija al núcleo de las tareas de LED
+    xTaskCreate(tarea_benchmark_latencia, "tarea_bench_latencia", 4096,
+                (void*)(intptr_t) nucleo_tareas, PRIORIDAD_BENCH_LATENCIA, NULL);
+#elif MODO_SIMULACION
+    // Prioridad menor que las tareas de LED para que consuman en cuanto llega el evento
+    xTaskCreate(tarea_simulacion_interrupciones, "tarea_simulacion", 3072, NULL, 5, NULL);
+#endif
+    
+#if MODO_PERFIL_PILAS
+    // Prioridad baja: mide cuando el resto del programa ya trabajó
+    xTaskCreate(tarea_perfil_pilas, "tarea_perfil_pilas", PILA_PERFIL, NULL, 1, NULL);
+#endif
     
     // La tarea principal termina aquí, FreeRTOS continúa ejecutando las otras tareas
 }
\ No newline at end of file
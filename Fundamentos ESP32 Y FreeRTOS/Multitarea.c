@@ -1,12 +1,19 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/timers.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "driver/gpio.h"
+#endif
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 // Definición de constantes
 #define LED_GPIO_PIN        GPIO_NUM_2      // Pin del LED integrado
@@ -15,17 +22,334 @@
 #define TASK_PRIORITY_MED   2               // Prioridad media  
 #define TASK_PRIORITY_LOW   1               // Prioridad baja
 
+// Registro diferido: los logs de los lazos guardan formato y argumentos crudos en
+// un anillo por núcleo y una tarea de prioridad mínima los escribe (0 = ESP_LOGI directo)
+#define MODO_REGISTRO_DIFERIDO  0
+
+// Implementación del contador global
+#define CONTADOR_MUTEX        0   // Variable protegida por mutex (un incremento puede perderse)
+#define CONTADOR_ATOMICO      1   // Un entero con operaciones atómicas
+#define CONTADOR_FRAGMENTADO  2   // Una ranura atómica por núcleo, la lectura las suma
+#define MODO_CONTADOR         CONTADOR_FRAGMENTADO
+
+// Benchmark de contención: varias tareas repartidas entre los núcleos incrementan
+// el mismo contador con cada implementación (no arranca las tareas de la práctica)
+#define MODO_BENCHMARK_CONTADOR  0
+
+// Estadísticas del sistema: el monitor toma una instantánea con uxTaskGetSystemState
+// (CPU por tarea, pila, núcleo, estado y fragmentación del heap) y la publica
+// como un registro binario que cualquier tarea lee sin bloqueos
+#define MODO_ESTADISTICAS  0
+
+// Benchmark de ubicación: mide latencia de despertar y rendimiento con cada
+// política de núcleos para las tareas de la práctica (no arranca las tareas)
+#define MODO_BENCHMARK_UBICACION  0
+
+// Memoria estática: tareas y mutex con las APIs ...Static y buffers reservados al
+// enlazar, sin heap ni caminos de error al crearlos (0 = memoria dinámica)
+#define MODO_ESTATICO  0
+
+// Trabajos periódicos: el LED, el monitor y el aviso de app_main corren desde
+// temporizadores de FreeRTOS. El LED y el aviso dejan de ser tareas y corren en la
+// tarea de los temporizadores; el monitor se puede bloquear, así que conserva su
+// tarea y el temporizador solo la despierta (0 = tareas)
+#define MODO_TRABAJOS_PERIODICOS  1
+
+// Benchmark de periodos: el mismo trabajo con una tarea y vTaskDelay, en un
+// temporizador y en una tarea despertada por el temporizador (no arranca la práctica)
+#define MODO_BENCHMARK_PERIODICOS  0
+
+// Bajo consumo: todos los periodos parten del mismo tick para que sus despertares
+// coincidan y el chip duerme en sueño ligero entre ellos (tickless idle).
+// Requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE en menuconfig
+#define MODO_BAJO_CONSUMO  0
+
+// Con trabajos periódicos el LED de tabla_tareas no tiene tarea; el monitor y el
+// contador siempre la tienen
+#define LED_CON_TAREA       (!MODO_TRABAJOS_PERIODICOS)
+
+// Perfil de mutex: histogramas de espera y de retención de counter_mutex, timeouts
+// y qué tarea lo tenía cuando otra tuvo que esperarlo (requiere CONTADOR_MUTEX)
+#define MODO_PERFIL_MUTEX  0
+
+// Traza del planificador: los ganchos de traza_freertos.h anotan cambios de tarea,
+// colas, semáforos e ISRs en un anillo; a los TRAZA_DURACION_MS se vuelca para
+// convertir_traza.py (FreeRTOS se compila con -include traza_freertos.h)
+#define MODO_TRAZA  0
+
+// Perfil de pilas: corre la práctica PERFIL_DURACION_MS, lee la marca de agua de
+// cada tarea e imprime pilas_multitarea.h con lo usado más un margen
+#define MODO_PERFIL_PILAS  0
+
+// Pila de cada tarea: la del header generado por MODO_PERFIL_PILAS si está junto a
+// este archivo; al perfilar se ignora para medir siempre con las pilas por defecto
+#if __has_include("pilas_multitarea.h") && !MODO_PERFIL_PILAS
+#include "pilas_multitarea.h"
+#endif
+#ifndef PILA_LED_TASK
+#define PILA_LED_TASK       STACK_SIZE
+#endif
+#ifndef PILA_COUNTER_TASK
+#define PILA_COUNTER_TASK   STACK_SIZE
+#endif
+#ifndef PILA_MONITOR_TASK
+#define PILA_MONITOR_TASK   STACK_SIZE
+#endif
+
+#if MODO_ESTATICO && !configSUPPORT_STATIC_ALLOCATION
+#error "MODO_ESTATICO requiere configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+#if MODO_PERFIL_MUTEX && MODO_CONTADOR != CONTADOR_MUTEX
+#error "MODO_PERFIL_MUTEX perfila counter_mutex, que solo existe con CONTADOR_MUTEX"
+#endif
+
+#if MODO_ESTADISTICAS && !(configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS)
+#error "MODO_ESTADISTICAS requiere CONFIG_FREERTOS_USE_TRACE_FACILITY y CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS"
+#endif
+
+// En el puerto Linux no hay sueño ligero; ahí el modo solo alinea los periodos
+#define USAR_SUENO_LIGERO  (MODO_BAJO_CONSUMO && !CONFIG_IDF_TARGET_LINUX)
+
+#if USAR_SUENO_LIGERO && !(CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#error "MODO_BAJO_CONSUMO requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE"
+#endif
+
+#if USAR_SUENO_LIGERO
+#include "esp_pm.h"                   // Gestión de energía (sueño ligero automático)
+#endif
+
+#if MODO_TRAZA && !defined(TRAZA_FREERTOS_H)
+#error "MODO_TRAZA requiere compilar FreeRTOS y el programa con -include traza_freertos.h"
+#endif
+
+#if MODO_TRAZA && !configUSE_TRACE_FACILITY
+#error "MODO_TRAZA requiere CONFIG_FREERTOS_USE_TRACE_FACILITY"
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+// Puerto Linux de FreeRTOS: sin periféricos, el LED solo existe en memoria
+typedef enum { GPIO_NUM_2 = 2 } gpio_num_t;
+typedef enum { GPIO_MODE_OUTPUT } gpio_mode_t;
+typedef enum { GPIO_PULLUP_DISABLE } gpio_pullup_t;
+typedef enum { GPIO_PULLDOWN_DISABLE } gpio_pulldown_t;
+typedef enum { GPIO_INTR_DISABLE } gpio_int_type_t;
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+static uint32_t sim_nivel_led;
+
+static int gpio_config(const gpio_config_t *config)
+{
+    return 0;
+}
+
+static int gpio_set_level(gpio_num_t pin, uint32_t nivel)
+{
+    sim_nivel_led = nivel;
+    return 0;
+}
+#endif
+
+// Contador atómico: incrementar y leer nunca bloquean
+typedef struct {
+    volatile uint32_t valor;
+} contador_atomico_t;
+
+// Contador fragmentado: cada núcleo incrementa su propia ranura, en su propia
+// línea de caché, y solo la lectura junta las ranuras
+#define LINEA_CACHE  32
+
+typedef struct {
+    struct {
+        volatile uint32_t valor;
+    } __attribute__((aligned(LINEA_CACHE))) ranuras[portNUM_PROCESSORS];
+} contador_fragmentado_t;
+
+static inline void contador_atomico_sumar(contador_atomico_t *c, uint32_t n)
+{
+    __atomic_fetch_add(&c->valor, n, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t contador_atomico_leer(contador_atomico_t *c)
+{
+    return __atomic_load_n(&c->valor, __ATOMIC_RELAXED);
+}
+
+static inline void contador_fragmentado_sumar(contador_fragmentado_t *c, uint32_t n)
+{
+    // La tarea puede cambiar de núcleo entre leer el ID y sumar, por eso la suma
+    // sigue siendo atómica; normalmente nadie más escribe en esa ranura
+    __atomic_fetch_add(&c->ranuras[xPortGetCoreID()].valor, n, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t contador_fragmentado_leer(contador_fragmentado_t *c)
+{
+    // Cada ranura solo crece, así que la suma nunca retrocede entre lecturas
+    uint32_t total = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        total += __atomic_load_n(&c->ranuras[i].valor, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+// Elige la función según el tipo del contador
+#define contador_sumar(c, n) _Generic((c), \
+    contador_atomico_t *: contador_atomico_sumar, \
+    contador_fragmentado_t *: contador_fragmentado_sumar)((c), (n))
+#define contador_leer(c) _Generic((c), \
+    contador_atomico_t *: contador_atomico_leer, \
+    contador_fragmentado_t *: contador_fragmentado_leer)(c)
+
 // Variables globales para compartir datos entre tareas
+#if MODO_CONTADOR == CONTADOR_MUTEX
 static int global_counter = 0;
 static SemaphoreHandle_t counter_mutex;
+#elif MODO_CONTADOR == CONTADOR_ATOMICO
+static contador_atomico_t global_counter;
+#else
+static contador_fragmentado_t global_counter;
+#endif
 
 // Tag para logging
 static const char *TAG = "MULTITASK_PRACTICE";
 
-// Función de la tarea LED
-void led_task(void *pvParameters)
+#if MODO_REGISTRO_DIFERIDO
+// Registro diferido: anillos por núcleo y tarea de drenado en registro_diferido.h
+#ifndef PILA_DRENADO
+#define PILA_DRENADO         3072
+#endif
+#include "registro_diferido.h"
+#endif
+
+// Logs de los lazos: al anillo con MODO_REGISTRO_DIFERIDO, si no directo a la UART
+#if MODO_REGISTRO_DIFERIDO
+#define LOGI_DIFERIDO(formato, ...)  REGISTRAR_DIFERIDO(formato, __VA_ARGS__)
+#else
+#define LOGI_DIFERIDO(formato, ...)  ESP_LOGI(TAG, formato, __VA_ARGS__)
+#endif
+
+// Perfil de mutex: TOMAR_MUTEX, SOLTAR_MUTEX y el perfilador en perfil_mutex.h
+#include "perfil_mutex.h"
+
+#if MODO_PERFIL_MUTEX
+#define VOLCADO_MUTEX_CADA   12     // Vueltas del monitor entre volcados CSV (1 minuto)
+
+static perfil_mutex_t perfil_counter_mutex = { .nombre = "counter_mutex" };
+#endif
+
+#if MODO_TRAZA
+// Traza del planificador: anillo, volcado y tarea_traza en traza_anillo.h
+#define ARCHIVO_TRAZA        "traza_multitarea.txt"
+#include "traza_anillo.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// En la PC la corrida termina con el volcado, así CI puede convertir y comparar la traza
+static void terminar_tras_traza(void)
+{
+    exit(0);
+}
+#define FIN_TRAZA            terminar_tras_traza
+#else
+#define FIN_TRAZA            NULL
+#endif
+#endif
+
+// Nombres de los objetos del programa en la traza
+#if MODO_TRAZA
+#define TRAZA_NOMBRAR(objeto, nombre)  traza_nombrar((objeto), (nombre))
+#else
+#define TRAZA_NOMBRAR(objeto, nombre)
+#endif
+
+// Tiempo de arranque: marcar_primera_tarea en arranque.h
+#include "arranque.h"
+
+// Lazos periódicos, precisión de los periodos y despertares en lazo_periodico.h
+#include "lazo_periodico.h"
+
+// Lazos de las tareas, globales para consultar su precisión desde otras tareas
+static lazo_periodico_t lazo_led;
+static lazo_periodico_t lazo_contador;
+static lazo_periodico_t lazo_monitor;
+
+// Origen común de los periodos: app_main lo fija antes de crear tareas y
+// temporizadores. Con MODO_BAJO_CONSUMO todos los lazos parten de él y los
+// temporizadores arrancan dentro de ese tick; como 1, 2, 5 y 10 s son múltiplos
+// de 1 s, el contador, el monitor y el aviso despiertan junto con el LED
+static TickType_t origen_periodos;
+
+// Tick de la primera liberación de un lazo que empieza ahora
+static TickType_t origen_lazo(void)
+{
+#if MODO_BAJO_CONSUMO
+    return origen_periodos;
+#else
+    return xTaskGetTickCount();
+#endif
+}
+
+// Modelo de corriente para comparar los dos perfiles: valores típicos aproximados
+// del ESP32 sin radio, no una medición. Con el tick normal el chip nunca duerme:
+// queda en espera (waiti) entre ticks. Con tickless idle y sueño ligero duerme
+// entre despertares y cada uno paga además la salida del sueño
+#define CORRIENTE_ACTIVA_UA       30000   // CPU trabajando
+#define CORRIENTE_ESPERA_UA       20000   // CPU detenida esperando el siguiente tick
+#define CORRIENTE_SUENO_UA        800     // Sueño ligero
+#define TRABAJO_POR_DESPERTAR_US  1000    // Liberar y correr los trabajos de un tick
+#define SALIDA_SUENO_US           500     // Despertar del sueño ligero y volver a dormir
+#define ATENCION_TICK_US          15      // Atender una interrupción del tick
+
+// Corriente promedio con el chip activo activo_us de cada segundo y en reposo_ua el resto
+static uint32_t corriente_promedio_ua(uint64_t activo_us, uint32_t reposo_ua)
+{
+    if (activo_us > 1000000) {
+        activo_us = 1000000;
+    }
+    return (uint32_t) ((activo_us * CORRIENTE_ACTIVA_UA + (1000000 - activo_us) * reposo_ua) / 1000000);
+}
+
+// Despertares por segundo y corriente simulada con el tick normal y con tickless
+// idle, a partir de los despertares medidos desde que arrancó app_main
+static void mostrar_consumo(void)
+{
+    int64_t transcurrido_us = esp_timer_get_time() - arranque_app_main_us;
+    uint32_t n = __atomic_load_n(&despertares, __ATOMIC_RELAXED);
+    if (transcurrido_us <= 0) {
+        return;
+    }
+    
+    // Despertares de los periodos por cada 1000 s, para mostrar tres decimales
+    uint64_t por_ks = (uint64_t) n * 1000000000ULL / (uint64_t) transcurrido_us;
+    uint64_t activo_tick_us = por_ks * TRABAJO_POR_DESPERTAR_US / 1000
+                              + (uint64_t) configTICK_RATE_HZ * ATENCION_TICK_US;
+    uint64_t activo_tickless_us = por_ks * (TRABAJO_POR_DESPERTAR_US + SALIDA_SUENO_US) / 1000;
+    uint32_t tick_ua = corriente_promedio_ua(activo_tick_us, CORRIENTE_ESPERA_UA);
+    uint32_t tickless_ua = corriente_promedio_ua(activo_tickless_us, CORRIENTE_SUENO_UA);
+#if USAR_SUENO_LIGERO
+    const char *marca_tick = "", *marca_tickless = " (este perfil)";
+#else
+    const char *marca_tick = " (este perfil)", *marca_tickless = "";
+#endif
+    
+    ESP_LOGI(TAG, "Despertares de los periodos: %" PRIu32 " en %" PRId64 " s (periodos %s)",
+             n, transcurrido_us / 1000000, MODO_BAJO_CONSUMO ? "alineados" : "sin alinear");
+    ESP_LOGI(TAG, "  Tick normal:             %" PRIu32 ".000 despertares/s, %" PRIu32 ".%02" PRIu32 " mA simulados%s",
+             (uint32_t) configTICK_RATE_HZ, tick_ua / 1000, (tick_ua % 1000) / 10, marca_tick);
+    ESP_LOGI(TAG, "  Tickless + sueño ligero: %" PRIu32 ".%03" PRIu32 " despertares/s, %" PRIu32 ".%02" PRIu32
+             " mA simulados%s",
+             (uint32_t) (por_ks / 1000), (uint32_t) (por_ks % 1000),
+             tickless_ua / 1000, (tickless_ua % 1000) / 10, marca_tickless);
+}
+
+// Configuración inicial del GPIO para el LED
+static void configurar_led(void)
 {
-    // Configuración inicial del GPIO para el LED
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << LED_GPIO_PIN),
         .mode = GPIO_MODE_OUTPUT,
@@ -34,152 +358,1125 @@ void led_task(void *pvParameters)
         .intr_type = GPIO_INTR_DISABLE
     };
     gpio_config(&io_conf);
+}
+
+// Un paso del LED: cambia su estado (lo usan la tarea LED y el trabajo periódico)
+static void alternar_led(void)
+{
+    static bool led_state = false;
+    
+    // Cambiar el estado del LED
+    led_state = !led_state;
+    gpio_set_level(LED_GPIO_PIN, led_state);
+    
+    LOGI_DIFERIDO("LED %s", led_state ? "ON" : "OFF");
+}
+
+// Función de la tarea LED
+void led_task(void *pvParameters)
+{
+    marcar_primera_tarea();
+    configurar_led();
     
     ESP_LOGI(TAG, "LED Task iniciada en el núcleo %d", xPortGetCoreID());
     
-    bool led_state = false;
+    iniciar_lazo(&lazo_led, 1000, origen_lazo());
     
     // Bucle infinito de la tarea
     while (1) {
-        // Cambiar el estado del LED
-        led_state = !led_state;
-        gpio_set_level(LED_GPIO_PIN, led_state);
+        alternar_led();
         
-        ESP_LOGI(TAG, "LED %s", led_state ? "ON" : "OFF");
-        
-        // Suspender la tarea por 1000ms (1 segundo)
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        // Siguiente liberación 1000ms (1 segundo) después de la anterior
+        esperar_periodo(&lazo_led);
     }
 }
 
 // Función de la tarea contador
 void counter_task(void *pvParameters)
 {
+    marcar_primera_tarea();
     ESP_LOGI(TAG, "Counter Task iniciada en el núcleo %d", xPortGetCoreID());
     
+#if MODO_CONTADOR == CONTADOR_MUTEX
     int local_counter = 0;
+#endif
+    
+    iniciar_lazo(&lazo_contador, 2000, origen_lazo());
     
     while (1) {
+#if MODO_CONTADOR == CONTADOR_MUTEX
         // Tomar el mutex antes de acceder a la variable global
-        if (xSemaphoreTake(counter_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (TOMAR_MUTEX(counter_mutex, &perfil_counter_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
             global_counter++;
             local_counter = global_counter;
             
             // Liberar el mutex
-            xSemaphoreGive(counter_mutex);
+            SOLTAR_MUTEX(counter_mutex, &perfil_counter_mutex);
             
-            ESP_LOGI(TAG, "Contador global: %d", local_counter);
+            LOGI_DIFERIDO("Contador global: %d", local_counter);
         } else {
             ESP_LOGW(TAG, "No se pudo obtener el mutex del contador");
         }
+#else
+        // Sin mutex: el incremento nunca espera ni se pierde
+        contador_sumar(&global_counter, 1);
+        LOGI_DIFERIDO("Contador global: %" PRIu32, contador_leer(&global_counter));
+#endif
         
-        // Delay de 2 segundos
-        vTaskDelay(pdMS_TO_TICKS(2000));
+        // Periodo de 2 segundos
+        esperar_periodo(&lazo_contador);
     }
 }
 
+#if MODO_ESTADISTICAS
+// Instantánea de estadísticas del sistema
+#define ESTAD_MAX_TAREAS        20      // Tareas que caben en la instantánea
+#define ESTAD_VENTANA           4       // Instantáneas que abarca la ventana de CPU
+#define NUCLEO_CUALQUIERA       0xFF    // Tarea sin afinidad
+#define PRESUPUESTO_ESTAD_US    1000    // Costo máximo aceptado de una instantánea
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+typedef configRUN_TIME_COUNTER_TYPE tiempo_cpu_t;
+
+// Una tarea en la instantánea (24 bytes, sin punteros)
+typedef struct {
+    char nombre[configMAX_TASK_NAME_LEN];
+    uint16_t pila_libre;        // Marca de agua de la pila en bytes
+    uint16_t cpu_permil;        // Milésimas del CPU total en la ventana
+    uint8_t prioridad;
+    uint8_t nucleo;             // 0, 1 o NUCLEO_CUALQUIERA
+    uint8_t estado;             // eTaskState
+    uint8_t reservado;
+} estad_tarea_t;
+
+// Registro publicado: tamaño y disposición fijos
+typedef struct {
+    uint32_t secuencia;         // Número de instantánea
+    uint32_t marca_ms;          // Instante en que se tomó
+    uint32_t ventana_ms;        // Tiempo que abarca cpu_permil
+    uint32_t heap_libre;
+    uint32_t heap_minimo;       // Mínimo histórico de heap libre
+    uint32_t heap_bloque_max;   // Bloque libre más grande (fragmentación)
+    uint16_t costo_us;          // Lo que tardó el colector en tomar esta instantánea
+    uint8_t num_tareas;
+    uint8_t reservado;
+    estad_tarea_t tareas[ESTAD_MAX_TAREAS];
+} instantanea_sistema_t;
+
+_Static_assert(sizeof(estad_tarea_t) == configMAX_TASK_NAME_LEN + 8, "estad_tarea_t no debe tener relleno");
+
+// Tiempos de CPU de una instantánea anterior, para restar en la ventana
+typedef struct {
+    tiempo_cpu_t total;
+    uint32_t marca_ms;
+    UBaseType_t num_tareas;
+    UBaseType_t numeros[ESTAD_MAX_TAREAS];      // xTaskNumber, estable mientras la tarea exista
+    tiempo_cpu_t tiempos[ESTAD_MAX_TAREAS];
+} muestra_cpu_t;
+
+// Doble búfer: el colector escribe en el que no está publicado, así un lector
+// nunca espera a que el colector (de prioridad baja) termine
+static instantanea_sistema_t instantaneas[2];
+static uint32_t instantanea_publicada;
+
+static TaskStatus_t estados_tareas[ESTAD_MAX_TAREAS];
+static muestra_cpu_t muestras_cpu[ESTAD_VENTANA];
+static uint32_t muestras_tomadas;
+static uint32_t costo_max_estad_us;
+
+/**
+ * Copia la última instantánea publicada
+ * No bloquea: si se publicó otra mientras copiaba, vuelve a copiar
+ * 
+ * @param copia: Destino
+ * @return false si todavía no hay ninguna instantánea
+ */
+static bool leer_instantanea(instantanea_sistema_t *copia)
+{
+    uint32_t n;
+    do {
+        n = __atomic_load_n(&instantanea_publicada, __ATOMIC_ACQUIRE);
+        memcpy(copia, &instantaneas[n % 2], sizeof(*copia));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&instantanea_publicada, __ATOMIC_RELAXED) != n);
+    return n != 0;
+}
+
+/**
+ * Toma una instantánea del sistema y la publica
+ * Los porcentajes de CPU se calculan contra la instantánea de hace ESTAD_VENTANA
+ * tomas (o contra el arranque mientras no haya tantas)
+ */
+static void publicar_instantanea(void)
+{
+    static const muestra_cpu_t muestra_arranque = {0};
+    int64_t inicio = esp_timer_get_time();
+    uint32_t n = instantanea_publicada + 1;
+    instantanea_sistema_t *dst = &instantaneas[n % 2];
+    
+    // Consistente: uxTaskGetSystemState suspende el planificador mientras copia
+    tiempo_cpu_t total;
+    UBaseType_t num = uxTaskGetSystemState(estados_tareas, ESTAD_MAX_TAREAS, &total);
+    UBaseType_t existentes = uxTaskGetNumberOfTasks();
+    if (num == 0) {
+        // El arreglo no alcanza para todas: sin instantánea parcial
+        ESP_LOGW(TAG, "Estadísticas: %u tareas no caben en %d lugares", existentes, ESTAD_MAX_TAREAS);
+        return;
+    }
+    
+    const muestra_cpu_t *previa = muestras_tomadas == 0 ? &muestra_arranque :
+                                  &muestras_cpu[muestras_tomadas < ESTAD_VENTANA ? 0 : muestras_tomadas % ESTAD_VENTANA];
+    // Como vTaskGetRunTimeStats: el total es tiempo de un núcleo, el CPU es de todos
+    uint64_t total_ventana = (uint64_t)(tiempo_cpu_t)(total - previa->total) * portNUM_PROCESSORS;
+    uint32_t ahora_ms = (uint32_t)(inicio / 1000);
+    
+    dst->secuencia = n;
+    dst->marca_ms = ahora_ms;
+    dst->ventana_ms = ahora_ms - previa->marca_ms;
+    dst->heap_libre = esp_get_free_heap_size();
+    dst->heap_minimo = esp_get_minimum_free_heap_size();
+    dst->heap_bloque_max = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    dst->num_tareas = num;
+    dst->reservado = 0;
+    
+    for (UBaseType_t i = 0; i < num; i++) {
+        const TaskStatus_t *t = &estados_tareas[i];
+        estad_tarea_t *e = &dst->tareas[i];
+        
+        // Tiempo de CPU en la ventana; si la tarea es nueva, todo su tiempo
+        tiempo_cpu_t antes = 0;
+        for (UBaseType_t j = 0; j < previa->num_tareas; j++) {
+            if (previa->numeros[j] == t->xTaskNumber) {
+                antes = previa->tiempos[j];
+                break;
+            }
+        }
+        uint64_t usado = (tiempo_cpu_t)(t->ulRunTimeCounter - antes);
+        
+        strncpy(e->nombre, t->pcTaskName, sizeof(e->nombre));
+        e->nombre[sizeof(e->nombre) - 1] = '\0';
+        e->pila_libre = t->usStackHighWaterMark > UINT16_MAX ? UINT16_MAX : t->usStackHighWaterMark;
+        e->cpu_permil = total_ventana > 0 ? (uint16_t)(usado * 1000 / total_ventana) : 0;
+        e->prioridad = t->uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+        BaseType_t nucleo = t->xCoreID;
+#else
+        BaseType_t nucleo = xTaskGetCoreID(t->xHandle);
+#endif
+        e->nucleo = (nucleo == tskNO_AFFINITY) ? NUCLEO_CUALQUIERA : (uint8_t) nucleo;
+        e->estado = t->eCurrentState;
+        e->reservado = 0;
+    }
+    
+    // Guarda los tiempos de esta toma para la ventana de las siguientes
+    muestra_cpu_t *muestra = &muestras_cpu[muestras_tomadas % ESTAD_VENTANA];
+    muestra->total = total;
+    muestra->marca_ms = ahora_ms;
+    muestra->num_tareas = num;
+    for (UBaseType_t i = 0; i < num; i++) {
+        muestra->numeros[i] = estados_tareas[i].xTaskNumber;
+        muestra->tiempos[i] = estados_tareas[i].ulRunTimeCounter;
+    }
+    muestras_tomadas++;
+    
+    uint32_t costo_us = (uint32_t)(esp_timer_get_time() - inicio);
+    dst->costo_us = costo_us > UINT16_MAX ? UINT16_MAX : costo_us;
+    if (costo_us > costo_max_estad_us) {
+        costo_max_estad_us = costo_us;
+    }
+    __atomic_store_n(&instantanea_publicada, n, __ATOMIC_RELEASE);
+    
+    if (costo_us > PRESUPUESTO_ESTAD_US) {
+        ESP_LOGW(TAG, "Estadísticas: la instantánea tardó %" PRIu32 " us, presupuesto %d us",
+                 costo_us, PRESUPUESTO_ESTAD_US);
+    }
+}
+
+/**
+ * Imprime una instantánea: una línea por tarea y el estado del heap
+ * 
+ * @param inst: Instantánea a mostrar
+ */
+static void mostrar_instantanea(const instantanea_sistema_t *inst)
+{
+    static const char letras_estado[] = "XRBSD?";   // Corriendo, lista, bloqueada, suspendida, borrada
+    
+    ESP_LOGI(TAG, "Tareas: %u, CPU en los últimos %" PRIu32 " ms:", inst->num_tareas, inst->ventana_ms);
+    for (int i = 0; i < inst->num_tareas; i++) {
+        const estad_tarea_t *e = &inst->tareas[i];
+        char nucleo = e->nucleo == NUCLEO_CUALQUIERA ? '*' : (char)('0' + e->nucleo);
+        ESP_LOGI(TAG, "  %-16s %c núcleo %c prio %2u CPU %3u.%u%% pila libre %u B",
+                 e->nombre, letras_estado[e->estado < 5 ? e->estado : 5], nucleo, e->prioridad,
+                 e->cpu_permil / 10, e->cpu_permil % 10, e->pila_libre);
+    }
+    uint32_t fragmentacion = inst->heap_libre > 0 ?
+                             100 - (uint32_t)((uint64_t) inst->heap_bloque_max * 100 / inst->heap_libre) : 0;
+    ESP_LOGI(TAG, "Heap libre: %" PRIu32 " B (mínimo %" PRIu32 " B), bloque mayor %" PRIu32 " B, fragmentación %" PRIu32 "%%",
+             inst->heap_libre, inst->heap_minimo, inst->heap_bloque_max, fragmentacion);
+    ESP_LOGI(TAG, "Costo de la instantánea: %u us (máximo %" PRIu32 " us, presupuesto %d us)",
+             inst->costo_us, costo_max_estad_us, PRESUPUESTO_ESTAD_US);
+}
+#endif
+
+// Un paso del monitor: muestra memoria, tareas y contador (lo usan la tarea
+// monitor y el trabajo periódico)
+static void mostrar_monitor(void)
+{
+#if MODO_ESTADISTICAS
+    // Copia local del registro (estática: no cabe cómoda en la pila de la tarea)
+    static instantanea_sistema_t instantanea;
+    
+    // Una sola instantánea consistente de tareas y heap, publicada sin bloqueos;
+    // el monitor la lee igual que cualquier otra tarea
+    publicar_instantanea();
+    bool hay_instantanea = leer_instantanea(&instantanea);
+#else
+    // Obtener información del heap (memoria libre)
+    size_t free_heap = esp_get_free_heap_size();
+    size_t min_free_heap = esp_get_minimum_free_heap_size();
+    
+    // Obtener información de las tareas
+    UBaseType_t task_count = uxTaskGetNumberOfTasks();
+#endif
+    
+    // Obtener el valor actual del contador de forma segura
+#if MODO_CONTADOR == CONTADOR_MUTEX
+    int current_counter = 0;
+    if (TOMAR_MUTEX(counter_mutex, &perfil_counter_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        current_counter = global_counter;
+        SOLTAR_MUTEX(counter_mutex, &perfil_counter_mutex);
+    }
+#else
+    int current_counter = (int) contador_leer(&global_counter);
+#endif
+    
+    // Mostrar información del sistema
+    ESP_LOGI(TAG, "=== MONITOR DEL SISTEMA ===");
+#if MODO_ESTADISTICAS
+    if (hay_instantanea) {
+        mostrar_instantanea(&instantanea);
+    }
+#else
+    ESP_LOGI(TAG, "Memoria libre: %zu bytes", free_heap);
+    ESP_LOGI(TAG, "Mínima memoria libre: %zu bytes", min_free_heap);
+    ESP_LOGI(TAG, "Número de tareas: %u", (unsigned) task_count);
+#endif
+    ESP_LOGI(TAG, "Contador actual: %d", current_counter);
+#if MODO_PERFIL_MUTEX
+    mostrar_perfil_mutex(&perfil_counter_mutex);
+#endif
+    ESP_LOGI(TAG, "Tiempo de ejecución: %" PRId64 " ms", esp_timer_get_time() / 1000);
+    ESP_LOGI(TAG, "===========================");
+#if MODO_PERFIL_MUTEX
+    static uint32_t vueltas_monitor;
+    if (++vueltas_monitor % VOLCADO_MUTEX_CADA == 0) {
+        volcar_perfil_mutex(&perfil_counter_mutex);
+    }
+#endif
+}
+
 // Función de la tarea monitor del sistema
 void monitor_task(void *pvParameters)
 {
+    marcar_primera_tarea();
     ESP_LOGI(TAG, "Monitor Task iniciada en el núcleo %d", xPortGetCoreID());
     
+    iniciar_lazo(&lazo_monitor, 5000, origen_lazo());
+    
     while (1) {
-        // Obtener información del heap (memoria libre)
-        size_t free_heap = esp_get_free_heap_size();
-        size_t min_free_heap = esp_get_minimum_free_heap_size();
+        mostrar_monitor();
         
-        // Obtener información de las tareas
-        UBaseType_t task_count = uxTaskGetNumberOfTasks();
-        
-        // Obtener el valor actual del contador de forma segura
-        int current_counter = 0;
-        if (xSemaphoreTake(counter_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            current_counter = global_counter;
-            xSemaphoreGive(counter_mutex);
+        // Periodo de 5 segundos
+        esperar_periodo(&lazo_monitor);
+    }
+}
+
+#if MODO_BENCHMARK_CONTADOR
+// Benchmark de contención del contador
+#define BENCH_CONTADOR_TAREAS        4          // Repartidas entre los núcleos
+#define BENCH_CONTADOR_INCREMENTOS   100000     // Por tarea
+
+typedef enum {
+    BENCH_MUTEX,
+    BENCH_ATOMICO,
+    BENCH_FRAGMENTADO,
+    NUM_BENCH_CONTADOR
+} variante_contador_t;
+
+static const char *nombres_variante[NUM_BENCH_CONTADOR] = {"mutex", "atómico", "fragmentado"};
+
+static SemaphoreHandle_t bench_mutex;
+static uint32_t bench_cuenta_mutex;
+static contador_atomico_t bench_atomico;
+static contador_fragmentado_t bench_fragmentado;
+static TaskHandle_t bench_principal;
+
+// Tarea del benchmark: espera la señal de salida y hace sus incrementos
+static void tarea_bench_contador(void *pvParameters)
+{
+    variante_contador_t variante = (variante_contador_t)(uintptr_t) pvParameters;
+    
+    // Todas las tareas arrancan juntas cuando app_main las notifica
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    switch (variante) {
+        case BENCH_MUTEX:
+            for (uint32_t i = 0; i < BENCH_CONTADOR_INCREMENTOS; i++) {
+                xSemaphoreTake(bench_mutex, portMAX_DELAY);
+                bench_cuenta_mutex++;
+                xSemaphoreGive(bench_mutex);
+            }
+            break;
+        case BENCH_ATOMICO:
+            for (uint32_t i = 0; i < BENCH_CONTADOR_INCREMENTOS; i++) {
+                contador_sumar(&bench_atomico, 1);
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < BENCH_CONTADOR_INCREMENTOS; i++) {
+                contador_sumar(&bench_fragmentado, 1);
+            }
+            break;
+    }
+    
+    xTaskNotifyGive(bench_principal);
+    vTaskDelete(NULL);
+}
+
+// Mide el rendimiento de cada variante con todas las tareas compitiendo
+static void ejecutar_benchmark_contador(void)
+{
+    const uint32_t esperado = BENCH_CONTADOR_TAREAS * BENCH_CONTADOR_INCREMENTOS;
+    bool correcto = true;
+    
+    bench_mutex = xSemaphoreCreateMutex();
+    bench_principal = xTaskGetCurrentTaskHandle();
+    
+    // Por encima de las tareas del benchmark para poder soltarlas todas juntas
+    vTaskPrioritySet(NULL, TASK_PRIORITY_HIGH + 1);
+    
+    ESP_LOGI(TAG, "=== Benchmark del contador: %d tareas x %d incrementos, %d núcleos ===",
+             BENCH_CONTADOR_TAREAS, BENCH_CONTADOR_INCREMENTOS, portNUM_PROCESSORS);
+    
+    for (int v = 0; v < NUM_BENCH_CONTADOR; v++) {
+        TaskHandle_t tareas[BENCH_CONTADOR_TAREAS];
+        for (int i = 0; i < BENCH_CONTADOR_TAREAS; i++) {
+            xTaskCreatePinnedToCore(tarea_bench_contador, "bench_contador", STACK_SIZE,
+                                    (void *)(uintptr_t) v, TASK_PRIORITY_MED, &tareas[i],
+                                    i % portNUM_PROCESSORS);
         }
         
-        // Mostrar información del sistema
-        ESP_LOGI(TAG, "=== MONITOR DEL SISTEMA ===");
-        ESP_LOGI(TAG, "Memoria libre: %d bytes", free_heap);
-        ESP_LOGI(TAG, "Mínima memoria libre: %d bytes", min_free_heap);
-        ESP_LOGI(TAG, "Número de tareas: %d", task_count);
-        ESP_LOGI(TAG, "Contador actual: %d", current_counter);
-        ESP_LOGI(TAG, "Tiempo de ejecución: %lld ms", esp_timer_get_time() / 1000);
-        ESP_LOGI(TAG, "===========================");
+        int64_t inicio = esp_timer_get_time();
+        for (int i = 0; i < BENCH_CONTADOR_TAREAS; i++) {
+            xTaskNotifyGive(tareas[i]);
+        }
+        for (int i = 0; i < BENCH_CONTADOR_TAREAS; i++) {
+            ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        }
+        int64_t duracion_us = esp_timer_get_time() - inicio;
         
-        // Delay de 5 segundos
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        uint32_t total = v == BENCH_MUTEX ? bench_cuenta_mutex :
+                         v == BENCH_ATOMICO ? contador_leer(&bench_atomico) :
+                         contador_leer(&bench_fragmentado);
+        correcto &= total == esperado;
+        ESP_LOGI(TAG, "%-11s: %" PRId64 " us, %" PRId64 " incrementos/ms, total %" PRIu32 " de %" PRIu32,
+                 nombres_variante[v], duracion_us,
+                 duracion_us > 0 ? (int64_t) esperado * 1000 / duracion_us : 0,
+                 total, esperado);
+    }
+    
+    if (correcto) {
+        ESP_LOGI(TAG, "Benchmark del contador OK: ninguna variante perdió incrementos");
+    } else {
+        ESP_LOGE(TAG, "Benchmark del contador FALLIDO: se perdieron incrementos");
+    }
+    vTaskPrioritySet(NULL, TASK_PRIORITY_LOW);
+}
+#endif
+
+// Ubicación de las tareas
+#define NUCLEO_LIBRE  tskNO_AFFINITY    // El planificador elige el núcleo
+
+// Índices de las tareas de la práctica en tabla_tareas
+typedef enum {
+    TAREA_LED,
+    TAREA_CONTADOR,
+    TAREA_MONITOR,
+    NUM_TAREAS_APP
+} tarea_app_t;
+
+// Una fila por tarea: dónde corre, con qué prioridad y con cuánta pila
+typedef struct {
+    TaskFunction_t funcion;
+    const char *nombre;
+    uint32_t pila;
+    UBaseType_t prioridad;
+    BaseType_t nucleo;          // 0, 1 o NUCLEO_LIBRE
+#if MODO_ESTATICO
+    StackType_t *pila_estatica; // NULL = crear con memoria dinámica
+    StaticTask_t *tcb_estatico;
+#endif
+} ubicacion_tarea_t;
+
+#if MODO_ESTATICO
+// Memoria estática: toda la memoria de las tareas y el mutex de la práctica, con
+// los mismos tamaños que usa el modo dinámico. Queda en .bss, se conoce al
+// enlazar y las APIs ...Static no pueden fallar con buffers válidos
+#if LED_CON_TAREA
+static StackType_t pila_led_task[PILA_LED_TASK];
+#define PILA_ESTATICA_LED      pila_led_task
+#else
+#define PILA_ESTATICA_LED      NULL     // Trabajo periódico: no se reserva su pila
+#endif
+static StackType_t pila_counter_task[PILA_COUNTER_TASK];
+static StackType_t pila_monitor_task[PILA_MONITOR_TASK];
+static StaticTask_t tcbs_tareas[NUM_TAREAS_APP];
+#if MODO_CONTADOR == CONTADOR_MUTEX
+static StaticSemaphore_t counter_mutex_estatico;
+#endif
+#if MODO_REGISTRO_DIFERIDO
+static StackType_t pila_drenado[PILA_DRENADO];
+static StaticTask_t tcb_drenado;
+#endif
+
+#define MEMORIA_TAREA(pila, t)  pila, &tcbs_tareas[t]
+#else
+#define MEMORIA_TAREA(pila, t)
+#endif
+
+// El LED y el contador despiertan seguido y comparten el núcleo de la aplicación;
+// el monitor, que solo lee y escribe en la consola, va al núcleo 0
+static const ubicacion_tarea_t tabla_tareas[NUM_TAREAS_APP] = {
+    [TAREA_LED]      = { led_task,     "LED_Task",     PILA_LED_TASK,     TASK_PRIORITY_MED,  1,
+                         MEMORIA_TAREA(PILA_ESTATICA_LED, TAREA_LED) },
+    [TAREA_CONTADOR] = { counter_task, "Counter_Task", PILA_COUNTER_TASK, TASK_PRIORITY_HIGH, 1,
+                         MEMORIA_TAREA(pila_counter_task, TAREA_CONTADOR) },
+    [TAREA_MONITOR]  = { monitor_task, "Monitor_Task", PILA_MONITOR_TASK, TASK_PRIORITY_LOW,  0,
+                         MEMORIA_TAREA(pila_monitor_task, TAREA_MONITOR) },
+};
+
+/**
+ * Crea una tarea en el núcleo pedido
+ * En un chip de un solo núcleo (o en el puerto Linux) un núcleo que no existe
+ * se cambia por NUCLEO_LIBRE. Si la fila trae memoria estática la creación no
+ * puede fallar
+ * 
+ * @param u: Fila de ubicación (la función y el nombre se toman de aquí)
+ * @param nucleo: Núcleo donde crearla
+ * @param parametro: pvParameters de la tarea
+ * @param handle: Handle de la tarea creada (puede ser NULL)
+ * @return pdPASS si se creó
+ */
+static BaseType_t crear_tarea_ubicada(const ubicacion_tarea_t *u, BaseType_t nucleo,
+                                      void *parametro, TaskHandle_t *handle)
+{
+    if (nucleo != NUCLEO_LIBRE && nucleo >= portNUM_PROCESSORS) {
+        nucleo = NUCLEO_LIBRE;
+    }
+#if MODO_ESTATICO
+    if (u->pila_estatica != NULL) {
+        TaskHandle_t creada = xTaskCreateStaticPinnedToCore(u->funcion, u->nombre, u->pila, parametro,
+                                                            u->prioridad, u->pila_estatica,
+                                                            u->tcb_estatico, nucleo);
+        if (handle != NULL) {
+            *handle = creada;
+        }
+        return pdPASS;
+    }
+#endif
+    return xTaskCreatePinnedToCore(u->funcion, u->nombre, u->pila, parametro,
+                                   u->prioridad, handle, nucleo);
+}
+
+#if MODO_TRABAJOS_PERIODICOS || MODO_BENCHMARK_PERIODICOS
+// Trabajos periódicos: cada uno es un temporizador de FreeRTOS con recarga
+// automática. Los cortos corren en el callback, dentro de la tarea de los
+// temporizadores, y comparten su pila, su prioridad (configTIMER_TASK_PRIORITY)
+// y su núcleo; no deben bloquearse ni tardar mucho porque retrasan a los demás.
+// Uno largo o que se bloquea trae una fila de tabla_tareas y el callback solo
+// despierta a su tarea propia, que corre con la ubicación de esa fila.
+// El temporizador vuelve a armarse desde el vencimiento anterior, no desde que
+// terminó el trabajo, así que el periodo no acumula la duración del trabajo
+typedef struct {
+    const char *nombre;
+    void (*funcion)(void);
+    uint32_t periodo_ms;
+    const ubicacion_tarea_t *tarea;     // NULL = en la tarea de los temporizadores
+} trabajo_periodico_t;
+
+// Estado de un trabajo; cada ejecución se anota como una liberación en su medición
+typedef struct {
+    const trabajo_periodico_t *trabajo;
+    TimerHandle_t temporizador;
+    TaskHandle_t tarea;                 // NULL si corre en la tarea de los temporizadores
+    medicion_periodo_t medicion;        // Omitidas: avisos que se juntaron (tarea propia ocupada)
+#if MODO_ESTATICO
+    StaticTimer_t memoria_temporizador;
+#endif
+} estado_trabajo_t;
+
+static void ejecutar_trabajo(estado_trabajo_t *e, uint32_t saltos)
+{
+    registrar_liberacion(&e->medicion, saltos, false);
+    e->trabajo->funcion();
+}
+
+// Callback del temporizador: corre el trabajo aquí o despierta a su tarea
+static void temporizador_trabajo(TimerHandle_t temporizador)
+{
+    estado_trabajo_t *e = (estado_trabajo_t *) pvTimerGetTimerID(temporizador);
+    
+    if (e->tarea != NULL) {
+        xTaskNotifyGive(e->tarea);
+    } else {
+        ejecutar_trabajo(e, 0);
+    }
+}
+
+// Tarea propia de un trabajo largo: una ejecución por cada aviso del temporizador
+static void tarea_trabajo(void *pvParameters)
+{
+    estado_trabajo_t *e = (estado_trabajo_t *) pvParameters;
+    
+    while (1) {
+        // Si el trabajo anterior tardó más de un periodo los avisos se juntan
+        uint32_t avisos = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ejecutar_trabajo(e, avisos - 1);
+    }
+}
+
+/**
+ * Arranca un trabajo periódico (y su tarea propia si la pide)
+ * 
+ * @param e: Estado del trabajo; debe vivir mientras el trabajo exista
+ * @param t: Descripción del trabajo
+ * @return true si quedó corriendo
+ */
+static bool iniciar_trabajo(estado_trabajo_t *e, const trabajo_periodico_t *t)
+{
+    *e = (estado_trabajo_t) { .trabajo = t };
+    iniciar_medicion(&e->medicion, t->periodo_ms);
+    
+    if (t->tarea != NULL) {
+        ubicacion_tarea_t u = *t->tarea;
+        u.funcion = tarea_trabajo;
+        if (crear_tarea_ubicada(&u, u.nucleo, e, &e->tarea) != pdPASS) {
+            return false;
+        }
+    }
+    
+#if MODO_ESTATICO
+    e->temporizador = xTimerCreateStatic(t->nombre, pdMS_TO_TICKS(t->periodo_ms), pdTRUE, e,
+                                         temporizador_trabajo, &e->memoria_temporizador);
+#else
+    e->temporizador = xTimerCreate(t->nombre, pdMS_TO_TICKS(t->periodo_ms), pdTRUE, e,
+                                   temporizador_trabajo);
+#endif
+    return e->temporizador != NULL && xTimerStart(e->temporizador, portMAX_DELAY) == pdPASS;
+}
+#endif
+
+#if MODO_TRABAJOS_PERIODICOS
+// Lo que antes hacía el lazo de app_main, más la precisión de los periodos
+static void aviso_principal(void);
+
+typedef enum {
+    TRABAJO_LED,
+    TRABAJO_MONITOR,
+    TRABAJO_PRINCIPAL,
+    NUM_TRABAJOS
+} trabajo_app_t;
+
+// El LED y el aviso son cortos y no se bloquean: van en la tarea de los
+// temporizadores. El monitor espera counter_mutex (con CONTADOR_MUTEX), recorre
+// las tareas con MODO_ESTADISTICAS y escribe varias líneas, así que usa su tarea
+static const trabajo_periodico_t tabla_trabajos[NUM_TRABAJOS] = {
+    [TRABAJO_LED]       = { "LED",       alternar_led,    1000,  NULL },
+    [TRABAJO_MONITOR]   = { "Monitor",   mostrar_monitor, 5000,  &tabla_tareas[TAREA_MONITOR] },
+    [TRABAJO_PRINCIPAL] = { "Principal", aviso_principal, 10000, NULL },
+};
+
+static estado_trabajo_t estados_trabajos[NUM_TRABAJOS];
+#endif
+
+// Precisión de todos los lazos y trabajos periódicos de la práctica y sus despertares
+static void mostrar_periodos(void)
+{
+#if MODO_TRABAJOS_PERIODICOS
+    for (int i = 0; i < NUM_TRABAJOS; i++) {
+        mostrar_precision(tabla_trabajos[i].nombre, &estados_trabajos[i].medicion);
+    }
+#else
+    mostrar_precision("LED", &lazo_led.medicion);
+    mostrar_precision("Monitor", &lazo_monitor.medicion);
+#endif
+    mostrar_precision("Contador", &lazo_contador.medicion);
+    mostrar_consumo();
+}
+
+#if MODO_TRABAJOS_PERIODICOS
+static void aviso_principal(void)
+{
+    ESP_LOGI(TAG, "Tarea principal ejecutándose...");
+    mostrar_periodos();
+}
+#endif
+
+#if MODO_BENCHMARK_PERIODICOS
+// Benchmark de periodos: un trabajo de duración variable (como un log que a veces
+// es más largo) cada BENCH_PERIODO_MS, hecho de cuatro formas. La tarea con
+// vTaskDelay espera un periodo completo después de trabajar, así que se atrasa
+// cada vez que el trabajo cruza un tick; el lazo con xTaskDelayUntil y los
+// temporizadores no. También se mide el heap que cuesta cada forma
+#define BENCH_PERIODO_MS        100
+#define BENCH_PERIODOS          100
+#define BENCH_TRABAJO_US        2000    // Trabajo base, más 0 a 3 ms según la vuelta
+
+typedef enum {
+    FORMA_RETARDO,              // Tarea que trabaja y después llama a vTaskDelay
+    FORMA_LAZO,                 // Tarea con lazo_periodico_t (xTaskDelayUntil)
+    FORMA_TEMPORIZADOR,         // Trabajo en la tarea de los temporizadores
+    FORMA_TEMPORIZADOR_TAREA,   // Temporizador que despierta a una tarea propia
+} forma_periodica_t;
+
+static TaskHandle_t bench_periodos_principal;
+static volatile uint32_t bench_periodos_vueltas;
+static volatile bool bench_periodos_listo;
+static lazo_periodico_t bench_periodos_lazo;        // Formas con tarea
+static estado_trabajo_t bench_periodos_estado;      // Formas con temporizador
+
+// El trabajo del benchmark: espera activa de 2 a 5 ms y avisa al terminar la serie
+static void bench_periodos_trabajo(void)
+{
+    uint32_t vuelta = bench_periodos_vueltas++;
+    int64_t fin = esp_timer_get_time() + BENCH_TRABAJO_US + (vuelta % 4) * 1000;
+    while (esp_timer_get_time() < fin) {
+    }
+    if (vuelta == BENCH_PERIODOS) {
+        bench_periodos_listo = true;
+        xTaskNotifyGive(bench_periodos_principal);
     }
 }
 
+// Formas con tarea: la de la práctica original (vTaskDelay) o el lazo periódico
+static void bench_periodos_tarea(void *pvParameters)
+{
+    bool con_retardo = (forma_periodica_t) (intptr_t) pvParameters == FORMA_RETARDO;
+    
+    iniciar_lazo(&bench_periodos_lazo, BENCH_PERIODO_MS, xTaskGetTickCount());
+    while (!bench_periodos_listo) {
+        bench_periodos_trabajo();
+        if (con_retardo) {
+            vTaskDelay(pdMS_TO_TICKS(BENCH_PERIODO_MS));
+            registrar_liberacion(&bench_periodos_lazo.medicion, 0, false);
+        } else {
+            esperar_periodo(&bench_periodos_lazo);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+// Misma prioridad y núcleo de la tarea LED, con memoria dinámica
+static const ubicacion_tarea_t bench_fila_tarea = {
+    .funcion = bench_periodos_tarea, .nombre = "bench_periodos", .pila = STACK_SIZE,
+    .prioridad = TASK_PRIORITY_MED, .nucleo = 1,
+};
+
+static const trabajo_periodico_t bench_trabajos[] = {
+    [FORMA_TEMPORIZADOR]       = { "bench", bench_periodos_trabajo, BENCH_PERIODO_MS, NULL },
+    [FORMA_TEMPORIZADOR_TAREA] = { "bench", bench_periodos_trabajo, BENCH_PERIODO_MS, &bench_fila_tarea },
+};
+
+// Corre una forma, espera la serie completa y muestra su precisión y su costo
+static void ejecutar_forma_periodica(const char *nombre, forma_periodica_t forma)
+{
+    bool con_tarea = forma == FORMA_RETARDO || forma == FORMA_LAZO;
+    const medicion_periodo_t *medicion = con_tarea ? &bench_periodos_lazo.medicion : &bench_periodos_estado.medicion;
+    
+    bench_periodos_listo = false;
+    bench_periodos_vueltas = 0;
+    size_t heap_antes = esp_get_free_heap_size();
+    
+    if (con_tarea) {
+        crear_tarea_ubicada(&bench_fila_tarea, bench_fila_tarea.nucleo, (void *) (intptr_t) forma, NULL);
+    } else if (!iniciar_trabajo(&bench_periodos_estado, &bench_trabajos[forma])) {
+        ESP_LOGE(TAG, "No se pudo iniciar el trabajo (%s)", nombre);
+        return;
+    }
+    long heap_usado = (long) heap_antes - (long) esp_get_free_heap_size();
+    
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    ESP_LOGI(TAG, "--- %s (heap %ld B) ---", nombre, heap_usado);
+    mostrar_precision("bench", medicion);
+    
+    if (!con_tarea) {
+        xTimerDelete(bench_periodos_estado.temporizador, portMAX_DELAY);
+        if (bench_periodos_estado.tarea != NULL) {
+            vTaskDelete(bench_periodos_estado.tarea);
+        }
+    }
+    // Deja terminar a la tarea del benchmark y al temporizador antes de la siguiente forma
+    vTaskDelay(pdMS_TO_TICKS(2 * BENCH_PERIODO_MS));
+}
+
+static void ejecutar_benchmark_periodicos(void)
+{
+    bench_periodos_principal = xTaskGetCurrentTaskHandle();
+    
+    ESP_LOGI(TAG, "=== Benchmark de periodos: %d periodos de %d ms, trabajo de %d a %d us ===",
+             BENCH_PERIODOS, BENCH_PERIODO_MS, BENCH_TRABAJO_US, BENCH_TRABAJO_US + 3000);
+    ejecutar_forma_periodica("tarea con vTaskDelay", FORMA_RETARDO);
+    ejecutar_forma_periodica("tarea con xTaskDelayUntil", FORMA_LAZO);
+    ejecutar_forma_periodica("temporizador", FORMA_TEMPORIZADOR);
+    ejecutar_forma_periodica("temporizador con tarea propia", FORMA_TEMPORIZADOR_TAREA);
+}
+#endif
+
+#if MODO_BENCHMARK_UBICACION
+// Benchmark de ubicación: el mismo patrón de trabajo que la práctica pero sin
+// esperas largas. El "LED" despierta cada tick y avisa al "contador", que mide
+// cuánto tardó en despertar; el "monitor" gasta CPU con prioridad baja y cuenta
+// cuántas vueltas logró (rendimiento que le queda al trabajo de fondo)
+#define BENCH_UBIC_DESPERTARES  200
+#define BENCH_UBIC_RAFAGA_US    8000    // Trabajo continuo del monitor antes de ceder un tick
+
+typedef struct {
+    const char *nombre;
+    BaseType_t nucleos[NUM_TAREAS_APP];
+} politica_ubicacion_t;
+
+static const politica_ubicacion_t politicas_ubicacion[] = {
+    { "todo en núcleo 0",          { 0, 0, 0 } },
+    { "todo en núcleo 1",          { 1, 1, 1 } },
+    { "LED y contador separados",  { 0, 1, 0 } },
+    { "monitor con el contador",   { 0, 1, 1 } },
+    { "sin afinidad",              { NUCLEO_LIBRE, NUCLEO_LIBRE, NUCLEO_LIBRE } },
+};
+
+static TaskHandle_t bench_ubic_principal;
+static TaskHandle_t bench_ubic_contador;
+static volatile int64_t bench_ubic_aviso_us;        // Cuándo avisó el LED
+static volatile bool bench_ubic_fin;
+static volatile uint32_t bench_ubic_vueltas;        // Vueltas del monitor
+static uint32_t bench_ubic_latencias[BENCH_UBIC_DESPERTARES];
+
+static void bench_ubic_led(void *pvParameters)
+{
+    for (int i = 0; i < BENCH_UBIC_DESPERTARES; i++) {
+        vTaskDelay(1);
+        bench_ubic_aviso_us = esp_timer_get_time();
+        xTaskNotifyGive(bench_ubic_contador);
+    }
+    xTaskNotifyGive(bench_ubic_principal);
+    vTaskDelete(NULL);
+}
+
+static void bench_ubic_contador_task(void *pvParameters)
+{
+    for (int i = 0; i < BENCH_UBIC_DESPERTARES; i++) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Reloj de esp_timer: es el mismo para los dos núcleos, el contador de ciclos no
+        bench_ubic_latencias[i] = (uint32_t)(esp_timer_get_time() - bench_ubic_aviso_us);
+    }
+    xTaskNotifyGive(bench_ubic_principal);
+    vTaskDelete(NULL);
+}
+
+static void bench_ubic_monitor(void *pvParameters)
+{
+    while (!bench_ubic_fin) {
+        // Ráfagas de trabajo con un tick de descanso, para no dejar sin CPU a la tarea IDLE
+        int64_t fin_rafaga = esp_timer_get_time() + BENCH_UBIC_RAFAGA_US;
+        while (esp_timer_get_time() < fin_rafaga && !bench_ubic_fin) {
+            bench_ubic_vueltas++;
+        }
+        vTaskDelay(1);
+    }
+    xTaskNotifyGive(bench_ubic_principal);
+    vTaskDelete(NULL);
+}
+
+static int comparar_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Corre una política y muestra la latencia de despertar y el rendimiento de fondo
+static void ejecutar_politica_ubicacion(const politica_ubicacion_t *p)
+{
+    static const TaskFunction_t funciones[NUM_TAREAS_APP] = {
+        [TAREA_LED] = bench_ubic_led,
+        [TAREA_CONTADOR] = bench_ubic_contador_task,
+        [TAREA_MONITOR] = bench_ubic_monitor,
+    };
+    
+    bench_ubic_fin = false;
+    bench_ubic_vueltas = 0;
+    
+    // Mismos nombres, prioridades y pilas que la práctica; solo cambia el núcleo.
+    // El contador se crea primero porque el LED necesita su handle
+    static const tarea_app_t orden[NUM_TAREAS_APP] = { TAREA_CONTADOR, TAREA_MONITOR, TAREA_LED };
+    for (int k = 0; k < NUM_TAREAS_APP; k++) {
+        tarea_app_t t = orden[k];
+        ubicacion_tarea_t u = tabla_tareas[t];
+        u.funcion = funciones[t];
+#if MODO_ESTATICO
+        // Las tareas del benchmark se borran y se vuelven a crear: memoria dinámica
+        u.pila_estatica = NULL;
+#endif
+        crear_tarea_ubicada(&u, p->nucleos[t], NULL, t == TAREA_CONTADOR ? &bench_ubic_contador : NULL);
+    }
+    
+    int64_t inicio = esp_timer_get_time();
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);       // LED
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);       // Contador
+    int64_t duracion_us = esp_timer_get_time() - inicio;
+    uint32_t vueltas = bench_ubic_vueltas;
+    bench_ubic_fin = true;
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);       // Monitor
+    
+    qsort(bench_ubic_latencias, BENCH_UBIC_DESPERTARES, sizeof(uint32_t), comparar_u32);
+    ESP_LOGI(TAG, "%-25s: despertar min=%" PRIu32 " p50=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32
+             " us, monitor %" PRId64 " vueltas/ms",
+             p->nombre, bench_ubic_latencias[0], bench_ubic_latencias[BENCH_UBIC_DESPERTARES / 2],
+             bench_ubic_latencias[BENCH_UBIC_DESPERTARES * 99 / 100],
+             bench_ubic_latencias[BENCH_UBIC_DESPERTARES - 1],
+             duracion_us > 0 ? (int64_t) vueltas * 1000 / duracion_us : 0);
+}
+
+// Compara la ubicación de tabla_tareas contra las políticas de politicas_ubicacion
+static void ejecutar_benchmark_ubicacion(void)
+{
+    bench_ubic_principal = xTaskGetCurrentTaskHandle();
+    
+    // Por encima de las tareas del benchmark para crearlas sin que arranquen a medias
+    vTaskPrioritySet(NULL, TASK_PRIORITY_HIGH + 1);
+    
+    ESP_LOGI(TAG, "=== Benchmark de ubicación: %d despertares por política, %d núcleos ===",
+             BENCH_UBIC_DESPERTARES, portNUM_PROCESSORS);
+    
+    // Primero la ubicación actual de tabla_tareas, después las alternativas
+    politica_ubicacion_t actual = { .nombre = "tabla_tareas" };
+    for (int t = 0; t < NUM_TAREAS_APP; t++) {
+        actual.nucleos[t] = tabla_tareas[t].nucleo;
+    }
+    ejecutar_politica_ubicacion(&actual);
+    for (size_t i = 0; i < sizeof(politicas_ubicacion) / sizeof(politicas_ubicacion[0]); i++) {
+        ejecutar_politica_ubicacion(&politicas_ubicacion[i]);
+    }
+    vTaskPrioritySet(NULL, TASK_PRIORITY_LOW);
+}
+#endif
+
+#if MODO_PERFIL_PILAS
+// Perfil de pilas: después de PERFIL_DURACION_MS de trabajo normal se lee la marca
+// de agua de cada tarea (lo mínimo que le quedó libre) y se imprime un header con
+// la pila usada más un margen, entre dos marcas para copiarlo junto a este archivo.
+// En el puerto Linux además se escribe directo en el directorio de trabajo.
+// Solo cuenta lo que se ejecutó: conviene perfilar con los modos que se van a usar
+// El margen y el generador del header están en perfil_pilas.h
+#define ARCHIVO_PILAS             "pilas_multitarea.h"
+
+#include "perfil_pilas.h"
+
+static TaskHandle_t handles_tareas[NUM_TAREAS_APP];
+
+static const char *const macros_pila[NUM_TAREAS_APP] = {
+    [TAREA_LED]      = "PILA_LED_TASK",
+    [TAREA_CONTADOR] = "PILA_COUNTER_TASK",
+    [TAREA_MONITOR]  = "PILA_MONITOR_TASK",
+};
+
+// Espera a que la práctica trabaje un rato, mide las pilas y publica el header
+static void tarea_perfil_pilas(void *pvParameters)
+{
+    perfil_pila_t perfiles[NUM_TAREAS_APP + 2];
+    size_t n = 0;
+    
+    vTaskDelay(pdMS_TO_TICKS(PERFIL_DURACION_MS));
+    
+    for (int t = 0; t < NUM_TAREAS_APP; t++) {
+        if (handles_tareas[t] != NULL) {
+            perfiles[n++] = (perfil_pila_t) { macros_pila[t], tabla_tareas[t].pila,
+                                              uxTaskGetStackHighWaterMark(handles_tareas[t]), 1 };
+        }
+    }
+#if MODO_REGISTRO_DIFERIDO
+    perfiles[n++] = (perfil_pila_t) { "PILA_DRENADO", PILA_DRENADO,
+                                      uxTaskGetStackHighWaterMark(tarea_drenado), 1 };
+#endif
+#if MODO_TRABAJOS_PERIODICOS
+    // Los trabajos cortos corren en la pila de la tarea de los temporizadores; se
+    // cambia en menuconfig (CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH), no con la macro
+    perfiles[n++] = (perfil_pila_t) { "PILA_TMR_SVC", configTIMER_TASK_STACK_DEPTH,
+                                      uxTaskGetStackHighWaterMark(xTimerGetTimerDaemonTaskHandle()), 1 };
+#endif
+    
+    publicar_header_pilas(ARCHIVO_PILAS, NULL, perfiles, n);
+    vTaskDelete(NULL);
+}
+#endif
+
+#if USAR_SUENO_LIGERO
+/**
+ * Configura el sueño ligero automático
+ * Con tickless idle, cuando todas las tareas están bloqueadas el chip duerme
+ * hasta el siguiente tick en que algo se libera, en lugar de despertar en cada tick
+ */
+static void configurar_bajo_consumo(void)
+{
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    
+    // El LED conserva su nivel mientras el chip duerme
+    ESP_ERROR_CHECK(gpio_sleep_sel_dis(LED_GPIO_PIN));
+    
+    ESP_LOGI(TAG, "Sueño ligero automático habilitado");
+}
+#endif
+
 // Función principal de la aplicación
 void app_main(void)
 {
+    arranque_app_main_us = (uint32_t) esp_timer_get_time();
     ESP_LOGI(TAG, "Iniciando práctica de múltiples tareas");
     ESP_LOGI(TAG, "Ejecutándose en el núcleo %d", xPortGetCoreID());
     
+    size_t heap_antes = esp_get_free_heap_size();
+    
+#if MODO_REGISTRO_DIFERIDO && MODO_ESTATICO
+    // Prioridad mínima: los registros se escriben cuando no hay nada más que hacer
+    tarea_drenado = xTaskCreateStatic(tarea_drenado_registro, "drenado_registro", PILA_DRENADO, NULL,
+                                      1, pila_drenado, &tcb_drenado);
+#elif MODO_REGISTRO_DIFERIDO
+    // Prioridad mínima: los registros se escriben cuando no hay nada más que hacer
+    xTaskCreate(tarea_drenado_registro, "drenado_registro", PILA_DRENADO, NULL,
+                1, &tarea_drenado);
+#endif
+    
+#if MODO_TRAZA
+    // La traza corre desde el arranque; esta tarea la detiene y la vuelca
+    xTaskCreate(tarea_traza, "traza", PILA_TRAZA, (void *) FIN_TRAZA, TASK_PRIORITY_LOW, NULL);
+#endif
+    
+#if MODO_BENCHMARK_CONTADOR
+    // Solo se corre el benchmark del contador, sin las tareas de la práctica
+    ejecutar_benchmark_contador();
+    return;
+#endif
+    
+#if MODO_BENCHMARK_UBICACION
+    // Solo se corre el benchmark de ubicación, sin las tareas de la práctica
+    ejecutar_benchmark_ubicacion();
+    return;
+#endif
+    
+#if MODO_BENCHMARK_PERIODICOS
+    // Solo se corre el benchmark de periodos, sin las tareas de la práctica
+    ejecutar_benchmark_periodicos();
+    return;
+#endif
+    
+#if MODO_CONTADOR == CONTADOR_MUTEX && MODO_ESTATICO
+    // Mutex en memoria estática: no puede fallar
+    counter_mutex = xSemaphoreCreateMutexStatic(&counter_mutex_estatico);
+#elif MODO_CONTADOR == CONTADOR_MUTEX
     // Crear mutex para proteger la variable global
     counter_mutex = xSemaphoreCreateMutex();
     if (counter_mutex == NULL) {
         ESP_LOGE(TAG, "Error al crear el mutex");
         return;
     }
+#endif
+#if MODO_CONTADOR == CONTADOR_MUTEX
+    TRAZA_NOMBRAR(counter_mutex, "counter_mutex");
+#endif
     
-    // Crear la tarea del LED con prioridad media
-    TaskHandle_t led_task_handle;
-    BaseType_t result = xTaskCreate(
-        led_task,                   // Función de la tarea
-        "LED_Task",                 // Nombre descriptivo
-        STACK_SIZE,                 // Tamaño del stack
-        NULL,                       // Parámetros de entrada
-        TASK_PRIORITY_MED,          // Prioridad
-        &led_task_handle            // Handle de la tarea
-    );
+#if USAR_SUENO_LIGERO
+    configurar_bajo_consumo();
+#endif
+#if MODO_BAJO_CONSUMO
+    // Arrancar al principio de un tick: los temporizadores se inician dentro de él
+    vTaskDelay(1);
+#endif
+    origen_periodos = xTaskGetTickCount();
     
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error al crear LED Task");
-        return;
+#if MODO_TRABAJOS_PERIODICOS
+    // Los trabajos cortos comparten la tarea de los temporizadores de FreeRTOS;
+    // arrancan antes que el contador para que sus temporizadores partan del origen
+    configurar_led();
+    for (int i = 0; i < NUM_TRABAJOS; i++) {
+        if (!iniciar_trabajo(&estados_trabajos[i], &tabla_trabajos[i])) {
+            ESP_LOGE(TAG, "Error al iniciar el trabajo %s", tabla_trabajos[i].nombre);
+            return;
+        }
     }
-    
-    // Crear la tarea contador con prioridad alta
-    TaskHandle_t counter_task_handle;
-    result = xTaskCreate(
-        counter_task,
-        "Counter_Task",
-        STACK_SIZE,
-        NULL,
-        TASK_PRIORITY_HIGH,
-        &counter_task_handle
-    );
-    
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error al crear Counter Task");
-        return;
+#if MODO_BAJO_CONSUMO
+    if (xTaskGetTickCount() != origen_periodos) {
+        ESP_LOGW(TAG, "Los temporizadores arrancaron después del tick de origen; "
+                 "sus despertares no coinciden con los del contador");
     }
+#endif
+#endif
     
-    // Crear la tarea monitor con prioridad baja
-    TaskHandle_t monitor_task_handle;
-    result = xTaskCreate(
-        monitor_task,
-        "Monitor_Task",
-        STACK_SIZE,
-        NULL,
-        TASK_PRIORITY_LOW,
-        &monitor_task_handle
-    );
-    
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error al crear Monitor Task");
-        return;
+    // Crear las tareas de la práctica, cada una en el núcleo que dice su fila
+    for (int i = 0; i < NUM_TAREAS_APP; i++) {
+        const ubicacion_tarea_t *u = &tabla_tareas[i];
+#if MODO_TRABAJOS_PERIODICOS
+        // El LED y el monitor son trabajos periódicos (el monitor crea ahí su tarea)
+        if (i != TAREA_CONTADOR) {
+            continue;
+        }
+#endif
+#if MODO_PERFIL_PILAS
+        TaskHandle_t *handle = &handles_tareas[i];
+#else
+        TaskHandle_t *handle = NULL;
+#endif
+#if MODO_ESTATICO
+        crear_tarea_ubicada(u, u->nucleo, NULL, handle);
+#else
+        if (crear_tarea_ubicada(u, u->nucleo, NULL, handle) != pdPASS) {
+            ESP_LOGE(TAG, "Error al crear %s", u->nombre);
+            return;
+        }
+#endif
     }
     
+#if MODO_TRABAJOS_PERIODICOS
+#if MODO_PERFIL_PILAS
+    handles_tareas[TAREA_MONITOR] = estados_trabajos[TRABAJO_MONITOR].tarea;
+#endif
+    ESP_LOGI(TAG, "Trabajos periódicos: %d, tareas en el sistema: %" PRIu32,
+             NUM_TRABAJOS, (uint32_t) uxTaskGetNumberOfTasks());
+#endif
+    
+    ESP_LOGI(TAG, "Arranque (memoria %s): objetos creados a los %" PRIu32 " us, heap usado %ld B",
+             MODO_ESTATICO ? "estática" : "dinámica", (uint32_t) esp_timer_get_time(),
+             (long) heap_antes - (long) esp_get_free_heap_size());
+#if MODO_PERFIL_PILAS
+    xTaskCreate(tarea_perfil_pilas, "perfil_pilas", PILA_PERFIL, NULL, TASK_PRIORITY_LOW, NULL);
+#endif
     ESP_LOGI(TAG, "Todas las tareas han sido creadas exitosamente");
     ESP_LOGI(TAG, "El planificador de FreeRTOS está manejando las tareas");
     
     // La tarea principal puede terminar aquí ya que las otras tareas seguirán ejecutándose
     // En un sistema embebido, normalmente tendríamos un bucle infinito aquí también
+#if !MODO_TRABAJOS_PERIODICOS
+    static lazo_periodico_t lazo_principal;
+    iniciar_lazo(&lazo_principal, 10000, origen_lazo());
     while (1) {
         ESP_LOGI(TAG, "Tarea principal ejecutándose...");
-        vTaskDelay(pdMS_TO_TICKS(10000)); // 10 segundos
+        mostrar_periodos();
+        esperar_periodo(&lazo_principal); // 10 segundos
     }
+#endif
 }
\ No newline at end of file
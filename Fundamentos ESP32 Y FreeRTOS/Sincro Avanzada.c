@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -8,6 +10,8 @@
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 
 // ============================================================================
 // DEFINICIONES Y ESTRUCTURAS
@@ -16,10 +20,154 @@
 #define QUEUE_SIZE 10           // Tamaño de la cola para datos de sensores
 #define MAX_SENSOR_VALUE 100    // Valor máximo del sensor
 #define STACK_SIZE 2048         // Tamaño del stack para las tareas
+#define NUM_SENSORES 3          // Productores: temperatura, humedad y presión
+#define LINEA_CACHE 32          // Bytes por línea de caché, para separar lo que escriben núcleos distintos
+
+// Registro diferido: los logs de los lazos guardan formato y argumentos crudos en
+// un anillo por núcleo y una tarea de prioridad mínima los escribe (0 = ESP_LOGI directo)
+#define MODO_REGISTRO_DIFERIDO  0
+
+// Memoria estática: cola, semáforos, event group y tareas con las APIs ...Static y
+// buffers reservados al enlazar, sin heap ni caminos de error (0 = memoria dinámica)
+#define MODO_ESTATICO  0
+
+// Transporte de las muestras al procesador. TRANSPORTE_COLA: un xQueueSend por
+// dato a sensor_queue. TRANSPORTE_LOTES: cada sensor junta sus datos en un bloque
+// y pasa solo el puntero, lleno o antes de que su primer dato cumpla LOTE_PLAZO_MS.
+// TRANSPORTE_ANILLOS: un anillo sin bloqueos por sensor y un aviso por notificación
+#define TRANSPORTE_COLA     0
+#define TRANSPORTE_LOTES    1
+#define TRANSPORTE_ANILLOS  2
+#define MODO_TRANSPORTE   TRANSPORTE_COLA
+#define LOTE_MUESTRAS     16        // Datos por bloque
+#define LOTE_PLAZO_MS     5000      // Lo más que espera un dato en un bloque a medio llenar
+// Bloques en formato empacado: cada valor en punto fijo con la escala y el tipo de
+// su sensor, y el tick como diferencia con el primero del bloque (0 = sensor_data_t)
+#define LOTE_EMPACADO     0
+
+// Pool de trabajadores: DataProcessor reparte los datos en trabajos de un sensor y
+// NUM_TRABAJADORES tareas, repartidas entre los núcleos, los procesan en paralelo
+// y los agregan en orden por sensor
+#define NUM_TRABAJADORES  2
+// Trabajadores procesando a la vez: la cuenta de counting_semaphore. Con menos que
+// NUM_TRABAJADORES el resto espera el semáforo; con todos, el semáforo no limita
+// nada y los trabajadores no lo tocan
+#define MAX_PROCESANDO    NUM_TRABAJADORES
+
+// Benchmark de trabajadores: datos/s del pool de 1 a NUM_TRABAJADORES trabajadores
+// con el procesamiento de cada dato ocupando la CPU
+#define MODO_BENCHMARK_TRABAJADORES  0
+
+// Benchmark de formato: memoria por 1000 datos y costo de copia, empacado y
+// decodificación de sensor_data_t contra el formato empacado
+#define MODO_BENCHMARK_FORMATO  0
+
+// Benchmark de transporte: en lugar de la práctica, tres productores a tasas
+// crecientes comparan cola, lotes y anillos en datos/s, perdidos, % de CPU y latencia
+#define MODO_BENCHMARK_TRANSPORTE  0
+
+// Prueba de las estadísticas: 10^8 datos de presión por la actualización dato a
+// dato y por bloques contra una referencia en double (en Linux sale con el resultado)
+#define MODO_PRUEBA_ESTADISTICAS  0
+
+// Prueba de estrés de los anillos: productores en los dos núcleos a toda velocidad
+// y un consumidor que comprueba orden y pérdidas (en Linux sale con el resultado)
+#define MODO_PRUEBA_ANILLOS  0
+
+// Perfil de mutex: histogramas de espera y de retención de stats_mutex, timeouts
+// y qué tarea lo tenía cuando otra tuvo que esperarlo
+#define MODO_PERFIL_MUTEX  0
+
+// Traza del planificador: los ganchos de traza_freertos.h anotan cambios de tarea,
+// colas, semáforos e ISRs en un anillo; a los TRAZA_DURACION_MS se vuelca para
+// convertir_traza.py (FreeRTOS se compila con -include traza_freertos.h)
+#define MODO_TRAZA  0
+
+// Perfil de pilas: corre la práctica PERFIL_DURACION_MS, lee la marca de agua de
+// cada tarea e imprime pilas_sincro.h con lo usado más un margen
+#define MODO_PERFIL_PILAS  0
+
+// Pila de cada tarea: la del header generado por MODO_PERFIL_PILAS si está junto a
+// este archivo; al perfilar se ignora para medir siempre con las pilas por defecto
+#if __has_include("pilas_sincro.h") && !MODO_PERFIL_PILAS
+#include "pilas_sincro.h"
+#endif
+#ifndef PILA_SYSTEM_INIT
+#define PILA_SYSTEM_INIT      STACK_SIZE
+#endif
+#ifndef PILA_TEMP_SENSOR
+#define PILA_TEMP_SENSOR      STACK_SIZE
+#endif
+#ifndef PILA_HUMIDITY_SENSOR
+#define PILA_HUMIDITY_SENSOR  STACK_SIZE
+#endif
+#ifndef PILA_PRESSURE_SENSOR
+#define PILA_PRESSURE_SENSOR  STACK_SIZE
+#endif
+#ifndef PILA_DATA_PROCESSOR
+#define PILA_DATA_PROCESSOR   STACK_SIZE
+#endif
+#ifndef PILA_DISPLAY
+#define PILA_DISPLAY          STACK_SIZE
+#endif
+#ifndef PILA_TRABAJADOR
+#define PILA_TRABAJADOR       STACK_SIZE
+#endif
 
 // Tag para logging
 static const char* TAG = "FREERTOS_PRACTICE";
 
+#if MODO_REGISTRO_DIFERIDO
+// Registro diferido: anillos por núcleo y tarea de drenado en registro_diferido.h
+#ifndef PILA_DRENADO
+#define PILA_DRENADO         3072
+#endif
+#include "registro_diferido.h"
+#endif
+
+// Logs de los lazos: al anillo con MODO_REGISTRO_DIFERIDO, si no directo a la UART
+#if MODO_REGISTRO_DIFERIDO
+#define LOGI_DIFERIDO(formato, ...)  REGISTRAR_DIFERIDO(formato, __VA_ARGS__)
+#else
+#define LOGI_DIFERIDO(formato, ...)  ESP_LOGI(TAG, formato, __VA_ARGS__)
+#endif
+
+#if MODO_ESTATICO && !configSUPPORT_STATIC_ALLOCATION
+#error "MODO_ESTATICO requiere configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+#if MODO_TRAZA && !defined(TRAZA_FREERTOS_H)
+#error "MODO_TRAZA requiere compilar FreeRTOS y el programa con -include traza_freertos.h"
+#endif
+
+#if MODO_TRAZA && !configUSE_TRACE_FACILITY
+#error "MODO_TRAZA requiere CONFIG_FREERTOS_USE_TRACE_FACILITY"
+#endif
+
+// Tiempo de arranque: marcar_primera_tarea en arranque.h
+#include "arranque.h"
+
+// Tareas de la práctica, en el orden en que se crean
+typedef enum {
+    TAREA_INIT,
+    TAREA_TEMPERATURA,
+    TAREA_HUMEDAD,
+    TAREA_PRESION,
+    TAREA_PROCESADOR,
+    TAREA_DISPLAY,
+    NUM_TAREAS
+} tarea_practica_t;
+
+#if MODO_PERFIL_PILAS
+// Handles para leer la marca de agua de cada tarea. SystemInit se borra sola
+// antes de la medición, así que deja la suya anotada
+static TaskHandle_t handles_tareas[NUM_TAREAS];
+static uint32_t libre_pila_init;
+#define HANDLE_TAREA(t)  (&handles_tareas[t])
+#else
+#define HANDLE_TAREA(t)  NULL
+#endif
+
 // Estructura para datos del sensor
 typedef struct {
     uint8_t sensor_id;          // ID del sensor (1-3)
@@ -27,12 +175,24 @@ typedef struct {
     uint32_t timestamp;         // Timestamp del dato
 } sensor_data_t;
 
+// Resumen de las estadísticas en flujo de un sensor
+typedef struct {
+    uint64_t muestras;
+    float media;
+    float desviacion;               // Desviación estándar muestral
+    float minimo;
+    float maximo;
+    float ewma;
+    float media_movil;              // De los últimos VENTANA_MEDIA datos (o menos al empezar)
+} resumen_sensor_t;
+
 // Estructura para estadísticas compartidas (protegida por mutex)
 typedef struct {
     float temperature_avg;      // Promedio de temperatura
     float humidity_avg;         // Promedio de humedad  
     float pressure_avg;         // Promedio de presión
-    uint32_t total_samples;     // Total de muestras procesadas
+    uint64_t total_samples;     // Total de muestras procesadas
+    resumen_sensor_t sensores[NUM_SENSORES];    // Por sensor, en orden de sensor_id
 } shared_stats_t;
 
 // ============================================================================
@@ -62,6 +222,460 @@ static SemaphoreHandle_t stats_mutex = NULL;
 // Recurso compartido protegido por mutex
 static shared_stats_t global_stats = {0};
 
+// Perfil de mutex: TOMAR_MUTEX, SOLTAR_MUTEX y el perfilador en perfil_mutex.h
+#include "perfil_mutex.h"
+
+#if MODO_PERFIL_MUTEX
+#define VOLCADO_MUTEX_CADA   8      // Vueltas del display entre volcados CSV (~1 minuto)
+
+static perfil_mutex_t perfil_stats_mutex = { .nombre = "stats_mutex" };
+#endif
+
+#if MODO_TRAZA
+// ============================================================================
+// TRAZA DEL PLANIFICADOR
+// ============================================================================
+// Anillo, volcado y tarea_traza en traza_anillo.h
+#define ARCHIVO_TRAZA        "traza_sincro.txt"
+#include "traza_anillo.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// En la PC la corrida termina con el volcado, así CI puede convertir y comparar la traza
+static void terminar_tras_traza(void) {
+    exit(0);
+}
+#define FIN_TRAZA            terminar_tras_traza
+#else
+#define FIN_TRAZA            NULL
+#endif
+#endif
+
+// Nombres de los objetos del programa en la traza
+#if MODO_TRAZA
+#define TRAZA_NOMBRAR(objeto, nombre)  traza_nombrar((objeto), (nombre))
+#else
+#define TRAZA_NOMBRAR(objeto, nombre)
+#endif
+
+// ============================================================================
+// LAZOS PERIÓDICOS
+// ============================================================================
+
+// Lazo sin deriva con xTaskDelayUntil y precisión de sus liberaciones, en
+// lazo_periodico.h (el mismo de Multitarea.c)
+#include "lazo_periodico.h"
+
+// Lazos de los sensores (índice sensor_id - 1), globales para que el display
+// consulte su precisión. Los tres parten del mismo tick, origen_sensores, así
+// sus liberaciones caen en una rejilla común y las marcas de tiempo se alinean
+static lazo_periodico_t lazos_sensores[NUM_SENSORES];
+static TickType_t origen_sensores;
+static const char *const nombres_sensores[NUM_SENSORES] = { "Temperatura", "Humedad", "Presión" };
+
+#if LOTE_EMPACADO || MODO_BENCHMARK_FORMATO
+// ============================================================================
+// FORMATO EMPACADO
+// ============================================================================
+// sensor_data_t ocupa 12 bytes por dato (id, relleno, float y tick). Para guardar
+// muchos datos de un mismo sensor alcanza con su valor en punto fijo y la
+// diferencia de tick con el primero del bloque. Cada sensor tiene su escala y su
+// tipo fijos en sus funciones inline: al compilar queda una multiplicación y un
+// redondeo, sin tablas de escalas. sensor_data_t sigue siendo la vista
+// decodificada con la que trabaja el procesador.
+
+#define ESCALA_TEMPERATURA  100     // Centésimas de °C en int16_t (20-40 °C)
+#define ESCALA_HUMEDAD      100     // Centésimas de %RH en int16_t (30-90 %)
+#define ESCALA_PRESION      100     // Pa en int32_t (95000-105000 Pa no entra en 16 bits)
+
+// Las diferencias de tick de un bloque son de 16 bits: su plazo tiene que caber
+_Static_assert((uint64_t) LOTE_PLAZO_MS * configTICK_RATE_HZ / 1000 <= UINT16_MAX,
+               "LOTE_PLAZO_MS no entra en las diferencias de 16 bits del formato empacado");
+_Static_assert(LOTE_MUESTRAS <= UINT8_MAX, "bloque_empacado_t cuenta los datos en un uint8_t");
+
+// Redondeo al entero más cercano sin libm
+static inline int32_t redondear(float v) {
+    return (int32_t) (v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+static inline int16_t empacar_temperatura(float celsius) {
+    return (int16_t) redondear(celsius * ESCALA_TEMPERATURA);
+}
+
+static inline float desempacar_temperatura(int16_t crudo) {
+    return (float) crudo / ESCALA_TEMPERATURA;
+}
+
+static inline int16_t empacar_humedad(float porciento) {
+    return (int16_t) redondear(porciento * ESCALA_HUMEDAD);
+}
+
+static inline float desempacar_humedad(int16_t crudo) {
+    return (float) crudo / ESCALA_HUMEDAD;
+}
+
+static inline int32_t empacar_presion(float hpa) {
+    return redondear(hpa * ESCALA_PRESION);
+}
+
+static inline float desempacar_presion(int32_t crudo) {
+    return (float) crudo / ESCALA_PRESION;
+}
+
+// Cabecera de un bloque empacado, la parte común a los dos tipos de valor. Los
+// bloques viajan como puntero a ella y sensor_id dice de qué tipo es el resto
+typedef struct {
+    uint8_t sensor_id;
+    uint8_t cuenta;                             // Datos válidos
+    uint32_t inicio;                            // Tick del primer dato
+    uint16_t deltas[LOTE_MUESTRAS];             // Ticks desde inicio
+} bloque_empacado_t;
+
+// Cada tipo de valor tiene su bloque, del tamaño justo: la temperatura y la
+// humedad no pagan los 32 bits de la presión
+typedef struct {
+    bloque_empacado_t cabecera;
+    int16_t valores[LOTE_MUESTRAS];             // Temperatura y humedad
+} bloque_empacado16_t;
+
+typedef struct {
+    bloque_empacado_t cabecera;
+    int32_t valores[LOTE_MUESTRAS];             // Presión
+} bloque_empacado32_t;
+
+// Solo la presión necesita valores de 32 bits
+static inline bool valores_de_32_bits(uint8_t sensor_id) {
+    return sensor_id == 3;
+}
+
+// Bytes de un bloque del sensor, lo que ocupa en su pool
+static inline size_t tam_bloque_empacado(uint8_t sensor_id) {
+    return valores_de_32_bits(sensor_id) ? sizeof(bloque_empacado32_t) : sizeof(bloque_empacado16_t);
+}
+
+// Anota la diferencia de tick del dato y devuelve su posición en el bloque
+static inline uint32_t agregar_delta(bloque_empacado_t *b, const sensor_data_t *dato) {
+    uint32_t i = b->cuenta++;
+    b->deltas[i] = (uint16_t) (dato->timestamp - b->inicio);
+    return i;
+}
+
+// Un empacador por sensor, con su conversión inline: agrega un dato a un bloque
+// del tipo de su sensor (el llamador cuida que haya lugar)
+typedef void (*empacador_t)(bloque_empacado_t *b, const sensor_data_t *dato);
+
+static void empacar_dato_temperatura(bloque_empacado_t *b, const sensor_data_t *dato) {
+    uint32_t i = agregar_delta(b, dato);
+    ((bloque_empacado16_t *) b)->valores[i] = empacar_temperatura(dato->value);
+}
+
+static void empacar_dato_humedad(bloque_empacado_t *b, const sensor_data_t *dato) {
+    uint32_t i = agregar_delta(b, dato);
+    ((bloque_empacado16_t *) b)->valores[i] = empacar_humedad(dato->value);
+}
+
+static void empacar_dato_presion(bloque_empacado_t *b, const sensor_data_t *dato) {
+    uint32_t i = agregar_delta(b, dato);
+    ((bloque_empacado32_t *) b)->valores[i] = empacar_presion(dato->value);
+}
+
+/**
+ * Vacía el bloque para el sensor del dato, que será su primero
+ * El empacador se elige aquí, una vez por bloque; cada dato va directo a la
+ * conversión de su sensor, sin volver a mirar sensor_id
+ * 
+ * @param b: Bloque del tipo de valor del sensor
+ * @param primero: Primer dato del bloque
+ * @return Empacador para los datos de este bloque
+ */
+static inline empacador_t iniciar_bloque_empacado(bloque_empacado_t *b, const sensor_data_t *primero) {
+    b->sensor_id = primero->sensor_id;
+    b->cuenta = 0;
+    b->inicio = primero->timestamp;
+    switch (primero->sensor_id) {
+        case 1:
+            return empacar_dato_temperatura;
+        case 2:
+            return empacar_dato_humedad;
+        default:
+            return empacar_dato_presion;
+    }
+}
+
+/**
+ * Decodifica un bloque empacado a la vista sensor_data_t
+ * 
+ * @param b: Bloque
+ * @param vista: Lugar para b->cuenta datos
+ * @return Datos decodificados
+ */
+static uint32_t desempacar_bloque(const bloque_empacado_t *b, sensor_data_t *vista) {
+    // Un switch por bloque y no por dato: el lazo de cada sensor queda con su conversión
+    switch (b->sensor_id) {
+        case 1:
+            for (uint32_t i = 0; i < b->cuenta; i++) {
+                vista[i] = (sensor_data_t) { 1, desempacar_temperatura(((const bloque_empacado16_t *) b)->valores[i]),
+                                             b->inicio + b->deltas[i] };
+            }
+            break;
+        case 2:
+            for (uint32_t i = 0; i < b->cuenta; i++) {
+                vista[i] = (sensor_data_t) { 2, desempacar_humedad(((const bloque_empacado16_t *) b)->valores[i]),
+                                             b->inicio + b->deltas[i] };
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < b->cuenta; i++) {
+                vista[i] = (sensor_data_t) { b->sensor_id,
+                                             desempacar_presion(((const bloque_empacado32_t *) b)->valores[i]),
+                                             b->inicio + b->deltas[i] };
+            }
+            break;
+    }
+    return b->cuenta;
+}
+#endif
+
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES || MODO_BENCHMARK_TRANSPORTE
+// ============================================================================
+// TRANSPORTE POR LOTES
+// ============================================================================
+// Con xQueueSend cada dato paga la sección crítica de la cola y, como el
+// procesador tiene más prioridad, un cambio de contexto. Aquí cada productor
+// llena un bloque propio sin tocar el kernel y al cerrarlo pasa solo su puntero
+// por bloques_llenos: una operación de cola cada LOTE_MUESTRAS datos. Los
+// bloques salen de un pool fijo (bloques_libres) y el procesador los devuelve,
+// así que los datos no se copian dentro de la cola ni se usa heap.
+// Un message buffer copiaría el bloque entero y, con tres productores, necesitaría
+// serializar los envíos; una cola de punteros ya admite varios productores.
+
+#define NUM_BLOQUES  (2 * NUM_SENSORES + 2)     // Uno llenándose y otro en tránsito por sensor, más margen
+
+#if LOTE_EMPACADO
+// Los bloques llevan el formato empacado; el procesador los decodifica con vista_de_bloque.
+// Cada tipo de valor tiene su pool: la presión, tres bloques de 32 bits (uno
+// llenándose, otro en tránsito y uno de margen); temperatura y humedad, el resto
+// en bloques de 16. Por la cola pasa el puntero a la cabecera
+#define NUM_BLOQUES32  3
+#define NUM_BLOQUES16  (NUM_BLOQUES - NUM_BLOQUES32)
+typedef bloque_empacado_t bloque_muestras_t;
+#else
+typedef struct {
+    uint8_t sensor_id;
+    uint16_t cuenta;                            // Datos válidos en muestras
+    sensor_data_t muestras[LOTE_MUESTRAS];
+} bloque_muestras_t;
+#endif
+
+// Bloque que está llenando un productor (solo lo toca él)
+typedef struct {
+    bloque_muestras_t *bloque;                  // NULL hasta su próximo dato
+    TickType_t plazo;                           // Tick en que su primer dato cumple LOTE_PLAZO_MS
+#if LOTE_EMPACADO
+    empacador_t empacar;                        // El de su sensor, elegido al abrir el bloque
+#endif
+} lote_sensor_t;
+
+#if LOTE_EMPACADO
+static bloque_empacado16_t bloques_muestras16[NUM_BLOQUES16];
+static bloque_empacado32_t bloques_muestras32[NUM_BLOQUES32];
+static QueueHandle_t bloques_libres32 = NULL;  // Los de presión; bloques_libres, los de 16 bits
+#else
+static bloque_muestras_t bloques_muestras[NUM_BLOQUES];
+#endif
+static QueueHandle_t bloques_libres = NULL;
+static QueueHandle_t bloques_llenos = NULL;
+
+// Pool del que sale y al que vuelve un bloque del sensor
+static inline QueueHandle_t pool_de_sensor(uint8_t sensor_id) {
+#if LOTE_EMPACADO
+    return valores_de_32_bits(sensor_id) ? bloques_libres32 : bloques_libres;
+#else
+    (void) sensor_id;
+    return bloques_libres;
+#endif
+}
+
+/**
+ * Envía el bloque del productor aunque no esté lleno (si no tiene, no hace nada)
+ * bloques_llenos tiene lugar para todo el pool, así que nunca espera
+ */
+static void cerrar_lote(lote_sensor_t *l) {
+    if (l->bloque != NULL) {
+        xQueueSend(bloques_llenos, &l->bloque, 0);
+        l->bloque = NULL;
+    }
+}
+
+/**
+ * Agrega un dato al bloque del productor
+ * El bloque sale lleno, o antes si el dato siguiente llegaría después de su
+ * plazo: ningún dato espera más de LOTE_PLAZO_MS y el productor no tiene que
+ * despertar solo para vaciarlo
+ * 
+ * @param l: Bloque del productor
+ * @param dato: Dato a agregar (su timestamp, en ticks, abre el plazo del bloque)
+ * @param siguiente: Tick del próximo dato de este productor
+ * @param espera: Ticks que se espera un bloque libre
+ * @return false si no hubo bloque libre y el dato se perdió
+ */
+static bool agregar_a_lote(lote_sensor_t *l, const sensor_data_t *dato, TickType_t siguiente,
+                           TickType_t espera) {
+    if (l->bloque == NULL) {
+        if (xQueueReceive(pool_de_sensor(dato->sensor_id), &l->bloque, espera) != pdTRUE) {
+            return false;
+        }
+#if LOTE_EMPACADO
+        l->empacar = iniciar_bloque_empacado(l->bloque, dato);
+#else
+        l->bloque->sensor_id = dato->sensor_id;
+        l->bloque->cuenta = 0;
+#endif
+        l->plazo = (TickType_t) dato->timestamp + pdMS_TO_TICKS(LOTE_PLAZO_MS);
+    }
+    
+#if LOTE_EMPACADO
+    l->empacar(l->bloque, dato);
+#else
+    l->bloque->muestras[l->bloque->cuenta++] = *dato;
+#endif
+    // Diferencia con signo: vale aunque el contador de ticks dé la vuelta
+    if (l->bloque->cuenta == LOTE_MUESTRAS || (int32_t) (siguiente - l->plazo) > 0) {
+        cerrar_lote(l);
+    }
+    return true;
+}
+
+/**
+ * Datos de un bloque como sensor_data_t
+ * 
+ * @param b: Bloque recibido
+ * @param vista: Lugar para LOTE_MUESTRAS datos, donde se decodifica si el bloque está empacado
+ * @return Los datos del bloque (b->cuenta)
+ */
+static const sensor_data_t *vista_de_bloque(const bloque_muestras_t *b, sensor_data_t *vista) {
+#if LOTE_EMPACADO
+    desempacar_bloque(b, vista);
+    return vista;
+#else
+    return b->muestras;
+#endif
+}
+#endif
+
+#if MODO_TRANSPORTE == TRANSPORTE_ANILLOS || MODO_BENCHMARK_TRANSPORTE || MODO_PRUEBA_ANILLOS
+// ============================================================================
+// ANILLOS SPSC POR SENSOR
+// ============================================================================
+// Cada sensor escribe en su propio anillo y solo el procesador lee: con un
+// productor y un consumidor por anillo alcanzan dos índices atómicos, sin
+// secciones críticas ni mutex, y sensores en núcleos distintos no comparten
+// nada. Cada índice va en su línea de caché para que el productor y el
+// consumidor no se invaliden la línea del otro en cada dato.
+// El productor solo avisa (un bit por sensor con xTaskNotify) cuando el
+// consumidor ya había vaciado su anillo; el consumidor vacía todos los
+// anillos avisados en un solo despertar.
+
+#define ANILLO_CAPACIDAD   32       // Datos por anillo (potencia de 2)
+
+typedef struct {
+    uint32_t escritura __attribute__((aligned(LINEA_CACHE)));   // Solo la escribe el productor
+    uint32_t lectura __attribute__((aligned(LINEA_CACHE)));     // Solo la escribe el consumidor
+    sensor_data_t datos[ANILLO_CAPACIDAD] __attribute__((aligned(LINEA_CACHE)));
+} anillo_spsc_t;
+
+// Índices que crecen sin límite: escritura - lectura son los datos en el anillo
+static anillo_spsc_t anillos_sensores[NUM_SENSORES];
+static TaskHandle_t consumidor_anillos = NULL;     // A quién avisar (NULL: nadie todavía)
+
+/**
+ * Pone un dato en el anillo de un sensor (solo desde la tarea de ese sensor)
+ * Nunca espera: con el anillo lleno el dato no entra
+ * 
+ * @param s: Índice del sensor (sensor_id - 1)
+ * @param dato: Dato a copiar
+ * @return false si el anillo estaba lleno
+ */
+static inline bool poner_en_anillo(uint32_t s, const sensor_data_t *dato) {
+    anillo_spsc_t *a = &anillos_sensores[s];
+    uint32_t e = a->escritura;
+    
+    if (e - __atomic_load_n(&a->lectura, __ATOMIC_ACQUIRE) == ANILLO_CAPACIDAD) {
+        return false;
+    }
+    a->datos[e % ANILLO_CAPACIDAD] = *dato;
+    __atomic_store_n(&a->escritura, e + 1, __ATOMIC_RELEASE);
+    
+    // Se avisa solo si el consumidor ya había leído hasta aquí. La barrera pone la
+    // publicación antes de releer lectura; anillos_con_datos hace lo simétrico, así
+    // que al menos uno de los dos ve al otro y el aviso no se pierde
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&a->lectura, __ATOMIC_RELAXED) == e) {
+        TaskHandle_t consumidor = __atomic_load_n(&consumidor_anillos, __ATOMIC_ACQUIRE);
+        if (consumidor != NULL) {
+            xTaskNotify(consumidor, 1u << s, eSetBits);
+        }
+    }
+    return true;
+}
+
+// Copia todo lo que hay en el anillo de un sensor (hasta ANILLO_CAPACIDAD datos) y lo libera
+static uint32_t sacar_de_anillo(uint32_t s, sensor_data_t *destino) {
+    anillo_spsc_t *a = &anillos_sensores[s];
+    uint32_t l = a->lectura;
+    uint32_t e = __atomic_load_n(&a->escritura, __ATOMIC_ACQUIRE);
+    
+    for (uint32_t i = l; i != e; i++) {
+        *destino++ = a->datos[i % ANILLO_CAPACIDAD];
+    }
+    __atomic_store_n(&a->lectura, e, __ATOMIC_RELEASE);
+    return e - l;
+}
+
+// Bits de los anillos que tienen datos, leídos después de publicar lo consumido
+static uint32_t anillos_con_datos(void) {
+    uint32_t con_datos = 0;
+    
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (uint32_t s = 0; s < NUM_SENSORES; s++) {
+        if (__atomic_load_n(&anillos_sensores[s].escritura, __ATOMIC_RELAXED) != anillos_sensores[s].lectura) {
+            con_datos |= 1u << s;
+        }
+    }
+    return con_datos;
+}
+
+// La tarea actual pasa a recibir los avisos; devuelve los anillos que ya tenían datos
+static uint32_t registrar_consumidor_anillos(void) {
+    __atomic_store_n(&consumidor_anillos, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+    return anillos_con_datos();
+}
+
+/**
+ * Espera el aviso de los productores y vacía los anillos avisados
+ * Solo espera si no quedó nada pendiente de la vez anterior
+ * 
+ * @param pendientes: Bits de los anillos a vaciar; al volver, los que recibieron
+ *                    datos mientras tanto (sus productores no avisaron)
+ * @param destino: Lugar para NUM_SENSORES * ANILLO_CAPACIDAD datos
+ * @param espera: Ticks que se espera un aviso
+ * @return Datos copiados (0 si venció la espera)
+ */
+static uint32_t recibir_de_anillos(uint32_t *pendientes, sensor_data_t *destino, TickType_t espera) {
+    uint32_t n = 0;
+    
+    if (*pendientes == 0) {
+        xTaskNotifyWait(0, UINT32_MAX, pendientes, espera);
+    }
+    for (uint32_t s = 0; s < NUM_SENSORES; s++) {
+        if (*pendientes & (1u << s)) {
+            n += sacar_de_anillo(s, destino + n);
+        }
+    }
+    *pendientes = anillos_con_datos();
+    return n;
+}
+#endif
+
 // ============================================================================
 // TAREAS PRODUCTORAS (SENSORES)
 // ============================================================================
@@ -79,20 +693,43 @@ void temperature_sensor_task(void *pvParameters) {
     // Señalar que este sensor está listo
     xEventGroupSetBits(system_events, SENSOR_1_READY_BIT);
     
+    lazo_periodico_t *lazo = &lazos_sensores[sensor_data.sensor_id - 1];
+    iniciar_lazo(lazo, 2000, origen_sensores);
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+    lote_sensor_t lote = { 0 };
+#endif
+    
     while (1) {
         // Simular lectura de sensor (valor entre 20-40°C)
         sensor_data.value = 20.0 + (esp_random() % 2000) / 100.0;
-        sensor_data.timestamp = xTaskGetTickCount();
+        // La liberación ideal de esta vuelta: los tres sensores usan la misma rejilla
+        sensor_data.timestamp = lazo->despertar;
         
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+        // Al bloque del sensor: sale lleno o cuando la próxima lectura pasaría su plazo
+        if (agregar_a_lote(&lote, &sensor_data, lazo->despertar + lazo->periodo, pdMS_TO_TICKS(100))) {
+            LOGI_DIFERIDO("Temp: %.2f°C al bloque", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Sin bloques libres, dato de temperatura perdido");
+        }
+#elif MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+        // A su anillo: sin secciones críticas, y avisa solo si el procesador lo había vaciado
+        if (poner_en_anillo(sensor_data.sensor_id - 1, &sensor_data)) {
+            LOGI_DIFERIDO("Temp: %.2f°C al anillo", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Anillo lleno, dato de temperatura perdido");
+        }
+#else
         // Intentar enviar dato a la cola
         if (xQueueSend(sensor_queue, &sensor_data, pdMS_TO_TICKS(100)) == pdTRUE) {
-            ESP_LOGI(TAG, "Temp: %.2f°C enviada", sensor_data.value);
+            LOGI_DIFERIDO("Temp: %.2f°C enviada", sensor_data.value);
         } else {
             ESP_LOGW(TAG, "Cola llena, dato de temperatura perdido");
         }
+#endif
         
-        // Esperar 2 segundos antes de la siguiente lectura
-        vTaskDelay(pdMS_TO_TICKS(2000));
+        // Siguiente lectura 2 segundos después de la liberación anterior
+        esperar_periodo(lazo);
     }
 }
 
@@ -109,20 +746,43 @@ void humidity_sensor_task(void *pvParameters) {
     // Señalar que este sensor está listo
     xEventGroupSetBits(system_events, SENSOR_2_READY_BIT);
     
+    lazo_periodico_t *lazo = &lazos_sensores[sensor_data.sensor_id - 1];
+    iniciar_lazo(lazo, 3000, origen_sensores);
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+    lote_sensor_t lote = { 0 };
+#endif
+    
     while (1) {
         // Simular lectura de sensor (valor entre 30-90% RH)
         sensor_data.value = 30.0 + (esp_random() % 6000) / 100.0;
-        sensor_data.timestamp = xTaskGetTickCount();
+        // La liberación ideal de esta vuelta: los tres sensores usan la misma rejilla
+        sensor_data.timestamp = lazo->despertar;
         
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+        // Al bloque del sensor: sale lleno o cuando la próxima lectura pasaría su plazo
+        if (agregar_a_lote(&lote, &sensor_data, lazo->despertar + lazo->periodo, pdMS_TO_TICKS(100))) {
+            LOGI_DIFERIDO("Humedad: %.2f%% al bloque", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Sin bloques libres, dato de humedad perdido");
+        }
+#elif MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+        // A su anillo: sin secciones críticas, y avisa solo si el procesador lo había vaciado
+        if (poner_en_anillo(sensor_data.sensor_id - 1, &sensor_data)) {
+            LOGI_DIFERIDO("Humedad: %.2f%% al anillo", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Anillo lleno, dato de humedad perdido");
+        }
+#else
         // Intentar enviar dato a la cola
         if (xQueueSend(sensor_queue, &sensor_data, pdMS_TO_TICKS(100)) == pdTRUE) {
-            ESP_LOGI(TAG, "Humedad: %.2f%% enviada", sensor_data.value);
+            LOGI_DIFERIDO("Humedad: %.2f%% enviada", sensor_data.value);
         } else {
             ESP_LOGW(TAG, "Cola llena, dato de humedad perdido");
         }
+#endif
         
-        // Esperar 3 segundos antes de la siguiente lectura
-        vTaskDelay(pdMS_TO_TICKS(3000));
+        // Siguiente lectura 3 segundos después de la liberación anterior
+        esperar_periodo(lazo);
     }
 }
 
@@ -139,20 +799,380 @@ void pressure_sensor_task(void *pvParameters) {
     // Señalar que este sensor está listo
     xEventGroupSetBits(system_events, SENSOR_3_READY_BIT);
     
+    lazo_periodico_t *lazo = &lazos_sensores[sensor_data.sensor_id - 1];
+    iniciar_lazo(lazo, 4000, origen_sensores);
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+    lote_sensor_t lote = { 0 };
+#endif
+    
     while (1) {
         // Simular lectura de sensor (valor entre 950-1050 hPa)
         sensor_data.value = 950.0 + (esp_random() % 10000) / 100.0;
-        sensor_data.timestamp = xTaskGetTickCount();
+        // La liberación ideal de esta vuelta: los tres sensores usan la misma rejilla
+        sensor_data.timestamp = lazo->despertar;
         
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+        // Al bloque del sensor: sale lleno o cuando la próxima lectura pasaría su plazo
+        if (agregar_a_lote(&lote, &sensor_data, lazo->despertar + lazo->periodo, pdMS_TO_TICKS(100))) {
+            LOGI_DIFERIDO("Presión: %.2f hPa al bloque", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Sin bloques libres, dato de presión perdido");
+        }
+#elif MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+        // A su anillo: sin secciones críticas, y avisa solo si el procesador lo había vaciado
+        if (poner_en_anillo(sensor_data.sensor_id - 1, &sensor_data)) {
+            LOGI_DIFERIDO("Presión: %.2f hPa al anillo", sensor_data.value);
+        } else {
+            ESP_LOGW(TAG, "Anillo lleno, dato de presión perdido");
+        }
+#else
         // Intentar enviar dato a la cola
         if (xQueueSend(sensor_queue, &sensor_data, pdMS_TO_TICKS(100)) == pdTRUE) {
-            ESP_LOGI(TAG, "Presión: %.2f hPa enviada", sensor_data.value);
+            LOGI_DIFERIDO("Presión: %.2f hPa enviada", sensor_data.value);
         } else {
             ESP_LOGW(TAG, "Cola llena, dato de presión perdido");
         }
+#endif
         
-        // Esperar 4 segundos antes de la siguiente lectura
-        vTaskDelay(pdMS_TO_TICKS(4000));
+        // Siguiente lectura 4 segundos después de la liberación anterior
+        esperar_periodo(lazo);
+    }
+}
+
+// ============================================================================
+// ESTADÍSTICAS EN FLUJO
+// ============================================================================
+// Estadísticas de un sensor con O(1) por dato y sin guardar la historia:
+// - media y varianza con el método de Welford, en double: una suma float de
+//   valores de ~1000 hPa deja de crecer bien mucho antes de los 10^8 datos, y la
+//   media incremental en float se estanca cuando (x - media) / n cae bajo su ulp;
+// - mínimo, máximo y media móvil exponencial (EWMA), en float porque no acumulan;
+// - media móvil de los últimos VENTANA_MEDIA datos sobre un anillo. Su suma se
+//   actualiza con el dato que entra y el que sale, y se recalcula desde el
+//   anillo en cada vuelta, así el redondeo no se acumula más allá de una vuelta.
+// La cuenta es de 64 bits. estadistica_agregar_bloque hace todo en una pasada
+// por el bloque, con la media y la varianza del bloque en float relativas a su
+// primer dato (valores chicos, sin cancelación), y una sola combinación en double.
+
+#define VENTANA_MEDIA  16           // Datos de la media móvil
+#define ALFA_EWMA      0.1f         // Peso del dato nuevo en la EWMA
+#define TRAMO_BLOQUE   32           // Datos por llamada a la actualización por bloque
+
+typedef struct {
+    uint64_t n;                     // Datos acumulados
+    double media;
+    double m2;                      // Suma de los cuadrados de las diferencias con la media
+    float minimo;
+    float maximo;
+    float ewma;
+    float ventana[VENTANA_MEDIA];   // Últimos datos
+    float suma_ventana;
+    uint32_t pos_ventana;           // Posición del próximo dato en el anillo
+} estadistica_flujo_t;
+
+// Mínimo, máximo, EWMA y ventana: lo que se actualiza igual dato a dato y por bloque
+static inline void agregar_sin_media(estadistica_flujo_t *e, float x, uint64_t previos) {
+    if (previos == 0) {
+        e->minimo = e->maximo = e->ewma = x;
+    } else {
+        e->minimo = x < e->minimo ? x : e->minimo;
+        e->maximo = x > e->maximo ? x : e->maximo;
+        e->ewma += ALFA_EWMA * (x - e->ewma);
+    }
+    
+    if (previos >= VENTANA_MEDIA) {
+        e->suma_ventana += x - e->ventana[e->pos_ventana];
+    } else {
+        e->suma_ventana += x;
+    }
+    e->ventana[e->pos_ventana] = x;
+    if (++e->pos_ventana == VENTANA_MEDIA) {
+        // Cada vuelta del anillo, la suma vuelve a salir de los datos
+        e->pos_ventana = 0;
+        float suma = 0;
+        for (int i = 0; i < VENTANA_MEDIA; i++) {
+            suma += e->ventana[i];
+        }
+        e->suma_ventana = suma;
+    }
+}
+
+static void estadistica_iniciar(estadistica_flujo_t *e) {
+    *e = (estadistica_flujo_t) { 0 };
+}
+
+// Agrega un dato (Welford)
+static void estadistica_agregar(estadistica_flujo_t *e, float x) {
+    agregar_sin_media(e, x, e->n);
+    e->n++;
+    double d = x - e->media;
+    e->media += d / e->n;
+    e->m2 += d * (x - e->media);
+}
+
+/**
+ * Agrega un bloque de datos en una pasada
+ * El bloque se resume en float relativo a su primer dato y se combina con lo
+ * acumulado con la fórmula de Chan: una sola operación en double por bloque
+ * 
+ * @param e: Estadística
+ * @param valores: Datos del bloque, en orden de llegada
+ * @param n: Cantidad de datos
+ */
+static void estadistica_agregar_bloque(estadistica_flujo_t *e, const float *valores, uint32_t n) {
+    if (n == 0) {
+        return;
+    }
+    
+    float base = valores[0];
+    float media_bloque = 0, m2_bloque = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        agregar_sin_media(e, valores[i], e->n + i);
+        float d = (valores[i] - base) - media_bloque;
+        media_bloque += d / (float) (i + 1);
+        m2_bloque += d * ((valores[i] - base) - media_bloque);
+    }
+    
+    uint64_t total = e->n + n;
+    double delta = (base + (double) media_bloque) - e->media;
+    e->media += delta * n / total;
+    e->m2 += m2_bloque + delta * delta * ((double) e->n * n / total);
+    e->n = total;
+}
+
+// Resume la estadística para publicarla
+static void estadistica_resumir(const estadistica_flujo_t *e, resumen_sensor_t *r) {
+    uint32_t en_ventana = e->n < VENTANA_MEDIA ? (uint32_t) e->n : VENTANA_MEDIA;
+    *r = (resumen_sensor_t) {
+        .muestras = e->n,
+        .media = (float) e->media,
+        .desviacion = e->n > 1 ? (float) sqrt(e->m2 / (e->n - 1)) : 0.0f,
+        .minimo = e->minimo,
+        .maximo = e->maximo,
+        .ewma = e->ewma,
+        .media_movil = en_ventana > 0 ? e->suma_ventana / en_ventana : 0.0f,
+    };
+}
+
+// ============================================================================
+// POOL DE TRABAJADORES
+// ============================================================================
+// DataProcessor ya no procesa: reparte lo que recibe en trabajos de hasta
+// TRAMO_BLOQUE datos seguidos de un mismo sensor, numerados por sensor, y
+// NUM_TRABAJADORES tareas fijas a los núcleos por turno los toman de la cola
+// trabajos_pendientes. El procesamiento de cada dato corre en paralelo; la
+// agregación no puede, porque la EWMA y la media móvil dependen del orden.
+// Cada trabajador deja su trabajo procesado en la ranura de su número en el
+// agregado de su sensor e intenta tomar la bandera 'aplicando' de ese sensor:
+// quien la tiene agrega en orden todos los trabajos listos y devuelve cada uno
+// al pool. Cada sensor tiene su bandera, así que no hay un lock global, y quien
+// no la consigue no espera: el que la tiene agrega también su trabajo.
+// Al soltar la bandera se vuelve a mirar la ranura siguiente (los dos lados
+// con __ATOMIC_SEQ_CST): o el que dejó un trabajo ve la bandera libre, o el que
+// la soltó ve el trabajo, y ninguno queda sin agregar.
+// Con NUM_TRABAJOS trabajos en total, un sensor nunca tiene dos trabajos en
+// vuelo en la misma ranura: el trabajo se devuelve después de vaciar la suya.
+
+#define NUM_TRABAJOS         (2 * NUM_TRABAJADORES + 2)     // Trabajos del pool
+#define COLA_PENDIENTES      (NUM_TRABAJOS + NUM_TRABAJADORES)  // Los trabajos y un NULL por trabajador
+#define PROCESO_ITERACIONES  1000       // Costo del procesamiento de cada dato
+
+_Static_assert(MAX_PROCESANDO >= 1 && MAX_PROCESANDO <= NUM_TRABAJADORES,
+               "MAX_PROCESANDO va de 1 a NUM_TRABAJADORES");
+
+typedef struct {
+    uint8_t sensor;                     // sensor_id - 1
+    uint16_t cuenta;                    // Datos en el trabajo
+    uint32_t secuencia;                 // Orden del trabajo entre los de su sensor
+    float valores[TRAMO_BLOQUE];        // En orden de llegada; se procesan en el lugar
+} trabajo_t;
+
+typedef struct {
+    // Cada sensor en sus propias líneas de caché: trabajadores de núcleos
+    // distintos que agregan sensores distintos no se invalidan la línea
+    estadistica_flujo_t estadistica __attribute__((aligned(LINEA_CACHE)));   // Solo con 'aplicando'
+    uint32_t siguiente;                 // Secuencia del próximo trabajo a agregar (solo con 'aplicando')
+    uint32_t asignados;                 // Secuencias repartidas (solo el repartidor)
+    trabajo_t *listos[NUM_TRABAJOS];    // Procesados esperando su turno, en secuencia % NUM_TRABAJOS
+    uint8_t aplicando;                  // Un trabajador está agregando este sensor
+} agregado_sensor_t;
+
+static trabajo_t trabajos[NUM_TRABAJOS];
+static QueueHandle_t trabajos_libres = NULL;
+static QueueHandle_t trabajos_pendientes = NULL;   // Trabajos, o NULL para que un trabajador termine
+static agregado_sensor_t agregados_sensores[NUM_SENSORES];
+static TaskHandle_t tareas_trabajadores[NUM_TRABAJADORES];
+static SemaphoreHandle_t limite_trabajadores = NULL;   // Procesamiento concurrente (NULL: sin límite)
+static bool publicar_agregados = false;                // Publicar en global_stats al agregar
+static TaskHandle_t aviso_fin_trabajadores = NULL;     // A quién avisa un trabajador al terminar
+
+/**
+ * Procesamiento de un dato: PROCESO_ITERACIONES pasos de Newton para su raíz
+ * cuadrada, que se vuelve a elevar (el dato sale igual salvo redondeo). Ocupa
+ * la CPU de verdad, a diferencia del vTaskDelay que simulaba el cálculo
+ * 
+ * @param x: Dato (positivo, como los de los tres sensores)
+ * @return Dato procesado
+ */
+static float procesar_muestra(float x) {
+    float raiz = x > 1.0f ? x : 1.0f;
+    for (int i = 0; i < PROCESO_ITERACIONES; i++) {
+        raiz = 0.5f * (raiz + x / raiz);
+    }
+    return raiz * raiz;
+}
+
+// Vacía el pool: todos los trabajos libres y los agregados en cero
+static void reiniciar_pool_trabajos(void) {
+    xQueueReset(trabajos_libres);
+    xQueueReset(trabajos_pendientes);
+    for (uint32_t i = 0; i < NUM_TRABAJOS; i++) {
+        trabajo_t *trabajo = &trabajos[i];
+        xQueueSend(trabajos_libres, &trabajo, 0);
+    }
+    memset(agregados_sensores, 0, sizeof(agregados_sensores));
+    for (int s = 0; s < NUM_SENSORES; s++) {
+        estadistica_iniciar(&agregados_sensores[s].estadistica);
+    }
+}
+
+/**
+ * Publica el resumen de un sensor en global_stats y avisa al display cada 10
+ * datos. Se llama con la bandera del sensor tomada, así que los resúmenes de un
+ * sensor se publican en orden
+ * 
+ * @param s: Índice del sensor
+ */
+static void publicar_sensor(int s) {
+    // Resumir fuera del mutex: la sección crítica solo copia
+    resumen_sensor_t resumen;
+    estadistica_resumir(&agregados_sensores[s].estadistica, &resumen);
+    
+    // Actualizar estadísticas globales (recurso compartido)
+    // SECCIÓN CRÍTICA protegida por mutex
+    if (TOMAR_MUTEX(stats_mutex, &perfil_stats_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        uint64_t decenas_previas = global_stats.total_samples / 10;
+        
+        global_stats.sensores[s] = resumen;
+        global_stats.temperature_avg = global_stats.sensores[0].media;
+        global_stats.humidity_avg = global_stats.sensores[1].media;
+        global_stats.pressure_avg = global_stats.sensores[2].media;
+        global_stats.total_samples = 0;
+        for (int i = 0; i < NUM_SENSORES; i++) {
+            global_stats.total_samples += global_stats.sensores[i].muestras;
+        }
+        bool nueva_decena = global_stats.total_samples / 10 != decenas_previas;
+        
+        // Liberar mutex
+        SOLTAR_MUTEX(stats_mutex, &perfil_stats_mutex);
+        
+        // Cada 10 muestras, señalar procesamiento completo (un trabajo puede
+        // pasar varias decenas de una vez)
+        if (nueva_decena) {
+            xEventGroupSetBits(system_events, PROCESSING_DONE_BIT);
+        }
+    } else {
+        ESP_LOGW(TAG, "No se pudo acceder a estadísticas globales");
+    }
+}
+
+/**
+ * Entrega un trabajo procesado: lo deja en su ranura y, si ningún otro
+ * trabajador está agregando su sensor, agrega en orden todo lo que esté listo
+ * 
+ * @param trabajo: Trabajo ya procesado
+ */
+static void entregar_trabajo(trabajo_t *trabajo) {
+    // Desde que queda en su ranura, otro trabajador puede agregarlo y devolverlo
+    // al pool, y DataProcessor reusarlo: después no se vuelve a leer
+    uint8_t s = trabajo->sensor;
+    agregado_sensor_t *a = &agregados_sensores[s];
+    __atomic_store_n(&a->listos[trabajo->secuencia % NUM_TRABAJOS], trabajo, __ATOMIC_SEQ_CST);
+    
+    // Si la bandera ya estaba tomada, quien la tiene agrega también este trabajo
+    while (!__atomic_exchange_n(&a->aplicando, 1, __ATOMIC_SEQ_CST)) {
+        uint32_t agregados = 0;
+        trabajo_t *listo;
+        while ((listo = __atomic_load_n(&a->listos[a->siguiente % NUM_TRABAJOS], __ATOMIC_ACQUIRE)) != NULL) {
+            __atomic_store_n(&a->listos[a->siguiente % NUM_TRABAJOS], NULL, __ATOMIC_RELAXED);
+            estadistica_agregar_bloque(&a->estadistica, listo->valores, listo->cuenta);
+            a->siguiente++;
+            agregados++;
+            xQueueSend(trabajos_libres, &listo, 0);
+        }
+        if (agregados > 0 && publicar_agregados) {
+            publicar_sensor(s);
+        }
+        
+        // Un trabajo que llegó mientras se agregaba vio la bandera tomada:
+        // si su ranura es la siguiente, hay que volver a intentarlo
+        uint32_t siguiente = a->siguiente;
+        __atomic_store_n(&a->aplicando, 0, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&a->listos[siguiente % NUM_TRABAJOS], __ATOMIC_SEQ_CST) == NULL) {
+            break;
+        }
+    }
+}
+
+/**
+ * Tarea Trabajadora
+ * Procesa trabajos de cualquier sensor y los entrega para agregarlos en orden.
+ * Un NULL en la cola la termina (solo lo usa el benchmark)
+ */
+void trabajador_task(void *pvParameters) {
+    trabajo_t *trabajo;
+    
+    while (xQueueReceive(trabajos_pendientes, &trabajo, portMAX_DELAY) == pdTRUE && trabajo != NULL) {
+        // Tomar semáforo contador para limitar procesamiento concurrente
+        if (limite_trabajadores != NULL) {
+            xSemaphoreTake(limite_trabajadores, portMAX_DELAY);
+        }
+        for (uint32_t i = 0; i < trabajo->cuenta; i++) {
+            trabajo->valores[i] = procesar_muestra(trabajo->valores[i]);
+        }
+        if (limite_trabajadores != NULL) {
+            xSemaphoreGive(limite_trabajadores);
+        }
+        
+        entregar_trabajo(trabajo);
+    }
+    
+    if (aviso_fin_trabajadores != NULL) {
+        xTaskNotifyGive(aviso_fin_trabajadores);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * Reparte datos de cualquier sensor en trabajos: cada tramo seguido de un mismo
+ * sensor (hasta TRAMO_BLOQUE datos) es un trabajo con la siguiente secuencia
+ * de su sensor. Un bloque de lotes da un trabajo, los anillos uno por sensor y
+ * la cola uno por dato. Espera si no hay trabajos libres
+ * 
+ * @param muestras: Datos en orden de llegada
+ * @param n: Cantidad de datos
+ */
+static void repartir_muestras(const sensor_data_t *muestras, uint32_t n) {
+    trabajo_t *trabajo = NULL;
+    
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t id = muestras[i].sensor_id;
+        if (id < 1 || id > NUM_SENSORES) {
+            continue;
+        }
+        if (trabajo == NULL) {
+            xQueueReceive(trabajos_libres, &trabajo, portMAX_DELAY);
+            trabajo->sensor = id - 1;
+            trabajo->cuenta = 0;
+        }
+        trabajo->valores[trabajo->cuenta++] = muestras[i].value;
+        
+        bool fin_tramo = i + 1 == n || muestras[i + 1].sensor_id != id || trabajo->cuenta == TRAMO_BLOQUE;
+        if (fin_tramo) {
+            trabajo->secuencia = agregados_sensores[id - 1].asignados++;
+            xQueueSend(trabajos_pendientes, &trabajo, portMAX_DELAY);
+            trabajo = NULL;
+        }
     }
 }
 
@@ -162,12 +1182,19 @@ void pressure_sensor_task(void *pvParameters) {
 
 /**
  * Tarea Procesadora de Datos (Consumidor)
- * Recibe datos de la cola, los procesa y actualiza estadísticas compartidas
+ * Recibe datos de la cola y los reparte entre los trabajadores, que los
+ * procesan y actualizan las estadísticas compartidas
  */
 void data_processor_task(void *pvParameters) {
+#if MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+    static sensor_data_t recibidos[NUM_SENSORES * ANILLO_CAPACIDAD];
+    // Antes de esperar a los sensores, para que sus avisos ya lleguen a esta tarea
+    uint32_t pendientes = registrar_consumidor_anillos();
+#elif MODO_TRANSPORTE == TRANSPORTE_LOTES
+    static sensor_data_t vista[LOTE_MUESTRAS];     // Decodificación de los bloques empacados
+#else
     sensor_data_t received_data;
-    static float temp_sum = 0, humidity_sum = 0, pressure_sum = 0;
-    static uint16_t temp_count = 0, humidity_count = 0, pressure_count = 0;
+#endif
     
     ESP_LOGI(TAG, "Procesador de datos iniciado");
     
@@ -182,68 +1209,42 @@ void data_processor_task(void *pvParameters) {
     ESP_LOGI(TAG, "Todos los sensores listos, iniciando procesamiento");
     
     while (1) {
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+        // Un bloque trae varios datos de un sensor: una recepción y un
+        // trabajo por bloque
+        bloque_muestras_t *bloque;
+        if (xQueueReceive(bloques_llenos, &bloque, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            const sensor_data_t *muestras = vista_de_bloque(bloque, vista);
+            uint32_t num_muestras = bloque->cuenta;
+#elif MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+        // Un aviso con un bit por sensor: se vacían todos los anillos avisados de una vez
+        uint32_t num_muestras = recibir_de_anillos(&pendientes, recibidos, pdMS_TO_TICKS(1000));
+        if (num_muestras > 0) {
+            const sensor_data_t *muestras = recibidos;
+#else
         // Intentar recibir dato de la cola
         if (xQueueReceive(sensor_queue, &received_data, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            const sensor_data_t *muestras = &received_data;
+            uint32_t num_muestras = 1;
+#endif
             
-            // Tomar semáforo contador para limitar procesamiento concurrente
-            if (xSemaphoreTake(counting_semaphore, pdMS_TO_TICKS(500)) == pdTRUE) {
-                
-                ESP_LOGI(TAG, "Procesando dato del sensor %d: %.2f", 
-                         received_data.sensor_id, received_data.value);
-                
-                // Simular procesamiento (tiempo de cálculo)
-                vTaskDelay(pdMS_TO_TICKS(100));
-                
-                // Acumular datos por tipo de sensor
-                switch (received_data.sensor_id) {
-                    case 1: // Temperatura
-                        temp_sum += received_data.value;
-                        temp_count++;
-                        break;
-                    case 2: // Humedad
-                        humidity_sum += received_data.value;
-                        humidity_count++;
-                        break;
-                    case 3: // Presión
-                        pressure_sum += received_data.value;
-                        pressure_count++;
-                        break;
-                }
-                
-                // Actualizar estadísticas globales (recurso compartido)
-                // SECCIÓN CRÍTICA protegida por mutex
-                if (xSemaphoreTake(stats_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                    
-                    // Calcular promedios
-                    if (temp_count > 0) {
-                        global_stats.temperature_avg = temp_sum / temp_count;
-                    }
-                    if (humidity_count > 0) {
-                        global_stats.humidity_avg = humidity_sum / humidity_count;
-                    }
-                    if (pressure_count > 0) {
-                        global_stats.pressure_avg = pressure_sum / pressure_count;
-                    }
-                    
-                    global_stats.total_samples = temp_count + humidity_count + pressure_count;
-                    
-                    // Liberar mutex
-                    xSemaphoreGive(stats_mutex);
-                } else {
-                    ESP_LOGW(TAG, "No se pudo acceder a estadísticas globales");
-                }
-                
-                // Liberar semáforo contador
-                xSemaphoreGive(counting_semaphore);
-                
-                // Si hemos procesado suficientes muestras, señalar procesamiento completo
-                if (global_stats.total_samples > 0 && (global_stats.total_samples % 10) == 0) {
-                    xEventGroupSetBits(system_events, PROCESSING_DONE_BIT);
-                }
-                
-            } else {
-                ESP_LOGW(TAG, "Semáforo contador no disponible, saltando procesamiento");
-            }
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+            LOGI_DIFERIDO("Procesando bloque del sensor %d: %" PRIu32 " datos",
+                          bloque->sensor_id, num_muestras);
+#elif MODO_TRANSPORTE == TRANSPORTE_ANILLOS
+            LOGI_DIFERIDO("Procesando %" PRIu32 " datos de los anillos", num_muestras);
+#else
+            LOGI_DIFERIDO("Procesando dato del sensor %d: %.2f",
+                          received_data.sensor_id, received_data.value);
+#endif
+            
+            // Los trabajadores procesan y agregan; aquí solo se copian los datos
+            repartir_muestras(muestras, num_muestras);
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+            
+            // Los datos ya están en los trabajos: el bloque vuelve al pool
+            xQueueSend(pool_de_sensor(bloque->sensor_id), &bloque, 0);
+#endif
         }
     }
 }
@@ -277,26 +1278,46 @@ void display_task(void *pvParameters) {
         
         // Acceder a estadísticas globales (recurso compartido)
         // SECCIÓN CRÍTICA protegida por mutex
-        if (xSemaphoreTake(stats_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (TOMAR_MUTEX(stats_mutex, &perfil_stats_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
             
             // Copiar estadísticas a variable local para minimizar tiempo en sección crítica
             memcpy(&local_stats, &global_stats, sizeof(shared_stats_t));
             
             // Liberar mutex inmediatamente
-            xSemaphoreGive(stats_mutex);
+            SOLTAR_MUTEX(stats_mutex, &perfil_stats_mutex);
             
             // Mostrar estadísticas (fuera de la sección crítica)
             ESP_LOGI(TAG, "=== ESTADÍSTICAS DEL SISTEMA ===");
             ESP_LOGI(TAG, "Temperatura promedio: %.2f°C", local_stats.temperature_avg);
             ESP_LOGI(TAG, "Humedad promedio: %.2f%%", local_stats.humidity_avg);
             ESP_LOGI(TAG, "Presión promedio: %.2f hPa", local_stats.pressure_avg);
-            ESP_LOGI(TAG, "Total muestras procesadas: %lu", local_stats.total_samples);
+            ESP_LOGI(TAG, "Total muestras procesadas: %" PRIu64, local_stats.total_samples);
+            for (int i = 0; i < NUM_SENSORES; i++) {
+                const resumen_sensor_t *r = &local_stats.sensores[i];
+                ESP_LOGI(TAG, "%s: %" PRIu64 " datos, media %.2f, desviación %.2f, mín %.2f, máx %.2f, "
+                         "EWMA %.2f, media móvil %.2f",
+                         nombres_sensores[i], r->muestras, r->media, r->desviacion, r->minimo, r->maximo,
+                         r->ewma, r->media_movil);
+            }
+            for (int i = 0; i < NUM_SENSORES; i++) {
+                mostrar_precision(nombres_sensores[i], &lazos_sensores[i].medicion);
+            }
+#if MODO_PERFIL_MUTEX
+            mostrar_perfil_mutex(&perfil_stats_mutex);
+#endif
             ESP_LOGI(TAG, "================================");
             
         } else {
             ESP_LOGW(TAG, "No se pudieron obtener estadísticas para display");
         }
         
+#if MODO_PERFIL_MUTEX
+        static uint32_t vueltas_display;
+        if (++vueltas_display % VOLCADO_MUTEX_CADA == 0) {
+            volcar_perfil_mutex(&perfil_stats_mutex);
+        }
+#endif
+        
         // Actualizar display cada 8 segundos
         vTaskDelay(pdMS_TO_TICKS(8000));
     }
@@ -311,6 +1332,8 @@ void display_task(void *pvParameters) {
  * Coordina el arranque usando semáforos binarios
  */
 void system_init_task(void *pvParameters) {
+    // Es siempre la primera tarea: las demás se crean cuando termina
+    marcar_primera_tarea();
     ESP_LOGI(TAG, "Iniciando sistema de monitoreo...");
     
     // Simular tiempo de inicialización del hardware
@@ -323,21 +1346,1022 @@ void system_init_task(void *pvParameters) {
     
     ESP_LOGI(TAG, "Sistema listo para operar");
     
+#if MODO_PERFIL_PILAS
+    libre_pila_init = uxTaskGetStackHighWaterMark(NULL);
+#endif
+    
     // Esta tarea ha completado su función, se puede eliminar
     vTaskDelete(NULL);
 }
 
+// ============================================================================
+// MEMORIA ESTÁTICA
+// ============================================================================
+
+#if MODO_ESTATICO
+// Toda la memoria de los objetos de FreeRTOS del programa, con los mismos tamaños
+// que usa el modo dinámico. Queda en .bss, se conoce al enlazar y las APIs
+// ...Static no pueden fallar con buffers válidos
+
+static StackType_t pila_system_init[PILA_SYSTEM_INIT];
+static StackType_t pila_temp_sensor[PILA_TEMP_SENSOR];
+static StackType_t pila_humidity_sensor[PILA_HUMIDITY_SENSOR];
+static StackType_t pila_pressure_sensor[PILA_PRESSURE_SENSOR];
+static StackType_t pila_data_processor[PILA_DATA_PROCESSOR];
+static StackType_t pila_display[PILA_DISPLAY];
+static StaticTask_t tcbs_tareas[NUM_TAREAS];
+static StackType_t pilas_trabajadores[NUM_TRABAJADORES][PILA_TRABAJADOR];
+static StaticTask_t tcbs_trabajadores[NUM_TRABAJADORES];
+
+static uint8_t almacen_cola_sensores[QUEUE_SIZE * sizeof(sensor_data_t)];
+static StaticQueue_t cola_sensores_estatica;
+static StaticSemaphore_t semaforo_binario_estatico;
+static StaticSemaphore_t semaforo_contador_estatico;
+static StaticSemaphore_t mutex_estadisticas_estatico;
+static StaticEventGroup_t eventos_sistema_estatico;
+static uint8_t almacen_trabajos_libres[NUM_TRABAJOS * sizeof(trabajo_t *)];
+static uint8_t almacen_trabajos_pendientes[COLA_PENDIENTES * sizeof(trabajo_t *)];
+static StaticQueue_t cola_trabajos_libres_estatica;
+static StaticQueue_t cola_trabajos_pendientes_estatica;
+
+#if MODO_REGISTRO_DIFERIDO
+static StackType_t pila_drenado[PILA_DRENADO];
+static StaticTask_t tcb_drenado;
+#endif
+
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES || MODO_BENCHMARK_TRANSPORTE
+static uint8_t almacen_bloques_libres[NUM_BLOQUES * sizeof(bloque_muestras_t *)];
+static uint8_t almacen_bloques_llenos[NUM_BLOQUES * sizeof(bloque_muestras_t *)];
+static StaticQueue_t cola_bloques_libres_estatica;
+static StaticQueue_t cola_bloques_llenos_estatica;
+#if LOTE_EMPACADO
+static uint8_t almacen_bloques_libres32[NUM_BLOQUES32 * sizeof(bloque_muestras_t *)];
+static StaticQueue_t cola_bloques_libres32_estatica;
+#endif
+#endif
+
+/**
+ * Crea una tarea de la práctica con su pila y TCB estáticos (no puede fallar)
+ */
+static void crear_tarea_estatica(TaskFunction_t funcion, const char *nombre, UBaseType_t prioridad,
+                                 StackType_t *pila, uint32_t tam_pila, tarea_practica_t indice) {
+    TaskHandle_t handle = xTaskCreateStatic(funcion, nombre, tam_pila, NULL, prioridad, pila,
+                                            &tcbs_tareas[indice]);
+    TaskHandle_t *destino = HANDLE_TAREA(indice);
+    if (destino != NULL) {
+        *destino = handle;
+    }
+}
+#endif
+
+/**
+ * Crea las colas del pool de trabajadores y deja todos los trabajos libres
+ * 
+ * @param limite: Semáforo que limita el procesamiento concurrente (NULL: sin límite)
+ * @param publicar: Publicar en global_stats cada vez que se agrega un sensor
+ * @return false si no hubo memoria (en memoria estática no puede fallar)
+ */
+static bool crear_pool_trabajos(SemaphoreHandle_t limite, bool publicar) {
+#if MODO_ESTATICO
+    trabajos_libres = xQueueCreateStatic(NUM_TRABAJOS, sizeof(trabajo_t *), almacen_trabajos_libres,
+                                         &cola_trabajos_libres_estatica);
+    trabajos_pendientes = xQueueCreateStatic(COLA_PENDIENTES, sizeof(trabajo_t *), almacen_trabajos_pendientes,
+                                             &cola_trabajos_pendientes_estatica);
+#else
+    trabajos_libres = xQueueCreate(NUM_TRABAJOS, sizeof(trabajo_t *));
+    trabajos_pendientes = xQueueCreate(COLA_PENDIENTES, sizeof(trabajo_t *));
+    if (trabajos_libres == NULL || trabajos_pendientes == NULL) {
+        return false;
+    }
+#endif
+    limite_trabajadores = limite;
+    publicar_agregados = publicar;
+    reiniciar_pool_trabajos();
+    TRAZA_NOMBRAR(trabajos_libres, "trabajos_libres");
+    TRAZA_NOMBRAR(trabajos_pendientes, "trabajos_pendientes");
+    return true;
+}
+
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES || MODO_BENCHMARK_TRANSPORTE
+/**
+ * Crea las colas de punteros del transporte por lotes y deja todo el pool libre
+ * 
+ * @return false si no hubo memoria (en memoria estática no puede fallar)
+ */
+static bool crear_pool_bloques(void) {
+#if MODO_ESTATICO
+    bloques_libres = xQueueCreateStatic(NUM_BLOQUES, sizeof(bloque_muestras_t *), almacen_bloques_libres,
+                                        &cola_bloques_libres_estatica);
+    bloques_llenos = xQueueCreateStatic(NUM_BLOQUES, sizeof(bloque_muestras_t *), almacen_bloques_llenos,
+                                        &cola_bloques_llenos_estatica);
+#if LOTE_EMPACADO
+    bloques_libres32 = xQueueCreateStatic(NUM_BLOQUES32, sizeof(bloque_muestras_t *), almacen_bloques_libres32,
+                                          &cola_bloques_libres32_estatica);
+#endif
+#else
+    bloques_libres = xQueueCreate(NUM_BLOQUES, sizeof(bloque_muestras_t *));
+    bloques_llenos = xQueueCreate(NUM_BLOQUES, sizeof(bloque_muestras_t *));
+    if (bloques_libres == NULL || bloques_llenos == NULL) {
+        return false;
+    }
+#if LOTE_EMPACADO
+    bloques_libres32 = xQueueCreate(NUM_BLOQUES32, sizeof(bloque_muestras_t *));
+    if (bloques_libres32 == NULL) {
+        return false;
+    }
+#endif
+#endif
+#if LOTE_EMPACADO
+    for (uint32_t i = 0; i < NUM_BLOQUES16; i++) {
+        bloque_muestras_t *bloque = &bloques_muestras16[i].cabecera;
+        xQueueSend(bloques_libres, &bloque, 0);
+    }
+    for (uint32_t i = 0; i < NUM_BLOQUES32; i++) {
+        bloque_muestras_t *bloque = &bloques_muestras32[i].cabecera;
+        xQueueSend(bloques_libres32, &bloque, 0);
+    }
+    TRAZA_NOMBRAR(bloques_libres32, "bloques_libres32");
+#else
+    for (uint32_t i = 0; i < NUM_BLOQUES; i++) {
+        bloque_muestras_t *bloque = &bloques_muestras[i];
+        xQueueSend(bloques_libres, &bloque, 0);
+    }
+#endif
+    TRAZA_NOMBRAR(bloques_libres, "bloques_libres");
+    TRAZA_NOMBRAR(bloques_llenos, "bloques_llenos");
+    return true;
+}
+#endif
+
+#if MODO_PERFIL_PILAS
+// ============================================================================
+// PERFIL DE PILAS
+// ============================================================================
+// Después de PERFIL_DURACION_MS de trabajo normal se lee la marca de agua de cada
+// tarea (lo mínimo que le quedó libre) y se imprime un header con la pila usada
+// más un margen, entre dos marcas para copiarlo junto a este archivo. En el
+// puerto Linux además se escribe directo en el directorio de trabajo.
+// Solo cuenta lo que se ejecutó: conviene perfilar con los modos que se van a usar
+// El margen y el generador del header están en perfil_pilas.h
+
+#define ARCHIVO_PILAS             "pilas_sincro.h"
+
+#include "perfil_pilas.h"
+
+/**
+ * Espera a que la práctica trabaje un rato, mide las pilas y publica el header
+ */
+void tarea_perfil_pilas(void *pvParameters) {
+    static const struct {
+        const char *macro;
+        uint32_t pila;
+    } pilas[NUM_TAREAS] = {
+        [TAREA_INIT]        = { "PILA_SYSTEM_INIT",     PILA_SYSTEM_INIT },
+        [TAREA_TEMPERATURA] = { "PILA_TEMP_SENSOR",     PILA_TEMP_SENSOR },
+        [TAREA_HUMEDAD]     = { "PILA_HUMIDITY_SENSOR", PILA_HUMIDITY_SENSOR },
+        [TAREA_PRESION]     = { "PILA_PRESSURE_SENSOR", PILA_PRESSURE_SENSOR },
+        [TAREA_PROCESADOR]  = { "PILA_DATA_PROCESSOR",  PILA_DATA_PROCESSOR },
+        [TAREA_DISPLAY]     = { "PILA_DISPLAY",         PILA_DISPLAY },
+    };
+    perfil_pila_t perfiles[NUM_TAREAS + 2];
+    size_t n = 0;
+    
+    vTaskDelay(pdMS_TO_TICKS(PERFIL_DURACION_MS));
+    
+    for (int t = 0; t < NUM_TAREAS; t++) {
+        // SystemInit ya no existe: se usa lo que anotó antes de borrarse
+        uint32_t libre = t == TAREA_INIT ? libre_pila_init : uxTaskGetStackHighWaterMark(handles_tareas[t]);
+        perfiles[n++] = (perfil_pila_t) { pilas[t].macro, pilas[t].pila, libre, 1 };
+    }
+    // Los trabajadores comparten la macro: manda el que menos pila dejó libre
+    perfiles[n++] = (perfil_pila_t) { "PILA_TRABAJADOR", PILA_TRABAJADOR,
+                                      libre_minimo_pilas(tareas_trabajadores, NUM_TRABAJADORES, PILA_TRABAJADOR),
+                                      NUM_TRABAJADORES };
+#if MODO_REGISTRO_DIFERIDO
+    perfiles[n++] = (perfil_pila_t) { "PILA_DRENADO", PILA_DRENADO, uxTaskGetStackHighWaterMark(tarea_drenado), 1 };
+#endif
+    
+    publicar_header_pilas(ARCHIVO_PILAS, NULL, perfiles, n);
+    vTaskDelete(NULL);
+}
+#endif
+
+#if MODO_BENCHMARK_TRANSPORTE
+// ============================================================================
+// BENCHMARK DE TRANSPORTE
+// ============================================================================
+// Tres productores generan datos a la misma tasa durante BENCH_TRANSPORTE_MS y
+// un consumidor de más prioridad (como el procesador) los recibe y solo los
+// suma, así lo que se mide es el transporte. Cada tasa se corre con la cola (un
+// xQueueSend por dato, sin esperar: si está llena el dato se pierde), con lotes
+// y con los anillos SPSC.
+// Con más datos por segundo que ticks, cada productor genera a cada tick, en
+// ráfaga, los que ya le correspondían, como un sensor que entrega por DMA.
+// Cada dato lleva en value el microsegundo en que se generó, contado desde el
+// inicio de la corrida (exacto en float hasta 16 s): el consumidor saca la
+// latencia al recibirlo.
+// El % de CPU sale de una tarea contadora de prioridad 0 por núcleo: lo que
+// dejan de contar respecto de una corrida sin carga es lo que usaron las demás,
+// cambios de contexto y secciones críticas del kernel incluidos.
+
+#define BENCH_TRANSPORTE_MS  2000           // Duración de cada corrida
+#define PILA_BENCH           3072
+
+static const uint32_t tasas_bench_hz[] = { 10, 100, 1000, 2000, 5000, 10000 };     // Por sensor
+#define NUM_TASAS_BENCH  (sizeof(tasas_bench_hz) / sizeof(tasas_bench_hz[0]))
+
+typedef enum {
+    BENCH_COLA,
+    BENCH_LOTES,
+    BENCH_ANILLOS,
+    NUM_BENCH_TRANSPORTE
+} transporte_bench_t;
+
+static const char *nombres_transporte[NUM_BENCH_TRANSPORTE] = { "cola", "lotes", "anillos" };
+
+typedef struct {
+    uint32_t entregadas;        // Datos que llegaron al consumidor
+    uint32_t perdidas;          // Cola llena, sin bloques libres o anillo lleno
+    uint32_t cpu_porciento;     // De todos los núcleos
+    bool con_latencia;          // Sin latencia para lotes empacados
+    uint32_t latencia_media_us;
+    uint32_t latencia_max_us;
+} resultado_bench_t;
+
+static QueueHandle_t cola_bench = NULL;
+static TaskHandle_t bench_principal;
+static volatile transporte_bench_t bench_transporte;   // Transporte de la corrida
+static volatile uint32_t bench_tasa_hz;
+static volatile bool bench_corriendo;
+static int64_t bench_inicio_us;
+static uint32_t bench_productores;          // Productores que aún no cerraron su último bloque
+static uint32_t bench_perdidas;
+static resultado_bench_t bench_recibido;    // Lo que midió el consumidor
+static volatile uint32_t vueltas_ociosas[portNUM_PROCESSORS];
+
+// Cuenta mientras nadie más quiere su núcleo (prioridad 0, junto a la tarea IDLE)
+static void tarea_contador_ocioso(void *pvParameters) {
+    volatile uint32_t *vueltas = &vueltas_ociosas[(uintptr_t) pvParameters];
+    while (1) {
+        (*vueltas)++;
+    }
+}
+
+static uint32_t contar_ociosas(void) {
+    uint32_t total = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        total += vueltas_ociosas[c];
+    }
+    return total;
+}
+
+// Productor del benchmark: los datos que le tocan a la tasa actual, con el transporte actual
+static void productor_bench(void *pvParameters) {
+    uint8_t id = (uint8_t) (uintptr_t) pvParameters;
+    lote_sensor_t lote = { 0 };
+    uint64_t generados = 0;
+    uint32_t perdidas = 0;
+    
+    while (bench_corriendo) {
+        int64_t ahora_us = esp_timer_get_time() - bench_inicio_us;
+        uint64_t debidos = (uint64_t) ahora_us * bench_tasa_hz / 1000000;
+        TickType_t ahora = xTaskGetTickCount();
+        for (; generados < debidos; generados++) {
+            // El microsegundo de generación no entra en el punto fijo de los bloques empacados
+            float valor = LOTE_EMPACADO && bench_transporte == BENCH_LOTES ? 0.0f : (float) ahora_us;
+            sensor_data_t dato = { .sensor_id = id, .value = valor, .timestamp = ahora };
+            bool enviado;
+            switch (bench_transporte) {
+                case BENCH_COLA:
+                    enviado = xQueueSend(cola_bench, &dato, 0) == pdTRUE;
+                    break;
+                case BENCH_LOTES:
+                    enviado = agregar_a_lote(&lote, &dato, ahora + 1, 0);
+                    break;
+                default:
+                    enviado = poner_en_anillo(id - 1, &dato);
+                    break;
+            }
+            if (!enviado) {
+                perdidas++;
+            }
+        }
+        vTaskDelay(1);
+    }
+    
+    cerrar_lote(&lote);
+    __atomic_fetch_add(&bench_perdidas, perdidas, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&bench_productores, 1, __ATOMIC_RELEASE);
+    xTaskNotifyGive(bench_principal);
+    vTaskDelete(NULL);
+}
+
+// Consumidor del benchmark: recibe, suma latencias y termina cuando los productores
+// terminaron y no queda nada
+static void consumidor_bench(void *pvParameters) {
+    static sensor_data_t recibidos[NUM_SENSORES * ANILLO_CAPACIDAD];
+    uint32_t entregadas = 0;
+    uint64_t latencia_total = 0;
+    uint32_t latencia_max = 0;
+    uint32_t pendientes = bench_transporte == BENCH_ANILLOS ? registrar_consumidor_anillos() : 0;
+    bool con_latencia = !(LOTE_EMPACADO && bench_transporte == BENCH_LOTES);
+    
+    while (1) {
+        const sensor_data_t *muestras = recibidos;
+        uint32_t n = 0;
+        bloque_muestras_t *bloque = NULL;
+        switch (bench_transporte) {
+            case BENCH_COLA:
+                n = xQueueReceive(cola_bench, &recibidos[0], pdMS_TO_TICKS(50)) == pdTRUE;
+                break;
+            case BENCH_LOTES:
+                if (xQueueReceive(bloques_llenos, &bloque, pdMS_TO_TICKS(50)) == pdTRUE) {
+                    muestras = vista_de_bloque(bloque, recibidos);
+                    n = bloque->cuenta;
+                }
+                break;
+            default:
+                n = recibir_de_anillos(&pendientes, recibidos, pdMS_TO_TICKS(50));
+                break;
+        }
+        
+        // Una lectura del reloj por recepción: la cola paga una por dato, como paga el envío
+        int64_t ahora_us = esp_timer_get_time() - bench_inicio_us;
+        for (uint32_t i = 0; i < n && con_latencia; i++) {
+            uint32_t latencia = (uint32_t) (ahora_us - (int64_t) muestras[i].value);
+            latencia_total += latencia;
+            if (latencia > latencia_max) {
+                latencia_max = latencia;
+            }
+        }
+        entregadas += n;
+        if (bloque != NULL) {
+            xQueueSend(pool_de_sensor(bloque->sensor_id), &bloque, 0);
+        }
+        
+        if (n == 0 && __atomic_load_n(&bench_productores, __ATOMIC_ACQUIRE) == 0) {
+            break;
+        }
+    }
+    
+    if (bench_transporte == BENCH_ANILLOS) {
+        __atomic_store_n(&consumidor_anillos, NULL, __ATOMIC_RELEASE);
+    }
+    bench_recibido = (resultado_bench_t) {
+        .entregadas = entregadas,
+        .con_latencia = con_latencia,
+        .latencia_media_us = entregadas > 0 ? (uint32_t) (latencia_total / entregadas) : 0,
+        .latencia_max_us = latencia_max,
+    };
+    xTaskNotifyGive(bench_principal);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Corre una tasa con un transporte
+ * 
+ * @param transporte: Cola, lotes o anillos
+ * @param tasa_hz: Datos por segundo de cada productor
+ * @param vueltas_base: Lo que cuentan las tareas ociosas sin carga en BENCH_TRANSPORTE_MS
+ */
+static resultado_bench_t correr_bench_transporte(transporte_bench_t transporte, uint32_t tasa_hz,
+                                                 uint32_t vueltas_base) {
+    bench_transporte = transporte;
+    bench_tasa_hz = tasa_hz;
+    bench_perdidas = 0;
+    bench_productores = NUM_SENSORES;
+    bench_inicio_us = esp_timer_get_time();
+    bench_corriendo = true;
+    
+    xTaskCreate(consumidor_bench, "BenchConsumidor", PILA_BENCH, NULL, 4, NULL);
+    for (uintptr_t id = 1; id <= NUM_SENSORES; id++) {
+        xTaskCreate(productor_bench, "BenchProductor", PILA_BENCH, (void *) id, 3, NULL);
+    }
+    
+    uint32_t antes = contar_ociosas();
+    vTaskDelay(pdMS_TO_TICKS(BENCH_TRANSPORTE_MS));
+    uint32_t ociosas = contar_ociosas() - antes;
+    bench_corriendo = false;
+    
+    // Los productores y después el consumidor, cuando vació lo que quedaba
+    for (int i = 0; i < NUM_SENSORES + 1; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    
+    resultado_bench_t r = bench_recibido;
+    r.perdidas = bench_perdidas;
+    r.cpu_porciento = ociosas >= vueltas_base ? 0 : 100 - (uint32_t) ((uint64_t) ociosas * 100 / vueltas_base);
+    return r;
+}
+
+// Compara cola, lotes y anillos a tasas crecientes
+static void ejecutar_benchmark_transporte(void) {
+    TaskHandle_t contadores[portNUM_PROCESSORS];
+    
+    bench_principal = xTaskGetCurrentTaskHandle();
+    // Por encima de productores y consumidor para medir a tiempo
+    vTaskPrioritySet(NULL, 5);
+    
+    cola_bench = xQueueCreate(QUEUE_SIZE, sizeof(sensor_data_t));
+    if (cola_bench == NULL || !crear_pool_bloques()) {
+        ESP_LOGE(TAG, "Error creando la cola o el pool de bloques del benchmark");
+        return;
+    }
+    for (uintptr_t c = 0; c < portNUM_PROCESSORS; c++) {
+        xTaskCreatePinnedToCore(tarea_contador_ocioso, "BenchOcioso", PILA_BENCH, (void *) c, 0,
+                                &contadores[c], c);
+    }
+    
+    // Lo que cuentan sin carga: el 0 % de CPU
+    uint32_t antes = contar_ociosas();
+    vTaskDelay(pdMS_TO_TICKS(BENCH_TRANSPORTE_MS));
+    uint32_t vueltas_base = contar_ociosas() - antes;
+    
+    ESP_LOGI(TAG, "=== Benchmark de transporte: %d sensores, cola de %d, bloques de %d, anillos de %d, %d núcleos ===",
+             NUM_SENSORES, QUEUE_SIZE, LOTE_MUESTRAS, ANILLO_CAPACIDAD, portNUM_PROCESSORS);
+    for (size_t t = 0; t < NUM_TASAS_BENCH; t++) {
+        for (int v = 0; v < NUM_BENCH_TRANSPORTE; v++) {
+            resultado_bench_t r = correr_bench_transporte(v, tasas_bench_hz[t], vueltas_base);
+            if (r.con_latencia) {
+                ESP_LOGI(TAG, "%6" PRIu32 " Hz x %d | %-7s | %8" PRIu32 " datos/s | %7" PRIu32 " perdidos | "
+                         "CPU %3" PRIu32 "%% | latencia media %" PRIu32 " us, máx %" PRIu32 " us",
+                         tasas_bench_hz[t], NUM_SENSORES, nombres_transporte[v],
+                         r.entregadas * 1000 / BENCH_TRANSPORTE_MS, r.perdidas, r.cpu_porciento,
+                         r.latencia_media_us, r.latencia_max_us);
+            } else {
+                ESP_LOGI(TAG, "%6" PRIu32 " Hz x %d | %-7s | %8" PRIu32 " datos/s | %7" PRIu32 " perdidos | "
+                         "CPU %3" PRIu32 "%% | sin latencia (empacado)",
+                         tasas_bench_hz[t], NUM_SENSORES, nombres_transporte[v],
+                         r.entregadas * 1000 / BENCH_TRANSPORTE_MS, r.perdidas, r.cpu_porciento);
+            }
+        }
+    }
+    
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        vTaskDelete(contadores[c]);
+    }
+    vTaskPrioritySet(NULL, 1);
+}
+#endif
+
+#if MODO_PRUEBA_ANILLOS
+// ============================================================================
+// PRUEBA DE ESTRÉS DE LOS ANILLOS
+// ============================================================================
+// Cada productor, fijo a un núcleo (0, 1, 0...), pone PRUEBA_ANILLOS_DATOS
+// datos numerados en su anillo tan rápido como puede; si está lleno cede la CPU
+// y reintenta. El consumidor, fijo al último núcleo, comprueba que de cada
+// sensor lleguen todos, en orden y sin repetidos. Una espera de un segundo con
+// productores activos sería un aviso perdido, y también se cuenta.
+// En el puerto Linux todas las tareas comparten un núcleo simulado, pero se
+// desalojan en cualquier punto; al terminar el programa sale con 0 si la prueba
+// pasó, para usarla en CI.
+
+#define PRUEBA_ANILLOS_DATOS   200000       // Por productor
+#define PRUEBA_ANILLOS_MAX_MS  60000        // Más que esto es que se trabó
+
+typedef struct {
+    uint32_t recibidos[NUM_SENSORES];
+    uint32_t desordenados;          // Número de secuencia distinto del esperado
+    uint32_t esperas_vencidas;      // Esperas de un segundo con datos por llegar
+    uint32_t anillo_lleno;          // Reintentos de los productores
+} resultado_prueba_anillos_t;
+
+static resultado_prueba_anillos_t prueba_anillos;
+static TaskHandle_t prueba_principal;
+
+static void productor_prueba_anillos(void *pvParameters) {
+    uint32_t s = (uint32_t) (uintptr_t) pvParameters;
+    uint32_t llenos = 0;
+    
+    for (uint32_t i = 0; i < PRUEBA_ANILLOS_DATOS; i++) {
+        sensor_data_t dato = { .sensor_id = s + 1, .value = (float) i, .timestamp = i };
+        while (!poner_en_anillo(s, &dato)) {
+            llenos++;
+            taskYIELD();
+        }
+    }
+    
+    __atomic_fetch_add(&prueba_anillos.anillo_lleno, llenos, __ATOMIC_RELAXED);
+    xTaskNotifyGive(prueba_principal);
+    vTaskDelete(NULL);
+}
+
+static void consumidor_prueba_anillos(void *pvParameters) {
+    static sensor_data_t recibidos[NUM_SENSORES * ANILLO_CAPACIDAD];
+    uint32_t esperado[NUM_SENSORES] = { 0 };
+    uint32_t total = 0;
+    uint32_t pendientes = registrar_consumidor_anillos();
+    
+    while (total < NUM_SENSORES * PRUEBA_ANILLOS_DATOS) {
+        int64_t antes = esp_timer_get_time();
+        uint32_t n = recibir_de_anillos(&pendientes, recibidos, pdMS_TO_TICKS(1000));
+        if (n == 0 && esp_timer_get_time() - antes >= 1000000) {
+            prueba_anillos.esperas_vencidas++;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t s = recibidos[i].sensor_id - 1;
+            if (recibidos[i].timestamp != esperado[s]) {
+                prueba_anillos.desordenados++;
+            }
+            esperado[s] = recibidos[i].timestamp + 1;
+            prueba_anillos.recibidos[s]++;
+        }
+        total += n;
+    }
+    
+    __atomic_store_n(&consumidor_anillos, NULL, __ATOMIC_RELEASE);
+    xTaskNotifyGive(prueba_principal);
+    vTaskDelete(NULL);
+}
+
+// Corre la prueba y devuelve true si ningún dato se perdió ni llegó fuera de orden
+static bool ejecutar_prueba_anillos(void) {
+    prueba_principal = xTaskGetCurrentTaskHandle();
+    // Por encima de todas para vigilar el tiempo aunque un productor gire sin parar
+    vTaskPrioritySet(NULL, 5);
+    
+    ESP_LOGI(TAG, "=== Prueba de anillos: %d productores x %d datos, anillos de %d, %d núcleos ===",
+             NUM_SENSORES, PRUEBA_ANILLOS_DATOS, ANILLO_CAPACIDAD, portNUM_PROCESSORS);
+    
+    int64_t inicio = esp_timer_get_time();
+    xTaskCreatePinnedToCore(consumidor_prueba_anillos, "PruebaConsumidor", STACK_SIZE, NULL, 4, NULL,
+                            portNUM_PROCESSORS - 1);
+    for (uintptr_t s = 0; s < NUM_SENSORES; s++) {
+        xTaskCreatePinnedToCore(productor_prueba_anillos, "PruebaProductor", STACK_SIZE, (void *) s, 3, NULL,
+                                s % portNUM_PROCESSORS);
+    }
+    
+    // Los productores y el consumidor
+    uint32_t terminadas = 0;
+    while (terminadas < NUM_SENSORES + 1 &&
+           ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(PRUEBA_ANILLOS_MAX_MS)) > 0) {
+        terminadas++;
+    }
+    int64_t duracion_us = esp_timer_get_time() - inicio;
+    
+    bool correcto = terminadas == NUM_SENSORES + 1 && prueba_anillos.desordenados == 0 &&
+                    prueba_anillos.esperas_vencidas == 0;
+    for (int s = 0; s < NUM_SENSORES; s++) {
+        ESP_LOGI(TAG, "Sensor %d: %" PRIu32 " de %d recibidos", s + 1, prueba_anillos.recibidos[s],
+                 PRUEBA_ANILLOS_DATOS);
+        correcto &= prueba_anillos.recibidos[s] == PRUEBA_ANILLOS_DATOS;
+    }
+    ESP_LOGI(TAG, "Desordenados %" PRIu32 ", esperas vencidas %" PRIu32 ", anillo lleno %" PRIu32 " veces, "
+             "%" PRId64 " us (%" PRId64 " datos/ms)",
+             prueba_anillos.desordenados, prueba_anillos.esperas_vencidas, prueba_anillos.anillo_lleno,
+             duracion_us, duracion_us > 0 ? (int64_t) NUM_SENSORES * PRUEBA_ANILLOS_DATOS * 1000 / duracion_us : 0);
+    
+    if (correcto) {
+        ESP_LOGI(TAG, "Prueba de anillos OK: todos los datos, en orden");
+    } else if (terminadas < NUM_SENSORES + 1) {
+        ESP_LOGE(TAG, "Prueba de anillos FALLIDA: sin terminar a los %d ms", PRUEBA_ANILLOS_MAX_MS);
+    } else {
+        ESP_LOGE(TAG, "Prueba de anillos FALLIDA: datos perdidos o fuera de orden");
+    }
+    vTaskPrioritySet(NULL, 1);
+    return correcto;
+}
+#endif
+
+#if MODO_BENCHMARK_FORMATO
+// ============================================================================
+// BENCHMARK DE FORMATO
+// ============================================================================
+// BENCH_FORMATO_DATOS datos de cada sensor, en sus rangos y a un dato por tick,
+// en los dos formatos: memoria que ocupan y cuánto cuesta copiarlos (dato a dato
+// con memcpy, como la cola, o por bloques), empacarlos y decodificarlos. También
+// el error máximo de la ida y vuelta, que no debe pasar de media unidad de la
+// escala, y que los ticks vuelvan exactos.
+
+#define BENCH_FORMATO_DATOS         1000
+#define BENCH_FORMATO_REPETICIONES  200
+#define BLOQUES_BENCH_FORMATO       ((BENCH_FORMATO_DATOS + LOTE_MUESTRAS - 1) / LOTE_MUESTRAS)
+
+static sensor_data_t formato_origen[BENCH_FORMATO_DATOS];
+static sensor_data_t formato_destino[BENCH_FORMATO_DATOS];
+// Los bloques de cada tipo de valor, como en los pools del transporte
+static bloque_empacado16_t formato_empacado16[BLOQUES_BENCH_FORMATO];
+static bloque_empacado16_t formato_copia16[BLOQUES_BENCH_FORMATO];
+static bloque_empacado32_t formato_empacado32[BLOQUES_BENCH_FORMATO];
+static bloque_empacado32_t formato_copia32[BLOQUES_BENCH_FORMATO];
+
+// Nanosegundos por cada 1000 datos de una medición de todas las repeticiones
+static uint32_t ns_por_mil(int64_t duracion_us) {
+    return (uint32_t) (duracion_us * 1000 * 1000 / ((int64_t) BENCH_FORMATO_REPETICIONES * BENCH_FORMATO_DATOS));
+}
+
+// Cabecera del bloque b del sensor, en el arreglo de su tipo de valor
+static bloque_empacado_t *bloque_formato(uint8_t sensor_id, uint32_t b) {
+    return valores_de_32_bits(sensor_id) ? &formato_empacado32[b].cabecera : &formato_empacado16[b].cabecera;
+}
+
+// Empaca formato_origen en bloques de LOTE_MUESTRAS datos, como agregar_a_lote:
+// el empacador se elige al iniciar cada bloque
+static void empacar_origen(void) {
+    bloque_empacado_t *b = NULL;
+    empacador_t empacar = NULL;
+    for (uint32_t i = 0; i < BENCH_FORMATO_DATOS; i++) {
+        if (i % LOTE_MUESTRAS == 0) {
+            b = bloque_formato(formato_origen[i].sensor_id, i / LOTE_MUESTRAS);
+            empacar = iniciar_bloque_empacado(b, &formato_origen[i]);
+        }
+        empacar(b, &formato_origen[i]);
+    }
+}
+
+// Decodifica los bloques del sensor en formato_destino
+static void desempacar_destino(uint8_t sensor_id) {
+    sensor_data_t *vista = formato_destino;
+    for (uint32_t b = 0; b < BLOQUES_BENCH_FORMATO; b++) {
+        vista += desempacar_bloque(bloque_formato(sensor_id, b), vista);
+    }
+}
+
+// Compara memoria y costo de copia de los dos formatos para cada sensor
+static void ejecutar_benchmark_formato(void) {
+    ESP_LOGI(TAG, "=== Benchmark de formato: %d datos por sensor, bloques de %d, %d repeticiones ===",
+             BENCH_FORMATO_DATOS, LOTE_MUESTRAS, BENCH_FORMATO_REPETICIONES);
+    ESP_LOGI(TAG, "sensor_data_t: %u B por dato; bloques empacados: %u B con valores de 16 bits, "
+             "%u B con 32 (cabecera y ticks %u B)",
+             (unsigned) sizeof(sensor_data_t), (unsigned) sizeof(bloque_empacado16_t),
+             (unsigned) sizeof(bloque_empacado32_t), (unsigned) sizeof(bloque_empacado_t));
+    
+    for (uint8_t id = 1; id <= NUM_SENSORES; id++) {
+        // Datos como los de las tareas, uno por tick
+        for (uint32_t i = 0; i < BENCH_FORMATO_DATOS; i++) {
+            float valor = id == 1 ? 20.0 + (esp_random() % 2000) / 100.0 :
+                          id == 2 ? 30.0 + (esp_random() % 6000) / 100.0 :
+                                    950.0 + (esp_random() % 10000) / 100.0;
+            formato_origen[i] = (sensor_data_t) { id, valor, i };
+        }
+        
+        int64_t inicio = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FORMATO_REPETICIONES; r++) {
+            for (uint32_t i = 0; i < BENCH_FORMATO_DATOS; i++) {
+                memcpy(&formato_destino[i], &formato_origen[i], sizeof(sensor_data_t));
+            }
+            // Que el compilador no junte ni quite repeticiones
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+        int64_t copia_us = esp_timer_get_time() - inicio;
+        
+        inicio = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FORMATO_REPETICIONES; r++) {
+            empacar_origen();
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+        int64_t empacar_us = esp_timer_get_time() - inicio;
+        
+        // Cada bloque se copia entero, con el tamaño de su tipo
+        bool de_32_bits = valores_de_32_bits(id);
+        size_t tam_bloque = tam_bloque_empacado(id);
+        const uint8_t *empacados = de_32_bits ? (const uint8_t *) formato_empacado32
+                                              : (const uint8_t *) formato_empacado16;
+        uint8_t *copias = de_32_bits ? (uint8_t *) formato_copia32 : (uint8_t *) formato_copia16;
+        inicio = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FORMATO_REPETICIONES; r++) {
+            for (uint32_t b = 0; b < BLOQUES_BENCH_FORMATO; b++) {
+                memcpy(&copias[b * tam_bloque], &empacados[b * tam_bloque], tam_bloque);
+            }
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+        int64_t copia_empacada_us = esp_timer_get_time() - inicio;
+        
+        inicio = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FORMATO_REPETICIONES; r++) {
+            desempacar_destino(id);
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+        int64_t desempacar_us = esp_timer_get_time() - inicio;
+        
+        // La ida y vuelta: error del valor y ticks exactos
+        float error_max = 0;
+        bool ticks_exactos = true;
+        for (uint32_t i = 0; i < BENCH_FORMATO_DATOS; i++) {
+            float error = formato_destino[i].value - formato_origen[i].value;
+            error = error < 0 ? -error : error;
+            if (error > error_max) {
+                error_max = error;
+            }
+            ticks_exactos &= formato_destino[i].timestamp == formato_origen[i].timestamp &&
+                             formato_destino[i].sensor_id == id;
+        }
+        
+        // Memoria: los bloques del tipo del sensor, los mismos de su pool
+        ESP_LOGI(TAG, "%s: por 1000 datos %u B sin empacar, %u B empacados (bloques de %u B, valores de %d bits)",
+                 nombres_sensores[id - 1],
+                 (unsigned) (sizeof(sensor_data_t) * 1000),
+                 (unsigned) (BLOQUES_BENCH_FORMATO * tam_bloque * 1000 / BENCH_FORMATO_DATOS),
+                 (unsigned) tam_bloque, de_32_bits ? 32 : 16);
+        ESP_LOGI(TAG, "    por 1000 datos: copia %" PRIu32 " ns sin empacar, %" PRIu32 " ns empacados; "
+                 "empacar %" PRIu32 " ns, decodificar %" PRIu32 " ns",
+                 ns_por_mil(copia_us), ns_por_mil(copia_empacada_us), ns_por_mil(empacar_us),
+                 ns_por_mil(desempacar_us));
+        ESP_LOGI(TAG, "    error máximo %.6f (escala 1/%d), ticks %s", error_max,
+                 id == 1 ? ESCALA_TEMPERATURA : id == 2 ? ESCALA_HUMEDAD : ESCALA_PRESION,
+                 ticks_exactos ? "exactos" : "DISTINTOS");
+    }
+}
+#endif
+
+#if MODO_PRUEBA_ESTADISTICAS
+// ============================================================================
+// PRUEBA DE PRECISIÓN DE LAS ESTADÍSTICAS
+// ============================================================================
+// PRUEBA_ESTADISTICAS_DATOS datos de presión (el peor caso: ~1000 hPa) pasan a
+// la vez por la actualización dato a dato, por la de bloques y por una
+// referencia en double: sumas compensadas (Kahan) relativas al primer dato para
+// la media y la varianza, y la misma EWMA y ventana en double. Cada bloque se
+// comparan EWMA y media móvil; al final, cuenta, media, desviación, mínimo y
+// máximo. Como contraste se muestra la media de la suma float que se usaba antes.
+// Los datos salen de un generador fijo, así todas las corridas son iguales. En el
+// ESP32 la double es por software y tarda minutos; en el puerto Linux, segundos,
+// y el programa sale con 0 si la prueba pasó.
+
+#define PRUEBA_ESTADISTICAS_DATOS  100000000ULL
+#define PRUEBA_BLOQUE              LOTE_MUESTRAS
+#define TOLERANCIA_MEDIA           1e-6     // hPa, en media y desviación
+#define TOLERANCIA_FLOAT           1e-3     // hPa, en EWMA y media móvil (un décimo de la resolución)
+
+// Suma compensada de Kahan
+typedef struct {
+    double suma;
+    double compensacion;
+} suma_kahan_t;
+
+static inline void sumar_kahan(suma_kahan_t *k, double x) {
+    double y = x - k->compensacion;
+    double t = k->suma + y;
+    k->compensacion = (t - k->suma) - y;
+    k->suma = t;
+}
+
+// Generador fijo (xorshift32): presión como la del sensor, de 950 a 1050 hPa
+static inline float presion_de_prueba(uint32_t *estado) {
+    uint32_t x = *estado;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *estado = x;
+    return 950.0 + (x % 10000) / 100.0;
+}
+
+static inline double diferencia(double a, double b) {
+    return a > b ? a - b : b - a;
+}
+
+// Corre la prueba y devuelve true si las dos actualizaciones siguen a la referencia
+static bool ejecutar_prueba_estadisticas(void) {
+    static estadistica_flujo_t por_dato, por_bloque;
+    static double ventana_ref[VENTANA_MEDIA];
+    float bloque[PRUEBA_BLOQUE];
+    suma_kahan_t suma = { 0 }, suma_cuadrados = { 0 };
+    double ewma_ref = 0, suma_ventana_ref = 0, base = 0;
+    float minimo_ref = 0, maximo_ref = 0;
+    float suma_float = 0;                   // Como la hacía data_processor_task
+    double error_ewma = 0, error_ventana = 0;
+    uint32_t estado = 12345;
+    
+    ESP_LOGI(TAG, "=== Prueba de estadísticas: %llu datos de presión, bloques de %d ===",
+             PRUEBA_ESTADISTICAS_DATOS, PRUEBA_BLOQUE);
+    estadistica_iniciar(&por_dato);
+    estadistica_iniciar(&por_bloque);
+    int64_t inicio = esp_timer_get_time();
+    
+    for (uint64_t i = 0; i < PRUEBA_ESTADISTICAS_DATOS; i++) {
+        float x = presion_de_prueba(&estado);
+        estadistica_agregar(&por_dato, x);
+        bloque[i % PRUEBA_BLOQUE] = x;
+        suma_float += x;
+        
+        // Referencia
+        if (i == 0) {
+            base = x;
+            ewma_ref = minimo_ref = maximo_ref = x;
+        } else {
+            ewma_ref += ALFA_EWMA * (x - ewma_ref);
+            minimo_ref = x < minimo_ref ? x : minimo_ref;
+            maximo_ref = x > maximo_ref ? x : maximo_ref;
+        }
+        sumar_kahan(&suma, x - base);
+        sumar_kahan(&suma_cuadrados, (x - base) * (x - base));
+        suma_ventana_ref += x - ventana_ref[i % VENTANA_MEDIA];
+        ventana_ref[i % VENTANA_MEDIA] = x;
+        
+        if (i % PRUEBA_BLOQUE == PRUEBA_BLOQUE - 1) {
+            estadistica_agregar_bloque(&por_bloque, bloque, PRUEBA_BLOQUE);
+            
+            // EWMA y media móvil de los dos caminos contra la referencia
+            uint32_t en_ventana = i + 1 < VENTANA_MEDIA ? (uint32_t) (i + 1) : VENTANA_MEDIA;
+            double movil_ref = suma_ventana_ref / en_ventana;
+            const estadistica_flujo_t *caminos[] = { &por_dato, &por_bloque };
+            for (int c = 0; c < 2; c++) {
+                resumen_sensor_t r;
+                estadistica_resumir(caminos[c], &r);
+                double e = diferencia(r.ewma, ewma_ref);
+                error_ewma = e > error_ewma ? e : error_ewma;
+                e = diferencia(r.media_movil, movil_ref);
+                error_ventana = e > error_ventana ? e : error_ventana;
+            }
+        }
+    }
+    int64_t duracion_us = esp_timer_get_time() - inicio;
+    
+    double n = (double) PRUEBA_ESTADISTICAS_DATOS;
+    double media_ref = base + suma.suma / n;
+    double desviacion_ref = sqrt((suma_cuadrados.suma - suma.suma * suma.suma / n) / (n - 1));
+    bool correcto = error_ewma < TOLERANCIA_FLOAT && error_ventana < TOLERANCIA_FLOAT;
+    
+    ESP_LOGI(TAG, "Referencia: media %.9f, desviación %.9f, mín %.2f, máx %.2f",
+             media_ref, desviacion_ref, minimo_ref, maximo_ref);
+    const estadistica_flujo_t *caminos[] = { &por_dato, &por_bloque };
+    const char *nombres[] = { "dato a dato", "por bloques" };
+    for (int c = 0; c < 2; c++) {
+        const estadistica_flujo_t *e = caminos[c];
+        double desviacion = sqrt(e->m2 / (e->n - 1));
+        double error_media = diferencia(e->media, media_ref);
+        double error_desviacion = diferencia(desviacion, desviacion_ref);
+        bool ok = e->n == PRUEBA_ESTADISTICAS_DATOS && error_media < TOLERANCIA_MEDIA &&
+                  error_desviacion < TOLERANCIA_MEDIA && e->minimo == minimo_ref && e->maximo == maximo_ref;
+        correcto &= ok;
+        ESP_LOGI(TAG, "%-11s: n %" PRIu64 ", error de media %.3g, de desviación %.3g, mín/máx %s",
+                 nombres[c], e->n, error_media, error_desviacion,
+                 e->minimo == minimo_ref && e->maximo == maximo_ref ? "exactos" : "DISTINTOS");
+    }
+    ESP_LOGI(TAG, "Error máximo de EWMA %.3g y de media móvil %.3g (tolerancia %.3g)",
+             error_ewma, error_ventana, TOLERANCIA_FLOAT);
+    ESP_LOGI(TAG, "Suma float de antes: media %.6f, error %.3g", suma_float / n,
+             diferencia(suma_float / n, media_ref));
+    ESP_LOGI(TAG, "%" PRId64 " ms (%" PRId64 " ns por dato, los dos caminos y la referencia)", duracion_us / 1000,
+             duracion_us * 1000 / (int64_t) PRUEBA_ESTADISTICAS_DATOS);
+    
+    if (correcto) {
+        ESP_LOGI(TAG, "Prueba de estadísticas OK");
+    } else {
+        ESP_LOGE(TAG, "Prueba de estadísticas FALLIDA: error fuera de tolerancia");
+    }
+    return correcto;
+}
+#endif
+
+#if MODO_BENCHMARK_TRABAJADORES
+// ============================================================================
+// BENCHMARK DE TRABAJADORES
+// ============================================================================
+// El pool procesa BENCH_TRABAJADORES_DATOS datos con 1, 2, ... NUM_TRABAJADORES
+// trabajadores. La tarea principal hace de DataProcessor: reparte bloques de
+// LOTE_MUESTRAS datos de los tres sensores por turno, de un generador fijo, así
+// todas las corridas agregan lo mismo. Los trabajadores (prioridad 3, fijos a
+// los núcleos por turno) no tienen límite de concurrencia. Al terminar de
+// repartir se manda un NULL por trabajador y la corrida termina cuando todos
+// avisaron: para entonces cada trabajo está agregado.
+// Por corrida se imprimen los datos/s, la aceleración respecto de un trabajador
+// y si los resúmenes de los sensores son idénticos a los de un trabajador: con
+// la agregación en orden tienen que serlo bit a bit.
+
+#define BENCH_TRABAJADORES_DATOS  30000
+
+// Dato fijo (xorshift32) en el rango del sensor
+static void generar_dato_bench(uint32_t *estado, uint8_t id, sensor_data_t *dato) {
+    uint32_t x = *estado;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *estado = x;
+    float valor = id == 1 ? 20.0 + (x % 2000) / 100.0 :
+                  id == 2 ? 30.0 + (x % 6000) / 100.0 :
+                            950.0 + (x % 10000) / 100.0;
+    *dato = (sensor_data_t) { .sensor_id = id, .value = valor, .timestamp = 0 };
+}
+
+static void ejecutar_benchmark_trabajadores(void) {
+    static sensor_data_t bloque[LOTE_MUESTRAS];
+    resumen_sensor_t referencia[NUM_SENSORES];
+    double datos_s_uno = 0;
+    
+    ESP_LOGI(TAG, "=== Benchmark de trabajadores: %d datos, %d iteraciones por dato, %d núcleos ===",
+             BENCH_TRABAJADORES_DATOS, PROCESO_ITERACIONES, portNUM_PROCESSORS);
+    if (!crear_pool_trabajos(NULL, false)) {
+        ESP_LOGE(TAG, "Error creando el pool de trabajos");
+        return;
+    }
+    vTaskPrioritySet(NULL, 5);
+    aviso_fin_trabajadores = xTaskGetCurrentTaskHandle();
+    
+    for (int n = 1; n <= NUM_TRABAJADORES; n++) {
+        reiniciar_pool_trabajos();
+        for (int w = 0; w < n; w++) {
+            xTaskCreatePinnedToCore(trabajador_task, "BenchTrabajador", PILA_TRABAJADOR, NULL, 3, NULL,
+                                    w % portNUM_PROCESSORS);
+        }
+        
+        uint32_t estado = 12345;
+        int64_t inicio = esp_timer_get_time();
+        for (uint32_t enviados = 0, k = 0; enviados < BENCH_TRABAJADORES_DATOS; k++) {
+            uint8_t id = k % NUM_SENSORES + 1;
+            uint32_t cuenta = BENCH_TRABAJADORES_DATOS - enviados;
+            cuenta = cuenta < LOTE_MUESTRAS ? cuenta : LOTE_MUESTRAS;
+            for (uint32_t i = 0; i < cuenta; i++) {
+                generar_dato_bench(&estado, id, &bloque[i]);
+            }
+            repartir_muestras(bloque, cuenta);
+            enviados += cuenta;
+        }
+        trabajo_t *fin = NULL;
+        for (int w = 0; w < n; w++) {
+            xQueueSend(trabajos_pendientes, &fin, portMAX_DELAY);
+        }
+        for (int w = 0; w < n; w++) {
+            ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        }
+        int64_t duracion_us = esp_timer_get_time() - inicio;
+        
+        resumen_sensor_t resumenes[NUM_SENSORES];
+        bool completo = true;
+        for (int s = 0; s < NUM_SENSORES; s++) {
+            estadistica_resumir(&agregados_sensores[s].estadistica, &resumenes[s]);
+            completo &= agregados_sensores[s].siguiente == agregados_sensores[s].asignados;
+        }
+        if (n == 1) {
+            memcpy(referencia, resumenes, sizeof(referencia));
+        }
+        double datos_s = BENCH_TRABAJADORES_DATOS * 1e6 / duracion_us;
+        if (n == 1) {
+            datos_s_uno = datos_s;
+        }
+        ESP_LOGI(TAG, "%d trabajadores: %.0f datos/s, aceleración %.2f, %s, resúmenes %s",
+                 n, datos_s, datos_s / datos_s_uno, completo ? "todo agregado" : "FALTAN TRABAJOS",
+                 memcmp(referencia, resumenes, sizeof(referencia)) == 0 ? "idénticos" : "DISTINTOS");
+        
+        // El idle libera los trabajadores que terminaron
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    
+    aviso_fin_trabajadores = NULL;
+    vTaskPrioritySet(NULL, 1);
+}
+#endif
+
 // ============================================================================
 // FUNCIÓN PRINCIPAL DE LA APLICACIÓN
 // ============================================================================
 
 void app_main(void) {
+    arranque_app_main_us = (uint32_t) esp_timer_get_time();
     ESP_LOGI(TAG, "=== PRÁCTICA FREERTOS: SINCRONIZACIÓN AVANZADA ===");
     
+#if MODO_BENCHMARK_TRANSPORTE
+    // Solo el benchmark, sin las tareas de la práctica
+    ejecutar_benchmark_transporte();
+    return;
+#endif
+#if MODO_BENCHMARK_FORMATO
+    // Solo el benchmark de formato, sin las tareas de la práctica
+    ejecutar_benchmark_formato();
+    return;
+#endif
+#if MODO_BENCHMARK_TRABAJADORES
+    // Solo el benchmark del pool, sin las tareas de la práctica
+    ejecutar_benchmark_trabajadores();
+    return;
+#endif
+#if MODO_PRUEBA_ANILLOS
+    // Solo la prueba de los anillos; en Linux el código de salida es el resultado
+#if CONFIG_IDF_TARGET_LINUX
+    exit(ejecutar_prueba_anillos() ? 0 : 1);
+#else
+    ejecutar_prueba_anillos();
+    return;
+#endif
+#endif
+#if MODO_PRUEBA_ESTADISTICAS
+    // Solo la prueba de las estadísticas; en Linux el código de salida es el resultado
+#if CONFIG_IDF_TARGET_LINUX
+    exit(ejecutar_prueba_estadisticas() ? 0 : 1);
+#else
+    ejecutar_prueba_estadisticas();
+    return;
+#endif
+#endif
+    
+    size_t heap_antes = esp_get_free_heap_size();
+    
     // ========================================================================
     // CREACIÓN DE OBJETOS DE SINCRONIZACIÓN
     // ========================================================================
     
+#if MODO_ESTATICO
+    // Todos los objetos en memoria estática: ninguno puede fallar
+    sensor_queue = xQueueCreateStatic(QUEUE_SIZE, sizeof(sensor_data_t), almacen_cola_sensores,
+                                      &cola_sensores_estatica);
+    binary_semaphore = xSemaphoreCreateBinaryStatic(&semaforo_binario_estatico);
+    counting_semaphore = xSemaphoreCreateCountingStatic(MAX_PROCESANDO, MAX_PROCESANDO,
+                                                        &semaforo_contador_estatico);
+    system_events = xEventGroupCreateStatic(&eventos_sistema_estatico);
+    stats_mutex = xSemaphoreCreateMutexStatic(&mutex_estadisticas_estatico);
+    ESP_LOGI(TAG, "Objetos de sincronización creados en memoria estática");
+#else
     // Crear cola para comunicación productor-consumidor
     sensor_queue = xQueueCreate(QUEUE_SIZE, sizeof(sensor_data_t));
     if (sensor_queue == NULL) {
@@ -354,8 +2378,8 @@ void app_main(void) {
     }
     ESP_LOGI(TAG, "Semáforo binario creado exitosamente");
     
-    // Crear semáforo contador para limitar procesamiento concurrente (máximo 2)
-    counting_semaphore = xSemaphoreCreateCounting(2, 2);
+    // Crear semáforo contador para limitar procesamiento concurrente (máximo MAX_PROCESANDO trabajadores)
+    counting_semaphore = xSemaphoreCreateCounting(MAX_PROCESANDO, MAX_PROCESANDO);
     if (counting_semaphore == NULL) {
         ESP_LOGE(TAG, "Error creando semáforo contador");
         return;
@@ -377,49 +2401,147 @@ void app_main(void) {
         return;
     }
     ESP_LOGI(TAG, "Mutex creado exitosamente");
+#endif
+    
+    TRAZA_NOMBRAR(sensor_queue, "sensor_queue");
+    TRAZA_NOMBRAR(binary_semaphore, "binary_semaphore");
+    TRAZA_NOMBRAR(counting_semaphore, "counting_semaphore");
+    TRAZA_NOMBRAR(stats_mutex, "stats_mutex");
+    
+    // Pool de trabajos: los trabajadores respetan el límite del semáforo contador, si
+    // es menor que su cantidad (si no, tomarlo y devolverlo en cada trabajo no limita nada)
+    if (!crear_pool_trabajos(MAX_PROCESANDO < NUM_TRABAJADORES ? counting_semaphore : NULL, true)) {
+        ESP_LOGE(TAG, "Error creando el pool de trabajos");
+        return;
+    }
+    ESP_LOGI(TAG, "Pool de %d trabajos para %d trabajadores creado (%d procesando a la vez)",
+             NUM_TRABAJOS, NUM_TRABAJADORES, MAX_PROCESANDO);
+    
+#if MODO_TRANSPORTE == TRANSPORTE_LOTES
+    // Pool de bloques del transporte por lotes
+    if (!crear_pool_bloques()) {
+        ESP_LOGE(TAG, "Error creando el pool de bloques");
+        return;
+    }
+#if LOTE_EMPACADO
+    ESP_LOGI(TAG, "Pools de %d bloques de 16 bits y %d de 32 bits, de %d datos, creados (%u B)",
+             NUM_BLOQUES16, NUM_BLOQUES32, LOTE_MUESTRAS,
+             (unsigned) (sizeof(bloques_muestras16) + sizeof(bloques_muestras32)));
+#else
+    ESP_LOGI(TAG, "Pool de %d bloques de %d datos creado", NUM_BLOQUES, LOTE_MUESTRAS);
+#endif
+#endif
     
     // ========================================================================
     // CREACIÓN DE TAREAS
     // ========================================================================
     
+#if MODO_ESTATICO
+#if MODO_REGISTRO_DIFERIDO
+    // Drenado del registro diferido con prioridad mínima
+    tarea_drenado = xTaskCreateStatic(tarea_drenado_registro, "DrenadoRegistro", PILA_DRENADO, NULL, 1,
+                                      pila_drenado, &tcb_drenado);
+#endif
+    // Tarea de inicialización del sistema
+    crear_tarea_estatica(system_init_task, "SystemInit", 5, pila_system_init, PILA_SYSTEM_INIT, TAREA_INIT);
+#else
+#if MODO_REGISTRO_DIFERIDO
+    // Drenado del registro diferido con prioridad mínima
+    if (xTaskCreate(tarea_drenado_registro, "DrenadoRegistro", PILA_DRENADO, NULL, 1, &tarea_drenado) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de drenado del registro");
+        return;
+    }
+#endif
+    
     // Crear tarea de inicialización del sistema
-    if (xTaskCreate(system_init_task, "SystemInit", STACK_SIZE, NULL, 5, NULL) != pdPASS) {
+    if (xTaskCreate(system_init_task, "SystemInit", PILA_SYSTEM_INIT, NULL, 5, HANDLE_TAREA(TAREA_INIT)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea de inicialización");
         return;
     }
+#endif
     
     // Esperar a que el sistema esté inicializado
     ESP_LOGI(TAG, "Esperando inicialización del sistema...");
     xSemaphoreTake(binary_semaphore, portMAX_DELAY);
     
+    // Primera liberación común de los tres sensores
+    origen_sensores = xTaskGetTickCount();
+    
+#if MODO_ESTATICO
+    // Productores, consumidor y display con su memoria estática
+    crear_tarea_estatica(temperature_sensor_task, "TempSensor", 3, pila_temp_sensor, PILA_TEMP_SENSOR,
+                         TAREA_TEMPERATURA);
+    crear_tarea_estatica(humidity_sensor_task, "HumiditySensor", 3, pila_humidity_sensor, PILA_HUMIDITY_SENSOR,
+                         TAREA_HUMEDAD);
+    crear_tarea_estatica(pressure_sensor_task, "PressureSensor", 3, pila_pressure_sensor, PILA_PRESSURE_SENSOR,
+                         TAREA_PRESION);
+    crear_tarea_estatica(data_processor_task, "DataProcessor", 4, pila_data_processor, PILA_DATA_PROCESSOR,
+                         TAREA_PROCESADOR);
+    crear_tarea_estatica(display_task, "Display", 2, pila_display, PILA_DISPLAY, TAREA_DISPLAY);
+    
+    // Trabajadores repartidos entre los núcleos, debajo de los sensores
+    for (int w = 0; w < NUM_TRABAJADORES; w++) {
+        char nombre[configMAX_TASK_NAME_LEN];
+        snprintf(nombre, sizeof(nombre), "Trabajador%d", w);
+        tareas_trabajadores[w] = xTaskCreateStaticPinnedToCore(trabajador_task, nombre, PILA_TRABAJADOR, NULL, 2,
+                                                               pilas_trabajadores[w], &tcbs_trabajadores[w],
+                                                               w % portNUM_PROCESSORS);
+    }
+#else
     // Crear tareas productoras (sensores)
-    if (xTaskCreate(temperature_sensor_task, "TempSensor", STACK_SIZE, NULL, 3, NULL) != pdPASS) {
+    if (xTaskCreate(temperature_sensor_task, "TempSensor", PILA_TEMP_SENSOR,
+                    NULL, 3, HANDLE_TAREA(TAREA_TEMPERATURA)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea sensor temperatura");
         return;
     }
     
-    if (xTaskCreate(humidity_sensor_task, "HumiditySensor", STACK_SIZE, NULL, 3, NULL) != pdPASS) {
+    if (xTaskCreate(humidity_sensor_task, "HumiditySensor", PILA_HUMIDITY_SENSOR,
+                    NULL, 3, HANDLE_TAREA(TAREA_HUMEDAD)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea sensor humedad");
         return;
     }
     
-    if (xTaskCreate(pressure_sensor_task, "PressureSensor", STACK_SIZE, NULL, 3, NULL) != pdPASS) {
+    if (xTaskCreate(pressure_sensor_task, "PressureSensor", PILA_PRESSURE_SENSOR,
+                    NULL, 3, HANDLE_TAREA(TAREA_PRESION)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea sensor presión");
         return;
     }
     
     // Crear tarea consumidora (procesador)
-    if (xTaskCreate(data_processor_task, "DataProcessor", STACK_SIZE, NULL, 4, NULL) != pdPASS) {
+    if (xTaskCreate(data_processor_task, "DataProcessor", PILA_DATA_PROCESSOR,
+                    NULL, 4, HANDLE_TAREA(TAREA_PROCESADOR)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea procesador");
         return;
     }
     
     // Crear tarea de display
-    if (xTaskCreate(display_task, "Display", STACK_SIZE, NULL, 2, NULL) != pdPASS) {
+    if (xTaskCreate(display_task, "Display", PILA_DISPLAY, NULL, 2, HANDLE_TAREA(TAREA_DISPLAY)) != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea display");
         return;
     }
     
+    // Crear trabajadores repartidos entre los núcleos, debajo de los sensores
+    for (int w = 0; w < NUM_TRABAJADORES; w++) {
+        char nombre[configMAX_TASK_NAME_LEN];
+        snprintf(nombre, sizeof(nombre), "Trabajador%d", w);
+        if (xTaskCreatePinnedToCore(trabajador_task, nombre, PILA_TRABAJADOR, NULL, 2,
+                                    &tareas_trabajadores[w], w % portNUM_PROCESSORS) != pdPASS) {
+            ESP_LOGE(TAG, "Error creando trabajador %d", w);
+            return;
+        }
+    }
+#endif
+    
+    ESP_LOGI(TAG, "Arranque (memoria %s): objetos creados a los %" PRIu32 " us, heap usado %ld B",
+             MODO_ESTATICO ? "estática" : "dinámica", (uint32_t) esp_timer_get_time(),
+             (long) heap_antes - (long) esp_get_free_heap_size());
+#if MODO_PERFIL_PILAS
+    xTaskCreate(tarea_perfil_pilas, "PerfilPilas", PILA_PERFIL, NULL, 1, NULL);
+#endif
+#if MODO_TRAZA
+    // La traza corre desde el arranque; esta tarea la detiene y la vuelca
+    xTaskCreate(tarea_traza, "Traza", PILA_TRAZA, (void *) FIN_TRAZA, 1, NULL);
+#endif
     ESP_LOGI(TAG, "Todas las tareas creadas exitosamente");
     ESP_LOGI(TAG, "Sistema en funcionamiento...");
 }
\ No newline at end of file
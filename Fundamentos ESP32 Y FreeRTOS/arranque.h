@@ -0,0 +1,37 @@
+// Tiempo de arranque para Leds e Interrupciones.c, Multitarea.c y Sincro Avanzada.c
+//
+// Va junto a los programas en main/, como traza_freertos.h. Cada programa lo
+// incluye una sola vez, después de definir TAG y MODO_ESTATICO; las funciones
+// son static, así que no hace falta compilarlo aparte. app_main anota la
+// entrada en arranque_app_main_us y cada tarea de la práctica llama a
+// marcar_primera_tarea al empezar.
+#ifndef ARRANQUE_H
+#define ARRANQUE_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Tiempo de arranque, en microsegundos de esp_timer (cuenta desde el inicio del chip)
+static uint32_t arranque_app_main_us;       // Entrada a app_main
+static uint32_t arranque_primera_tarea_us;  // Primera tarea de la práctica corriendo
+
+// Marca la primera tarea que corre y reporta el tiempo de arranque; la llama
+// cada tarea al empezar y solo la primera registra el instante
+static void marcar_primera_tarea(void)
+{
+    uint32_t ahora = (uint32_t) esp_timer_get_time();
+    uint32_t esperado = 0;
+    if (__atomic_compare_exchange_n(&arranque_primera_tarea_us, &esperado, ahora, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        ESP_LOGI(TAG, "Arranque (memoria %s): %s corre a los %" PRIu32 " us, %" PRIu32 " us después de entrar a app_main",
+                 MODO_ESTATICO ? "estática" : "dinámica", pcTaskGetName(NULL), ahora,
+                 ahora - arranque_app_main_us);
+    }
+}
+
+#endif // ARRANQUE_H
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Convierte el volcado de MODO_TRAZA a JSON de Chrome/Perfetto.
+
+Uso:
+    python3 convertir_traza.py volcado.txt > traza.json
+    python3 convertir_traza.py --secuencia volcado.txt > traza.txt
+
+El volcado puede ser el archivo que escribe el puerto Linux o la salida de la
+consola completa: solo se leen las líneas traza,... nombre,... y evento,...
+El JSON se abre en https://ui.perfetto.dev o en chrome://tracing: cada núcleo
+es una fila, cada tarea un tramo mientras corre, las ISRs tramos anidados y las
+operaciones de colas y semáforos eventos instantáneos.
+--secuencia escribe el orden de los eventos sin tiempos ni direcciones, una
+línea por evento, para comparar dos corridas con diff.
+"""
+
+import argparse
+import json
+import sys
+
+TIPOS_COLA = {
+    "cola_envia", "cola_recibe", "semaforo_da", "semaforo_toma",
+    "bloqueo_envia", "bloqueo_recibe",
+}
+
+
+def leer_volcado(archivo):
+    """Devuelve (cabecera, nombres, eventos) del volcado."""
+    cabecera = {"reloj_hz": 1000000, "bits": 64}
+    nombres = {}
+    eventos = []
+    for linea in archivo:
+        linea = linea.strip()
+        campos = linea.split(",")
+        if campos[0] == "traza":
+            for campo in campos[1:]:
+                clave, valor = campo.split("=")
+                cabecera[clave] = int(valor)
+        elif campos[0] == "nombre" and len(campos) >= 4:
+            nombres[int(campos[1])] = (campos[2], ",".join(campos[3:]))
+        elif campos[0] == "evento" and len(campos) == 6:
+            eventos.append({
+                "marca": int(campos[1]),
+                "nucleo": int(campos[2]),
+                "tipo": campos[3],
+                "objeto": campos[4],
+                "dato": int(campos[5]),
+            })
+    return cabecera, nombres, eventos
+
+
+def extender_marcas(eventos, bits):
+    """Con marcas de 32 bits suma las vueltas del contador (vienen en orden de registro)."""
+    if bits >= 64:
+        return
+    vuelta = 1 << bits
+    extra = 0
+    anterior = None
+    for e in eventos:
+        if anterior is not None and e["marca"] + extra < anterior - vuelta // 2:
+            extra += vuelta
+        e["marca"] += extra
+        anterior = e["marca"]
+
+
+def resolver_nombres(eventos, nombres):
+    """Pone nombre a cada objeto: el último guardado, o el de su creación si está en la traza."""
+    por_objeto = {}
+    for objeto, nombre in nombres.values():
+        por_objeto[objeto] = nombre
+    for e in eventos:
+        if e["tipo"] == "crea" and e["dato"] in nombres:
+            por_objeto[e["objeto"]] = nombres[e["dato"]][1]
+        e["nombre"] = por_objeto.get(e["objeto"], e["objeto"])
+
+
+def a_chrome(cabecera, eventos):
+    escala = 1e6 / cabecera["reloj_hz"]
+    inicio = eventos[0]["marca"] if eventos else 0
+    salida = []
+    corriendo = {}              # Núcleo -> (tarea, inicio en us)
+    nucleos = set()
+
+    def us(e):
+        return (e["marca"] - inicio) * escala
+
+    for e in eventos:
+        n = e["nucleo"]
+        nucleos.add(n)
+        t = us(e)
+        if e["tipo"] == "entra":
+            corriendo[n] = (e["nombre"], t)
+        elif e["tipo"] == "sale":
+            tarea, desde = corriendo.pop(n, (e["nombre"], 0.0))
+            salida.append({"name": tarea, "ph": "X", "pid": 1, "tid": n,
+                           "ts": desde, "dur": t - desde})
+        elif e["tipo"] == "isr_entra":
+            salida.append({"name": "ISR %d" % e["dato"], "ph": "B", "pid": 1, "tid": n, "ts": t})
+        elif e["tipo"] == "isr_sale":
+            salida.append({"ph": "E", "pid": 1, "tid": n, "ts": t})
+        elif e["tipo"] in TIPOS_COLA:
+            tarea = corriendo.get(n, ("?", 0.0))[0]
+            salida.append({"name": "%s %s" % (e["tipo"], e["nombre"]), "ph": "i", "s": "t",
+                           "pid": 1, "tid": n, "ts": t, "args": {"tarea": tarea}})
+        elif e["tipo"] == "crea":
+            salida.append({"name": "crea %s" % e["nombre"], "ph": "i", "s": "p",
+                           "pid": 1, "tid": n, "ts": t})
+
+    # Lo que seguía corriendo al detener la traza
+    fin = us(eventos[-1]) if eventos else 0.0
+    for n, (tarea, desde) in corriendo.items():
+        salida.append({"name": tarea, "ph": "X", "pid": 1, "tid": n, "ts": desde, "dur": fin - desde})
+
+    for n in sorted(nucleos):
+        salida.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": n,
+                       "args": {"name": "Núcleo %d" % n}})
+    return {"traceEvents": salida, "displayTimeUnit": "ns"}
+
+
+def a_secuencia(eventos):
+    lineas = []
+    for e in eventos:
+        if e["tipo"] == "isr_entra":
+            detalle = " %d" % e["dato"]
+        elif e["tipo"] == "isr_sale":
+            detalle = ""
+        else:
+            detalle = " " + e["nombre"]
+        lineas.append("%d %s%s" % (e["nucleo"], e["tipo"], detalle))
+    return "\n".join(lineas) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("volcado", help="archivo con el volcado (- para la entrada estándar)")
+    parser.add_argument("--secuencia", action="store_true",
+                        help="orden de los eventos sin tiempos, para comparar corridas")
+    args = parser.parse_args()
+
+    if args.volcado == "-":
+        cabecera, nombres, eventos = leer_volcado(sys.stdin)
+    else:
+        with open(args.volcado, encoding="utf-8", errors="replace") as archivo:
+            cabecera, nombres, eventos = leer_volcado(archivo)
+    if not eventos:
+        sys.exit("No hay eventos de traza en %s" % args.volcado)
+
+    extender_marcas(eventos, cabecera["bits"])
+    # Los núcleos reservan su lugar en el anillo y después toman la marca: se ordena por tiempo
+    eventos.sort(key=lambda e: e["marca"])
+    resolver_nombres(eventos, nombres)
+
+    if args.secuencia:
+        sys.stdout.write(a_secuencia(eventos))
+    else:
+        json.dump(a_chrome(cabecera, eventos), sys.stdout, ensure_ascii=False)
+        sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+// Lazos periódicos y precisión de los periodos para Multitarea.c y Sincro Avanzada.c
+//
+// Va junto a los programas en main/, como traza_freertos.h. Cada programa lo
+// incluye una sola vez, después de definir TAG (mostrar_precision escribe con
+// él); las funciones son static, así que no hace falta compilarlo aparte.
+// Quien no junta periodos (los lazos con xTaskDelayUntil) pasa saltos = 0 a
+// registrar_liberacion; los trabajos de temporizador de Multitarea.c pasan los
+// avisos que se juntaron. Todas las liberaciones cuentan en despertares.
+#ifndef LAZO_PERIODICO_H
+#define LAZO_PERIODICO_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Precisión de los periodos: cada liberación (el instante en que un lazo o un
+// trabajo periódico empieza una vuelta) se compara con su instante ideal,
+// primera + k * periodo, para ver cuánto se atrasa o se adelanta
+typedef struct {
+    uint32_t periodo_us;
+    uint32_t liberaciones;
+    int64_t primera_us;                 // Primera liberación (origen de los instantes ideales)
+    int64_t ultima_us;
+    uint32_t omitidas;                  // Periodos que se juntaron con otro sin liberación propia
+    uint32_t excedidas;                 // Vueltas que se pasaron del periodo
+    int32_t desvio_us;                  // Real - ideal de la última liberación
+    int32_t desvio_max_us;              // Mayor |real - ideal|
+    int64_t suma_desvio_us;             // Suma de |real - ideal|, para el promedio
+} precision_periodo_t;
+
+// Solo el dueño escribe: llena la copia que no está publicada y después la
+// publica, así cualquier tarea la lee sin bloqueos y sin esperar al dueño
+// (un doble búfer: quien lee repite si se publicó otra mientras copiaba)
+typedef struct {
+    precision_periodo_t copias[2];
+    uint32_t publicada;
+} medicion_periodo_t;
+
+static void iniciar_medicion(medicion_periodo_t *m, uint32_t periodo_ms)
+{
+    *m = (medicion_periodo_t) { 0 };
+    m->copias[0].periodo_us = periodo_ms * 1000;
+    m->copias[1].periodo_us = periodo_ms * 1000;
+}
+
+// Despertares: ticks distintos en los que se liberó algún lazo o trabajo. Con
+// tickless idle el chip solo despierta en esos ticks; con el tick normal la
+// interrupción lo despierta en todos. Dos liberaciones en el mismo tick, aunque
+// sean de núcleos distintos, cuentan como un solo despertar
+static volatile TickType_t tick_ultimo_despertar = portMAX_DELAY;
+static volatile uint32_t despertares;
+
+static void registrar_despertar(void)
+{
+    TickType_t ahora = xTaskGetTickCount();
+    if (__atomic_exchange_n(&tick_ultimo_despertar, ahora, __ATOMIC_RELAXED) != ahora) {
+        __atomic_fetch_add(&despertares, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Anota una liberación y su desvío respecto del instante ideal
+ * 
+ * @param m: Medición del lazo o trabajo (solo la escribe su dueño)
+ * @param saltos: Periodos que se juntaron con este sin liberarse aparte
+ * @param excedida: La vuelta anterior se pasó del periodo
+ */
+static void registrar_liberacion(medicion_periodo_t *m, uint32_t saltos, bool excedida)
+{
+    int64_t ahora = esp_timer_get_time();
+    uint32_t n = m->publicada;
+    precision_periodo_t *p = &m->copias[(n + 1) % 2];
+    
+    registrar_despertar();
+    
+    *p = m->copias[n % 2];
+    if (p->liberaciones == 0) {
+        p->primera_us = ahora;
+    } else {
+        p->omitidas += saltos;
+        p->excedidas += excedida;
+        uint32_t periodos = p->liberaciones + p->omitidas;
+        int64_t ideal = p->primera_us + (int64_t) periodos * p->periodo_us;
+        int32_t desvio = (int32_t) (ahora - ideal);
+        int32_t absoluto = desvio < 0 ? -desvio : desvio;
+        p->desvio_us = desvio;
+        p->suma_desvio_us += absoluto;
+        if (absoluto > p->desvio_max_us) {
+            p->desvio_max_us = absoluto;
+        }
+    }
+    p->ultima_us = ahora;
+    p->liberaciones++;
+    __atomic_store_n(&m->publicada, n + 1, __ATOMIC_RELEASE);
+}
+
+// Copia la precisión publicada; si se publicó otra mientras copiaba, repite
+static void leer_medicion(const medicion_periodo_t *m, precision_periodo_t *copia)
+{
+    uint32_t n;
+    do {
+        n = __atomic_load_n(&m->publicada, __ATOMIC_ACQUIRE);
+        memcpy(copia, &m->copias[n % 2], sizeof(*copia));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&m->publicada, __ATOMIC_RELAXED) != n);
+}
+
+// Muestra periodo medio, desvío medio, máximo y actual, y periodos omitidos y excedidos
+static void mostrar_precision(const char *nombre, const medicion_periodo_t *m)
+{
+    precision_periodo_t p;
+    leer_medicion(m, &p);
+    
+    uint32_t periodos = p.liberaciones + p.omitidas - 1;
+    ESP_LOGI(TAG, "%-12s %5" PRIu32 " ms: %" PRIu32 " liberaciones, periodo medio %" PRId64 " us, "
+             "desvío medio %" PRId64 " máx %" PRId32 " actual %" PRId32 " us, omitidas %" PRIu32
+             ", excedidas %" PRIu32,
+             nombre, p.periodo_us / 1000, p.liberaciones,
+             periodos > 0 ? (p.ultima_us - p.primera_us) / periodos : 0,
+             p.liberaciones > 1 ? p.suma_desvio_us / (p.liberaciones - 1) : 0,
+             p.desvio_max_us, p.desvio_us, p.omitidas, p.excedidas);
+}
+
+// Lazo periódico sin deriva: xTaskDelayUntil espera hasta la liberación anterior
+// más un periodo, así lo que tarde la vuelta (trabajo y logs) no se suma al
+// periodo. Si una vuelta se pasa, la siguiente empieza enseguida y se cuenta
+// como excedida; la rejilla de liberaciones no se corre
+typedef struct {
+    TickType_t despertar;               // Liberación actual, referencia de xTaskDelayUntil
+    TickType_t periodo;
+    medicion_periodo_t medicion;
+} lazo_periodico_t;
+
+/**
+ * Prepara un lazo periódico
+ * 
+ * @param l: Lazo (su medición se puede leer desde otras tareas)
+ * @param periodo_ms: Periodo
+ * @param origen: Tick de la primera liberación (xTaskGetTickCount() para empezar ya)
+ */
+static void iniciar_lazo(lazo_periodico_t *l, uint32_t periodo_ms, TickType_t origen)
+{
+    l->despertar = origen;
+    l->periodo = pdMS_TO_TICKS(periodo_ms);
+    iniciar_medicion(&l->medicion, periodo_ms);
+}
+
+// Espera la siguiente liberación del lazo y la anota
+static void esperar_periodo(lazo_periodico_t *l)
+{
+    bool excedida = xTaskDelayUntil(&l->despertar, l->periodo) == pdFALSE;
+    registrar_liberacion(&l->medicion, 0, excedida);
+}
+
+#endif // LAZO_PERIODICO_H
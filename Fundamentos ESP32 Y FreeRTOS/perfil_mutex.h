@@ -0,0 +1,275 @@
+// Perfil de mutex (MODO_PERFIL_MUTEX) para Multitarea.c y Sincro Avanzada.c
+//
+// Va junto a los programas en main/, como traza_freertos.h. Cada programa lo
+// incluye una sola vez, después de definir TAG y MODO_PERFIL_MUTEX; las
+// funciones son static, así que no hace falta compilarlo aparte. El programa
+// declara un perfil_mutex_t por mutex que perfila, usa TOMAR_MUTEX y
+// SOLTAR_MUTEX en lugar de xSemaphoreTake y xSemaphoreGive, y decide cada
+// cuánto llama a mostrar_perfil_mutex y volcar_perfil_mutex.
+//
+// TOMAR_MUTEX y SOLTAR_MUTEX miden cada toma: cuánto esperó (0 si estaba libre),
+// cuánto se retuvo, los timeouts y, cuando alguien tuvo que esperar, qué tarea
+// tenía el mutex y si tenía menos prioridad que la que esperaba (inversión de
+// prioridad; la herencia de prioridad de FreeRTOS la acota pero no la evita).
+// Los contadores son atómicos: cualquier tarea los consulta con
+// mostrar_perfil_mutex y volcar_perfil_mutex los imprime como CSV
+#ifndef PERFIL_MUTEX_H
+#define PERFIL_MUTEX_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#if MODO_PERFIL_MUTEX
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define CUBETAS_MUTEX        18     // Cubeta 0: 0 us; cubeta i: de 2^(i-1) a 2^i - 1 us; la última junta el resto
+#define MAX_BLOQUEOS_MUTEX   8      // Pares dueño/esperando distintos que se recuerdan
+
+// Quién tenía el mutex cuando otra tarea tuvo que esperarlo
+typedef struct {
+    TaskHandle_t dueno;
+    TaskHandle_t esperando;
+    char nombre_dueno[configMAX_TASK_NAME_LEN];
+    char nombre_esperando[configMAX_TASK_NAME_LEN];
+    volatile bool listo;                // Nombres copiados, el par ya se puede leer
+    uint32_t bloqueos;
+    uint32_t inversiones;               // El dueño tenía menos prioridad que quien esperaba
+    uint32_t timeouts;                  // Esperas que terminaron sin el mutex
+    uint32_t espera_max_us;
+} bloqueo_mutex_t;
+
+typedef struct {
+    const char *nombre;
+    uint32_t tomas;                     // Tomas logradas
+    uint32_t contendidas;               // Tomas logradas después de esperar a otro dueño
+    uint32_t timeouts;
+    uint32_t inversiones;
+    uint32_t espera_max_us;
+    uint32_t retencion_max_us;
+    uint32_t hist_espera[CUBETAS_MUTEX];
+    uint32_t hist_retencion[CUBETAS_MUTEX];
+    int64_t tomado_us;                  // Solo lo escribe el dueño actual
+    uint32_t num_bloqueos;              // Pares reservados (puede pasar de MAX_BLOQUEOS_MUTEX)
+    bloqueo_mutex_t bloqueos[MAX_BLOQUEOS_MUTEX];
+} perfil_mutex_t;
+
+static inline uint32_t cubeta_mutex(uint32_t us)
+{
+    uint32_t i = us == 0 ? 0 : 32 - __builtin_clz(us);
+    return i < CUBETAS_MUTEX ? i : CUBETAS_MUTEX - 1;
+}
+
+static inline void maximo_atomico(uint32_t *maximo, uint32_t valor)
+{
+    uint32_t actual = __atomic_load_n(maximo, __ATOMIC_RELAXED);
+    while (valor > actual &&
+           !__atomic_compare_exchange_n(maximo, &actual, valor, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Busca el par dueño/esperando o le reserva una entrada nueva (NULL si no caben).
+// Dos tareas que reservan el mismo par a la vez pueden dejarlo repetido
+static bloqueo_mutex_t *buscar_bloqueo(perfil_mutex_t *p, TaskHandle_t dueno, TaskHandle_t esperando)
+{
+    uint32_t n = __atomic_load_n(&p->num_bloqueos, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < n && i < MAX_BLOQUEOS_MUTEX; i++) {
+        bloqueo_mutex_t *b = &p->bloqueos[i];
+        if (__atomic_load_n(&b->listo, __ATOMIC_ACQUIRE) &&
+            b->dueno == dueno && b->esperando == esperando) {
+            return b;
+        }
+    }
+    
+    uint32_t i = __atomic_fetch_add(&p->num_bloqueos, 1, __ATOMIC_RELAXED);
+    if (i >= MAX_BLOQUEOS_MUTEX) {
+        return NULL;
+    }
+    bloqueo_mutex_t *b = &p->bloqueos[i];
+    b->dueno = dueno;
+    b->esperando = esperando;
+    snprintf(b->nombre_dueno, sizeof(b->nombre_dueno), "%s", pcTaskGetName(dueno));
+    snprintf(b->nombre_esperando, sizeof(b->nombre_esperando), "%s", pcTaskGetName(esperando));
+    __atomic_store_n(&b->listo, true, __ATOMIC_RELEASE);
+    return b;
+}
+
+// Ya con el mutex: anota la toma y empieza a medir la retención
+static void anotar_toma(perfil_mutex_t *p, uint32_t espera_us)
+{
+    __atomic_fetch_add(&p->tomas, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&p->hist_espera[cubeta_mutex(espera_us)], 1, __ATOMIC_RELAXED);
+    maximo_atomico(&p->espera_max_us, espera_us);
+    p->tomado_us = esp_timer_get_time();
+}
+
+/**
+ * xSemaphoreTake con perfil
+ * Primero intenta sin esperar; solo si el mutex está ocupado anota el dueño y
+ * mide la espera, así el camino sin contención casi no cuesta
+ * 
+ * @param mutex: Mutex a tomar
+ * @param p: Perfil del mutex
+ * @param espera: Timeout en ticks
+ * @return pdTRUE si se tomó el mutex
+ */
+static BaseType_t tomar_mutex_perfilado(SemaphoreHandle_t mutex, perfil_mutex_t *p, TickType_t espera)
+{
+    if (xSemaphoreTake(mutex, 0) == pdTRUE) {
+        anotar_toma(p, 0);
+        return pdTRUE;
+    }
+    
+    // Antes de bloquearse: el dueño todavía no heredó la prioridad de esta tarea
+    TaskHandle_t yo = xTaskGetCurrentTaskHandle();
+    TaskHandle_t dueno = xSemaphoreGetMutexHolder(mutex);
+    bool inversion = dueno != NULL && uxTaskPriorityGet(dueno) < uxTaskPriorityGet(yo);
+    
+    int64_t inicio = esp_timer_get_time();
+    BaseType_t tomado = xSemaphoreTake(mutex, espera);
+    uint32_t espera_us = (uint32_t) (esp_timer_get_time() - inicio);
+    
+    if (tomado == pdTRUE) {
+        __atomic_fetch_add(&p->contendidas, 1, __ATOMIC_RELAXED);
+        anotar_toma(p, espera_us);
+    } else {
+        __atomic_fetch_add(&p->timeouts, 1, __ATOMIC_RELAXED);
+    }
+    if (inversion) {
+        __atomic_fetch_add(&p->inversiones, 1, __ATOMIC_RELAXED);
+    }
+    
+    // Si el dueño soltó el mutex antes de consultarlo no hay par que anotar
+    bloqueo_mutex_t *b = dueno != NULL ? buscar_bloqueo(p, dueno, yo) : NULL;
+    if (b != NULL) {
+        __atomic_fetch_add(&b->bloqueos, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->inversiones, inversion, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->timeouts, tomado != pdTRUE, __ATOMIC_RELAXED);
+        maximo_atomico(&b->espera_max_us, espera_us);
+    }
+    return tomado;
+}
+
+// xSemaphoreGive con perfil: anota cuánto se retuvo el mutex
+static BaseType_t soltar_mutex_perfilado(SemaphoreHandle_t mutex, perfil_mutex_t *p)
+{
+    uint32_t retencion_us = (uint32_t) (esp_timer_get_time() - p->tomado_us);
+    __atomic_fetch_add(&p->hist_retencion[cubeta_mutex(retencion_us)], 1, __ATOMIC_RELAXED);
+    maximo_atomico(&p->retencion_max_us, retencion_us);
+    return xSemaphoreGive(mutex);
+}
+
+// Límite superior (us) de la cubeta donde cae el percentil pedido
+static uint32_t percentil_mutex(const uint32_t *hist, uint32_t porciento)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < CUBETAS_MUTEX; i++) {
+        total += __atomic_load_n(&hist[i], __ATOMIC_RELAXED);
+    }
+    
+    uint32_t acumulado = 0;
+    for (int i = 0; i < CUBETAS_MUTEX; i++) {
+        acumulado += __atomic_load_n(&hist[i], __ATOMIC_RELAXED);
+        if (total > 0 && (uint64_t) acumulado * 100 >= (uint64_t) total * porciento) {
+            return i == 0 ? 0 : (1UL << i) - 1;
+        }
+    }
+    return 0;
+}
+
+// Resumen del perfil: se puede llamar desde cualquier tarea mientras el mutex se usa
+static void mostrar_perfil_mutex(const perfil_mutex_t *p)
+{
+    ESP_LOGI(TAG, "Mutex %s: %" PRIu32 " tomas, %" PRIu32 " con espera, %" PRIu32 " timeouts, "
+             "%" PRIu32 " inversiones de prioridad",
+             p->nombre, __atomic_load_n(&p->tomas, __ATOMIC_RELAXED),
+             __atomic_load_n(&p->contendidas, __ATOMIC_RELAXED),
+             __atomic_load_n(&p->timeouts, __ATOMIC_RELAXED),
+             __atomic_load_n(&p->inversiones, __ATOMIC_RELAXED));
+    ESP_LOGI(TAG, "  espera p50 <= %" PRIu32 " us, p99 <= %" PRIu32 " us, máx %" PRIu32 " us; "
+             "retención p50 <= %" PRIu32 " us, p99 <= %" PRIu32 " us, máx %" PRIu32 " us",
+             percentil_mutex(p->hist_espera, 50), percentil_mutex(p->hist_espera, 99),
+             __atomic_load_n(&p->espera_max_us, __ATOMIC_RELAXED),
+             percentil_mutex(p->hist_retencion, 50), percentil_mutex(p->hist_retencion, 99),
+             __atomic_load_n(&p->retencion_max_us, __ATOMIC_RELAXED));
+    
+    uint32_t n = __atomic_load_n(&p->num_bloqueos, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < n && i < MAX_BLOQUEOS_MUTEX; i++) {
+        const bloqueo_mutex_t *b = &p->bloqueos[i];
+        if (!__atomic_load_n(&b->listo, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %s hizo esperar a %s %" PRIu32 " veces (%" PRIu32 " con inversión, "
+                 "%" PRIu32 " timeouts, máx %" PRIu32 " us)",
+                 b->nombre_dueno, b->nombre_esperando, __atomic_load_n(&b->bloqueos, __ATOMIC_RELAXED),
+                 __atomic_load_n(&b->inversiones, __ATOMIC_RELAXED),
+                 __atomic_load_n(&b->timeouts, __ATOMIC_RELAXED),
+                 __atomic_load_n(&b->espera_max_us, __ATOMIC_RELAXED));
+    }
+    if (n > MAX_BLOQUEOS_MUTEX) {
+        ESP_LOGW(TAG, "  %" PRIu32 " pares dueño/esperando no cupieron", n - MAX_BLOQUEOS_MUTEX);
+    }
+}
+
+/**
+ * Vuelca el perfil como CSV entre dos líneas "-----" para analizarlo fuera
+ * El primer campo dice el tipo de línea:
+ * resumen,mutex,tomas,contendidas,timeouts,inversiones,espera_max_us,retencion_max_us
+ * espera|retencion,mutex,desde_us,hasta_us,cuenta (solo cubetas con cuenta)
+ * bloqueo,mutex,dueño,esperando,bloqueos,inversiones,timeouts,espera_max_us
+ */
+static void volcar_perfil_mutex(const perfil_mutex_t *p)
+{
+    printf("-----\n");
+    printf("resumen,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n", p->nombre,
+           __atomic_load_n(&p->tomas, __ATOMIC_RELAXED),
+           __atomic_load_n(&p->contendidas, __ATOMIC_RELAXED),
+           __atomic_load_n(&p->timeouts, __ATOMIC_RELAXED),
+           __atomic_load_n(&p->inversiones, __ATOMIC_RELAXED),
+           __atomic_load_n(&p->espera_max_us, __ATOMIC_RELAXED),
+           __atomic_load_n(&p->retencion_max_us, __ATOMIC_RELAXED));
+    for (int i = 0; i < CUBETAS_MUTEX; i++) {
+        uint32_t desde = i == 0 ? 0 : 1UL << (i - 1);
+        uint32_t hasta = i == 0 ? 0 : (i == CUBETAS_MUTEX - 1 ? UINT32_MAX : (1UL << i) - 1);
+        uint32_t espera = __atomic_load_n(&p->hist_espera[i], __ATOMIC_RELAXED);
+        uint32_t retencion = __atomic_load_n(&p->hist_retencion[i], __ATOMIC_RELAXED);
+        if (espera > 0) {
+            printf("espera,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n", p->nombre, desde, hasta, espera);
+        }
+        if (retencion > 0) {
+            printf("retencion,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n", p->nombre, desde, hasta, retencion);
+        }
+    }
+    uint32_t n = __atomic_load_n(&p->num_bloqueos, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < n && i < MAX_BLOQUEOS_MUTEX; i++) {
+        const bloqueo_mutex_t *b = &p->bloqueos[i];
+        if (__atomic_load_n(&b->listo, __ATOMIC_ACQUIRE)) {
+            printf("bloqueo,%s,%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+                   p->nombre, b->nombre_dueno, b->nombre_esperando,
+                   __atomic_load_n(&b->bloqueos, __ATOMIC_RELAXED),
+                   __atomic_load_n(&b->inversiones, __ATOMIC_RELAXED),
+                   __atomic_load_n(&b->timeouts, __ATOMIC_RELAXED),
+                   __atomic_load_n(&b->espera_max_us, __ATOMIC_RELAXED));
+        }
+    }
+    printf("-----\n");
+}
+#endif
+
+// Tomas y liberaciones de mutex: con MODO_PERFIL_MUTEX pasan por el perfil, si no
+// son las llamadas de FreeRTOS y el perfil ni se evalúa
+#if MODO_PERFIL_MUTEX
+#define TOMAR_MUTEX(mutex, perfil, espera)  tomar_mutex_perfilado((mutex), (perfil), (espera))
+#define SOLTAR_MUTEX(mutex, perfil)         soltar_mutex_perfilado((mutex), (perfil))
+#else
+#define TOMAR_MUTEX(mutex, perfil, espera)  xSemaphoreTake((mutex), (espera))
+#define SOLTAR_MUTEX(mutex, perfil)         xSemaphoreGive(mutex)
+#endif
+
+#endif // PERFIL_MUTEX_H
@@ -0,0 +1,133 @@
+// Perfil de pilas (MODO_PERFIL_PILAS) para Leds e Interrupciones.c, Multitarea.c
+// y Sincro Avanzada.c
+//
+// Va junto a los programas en main/, como traza_freertos.h. Cada programa lo
+// incluye una sola vez, después de definir TAG (avisa con él cuando escribe el
+// archivo); las funciones son static, así que no hace falta compilarlo aparte.
+// El programa arma su tabla de macros y marcas de agua en tarea_perfil_pilas y
+// la pasa a publicar_header_pilas con el nombre del header que genera.
+//
+// La política de margen es la misma en los tres: la pila usada más
+// PERFIL_MARGEN_PORCIENTO (PERFIL_MARGEN_MINIMO como mínimo), redondeada a
+// PERFIL_ALINEACION y nunca por debajo de configMINIMAL_STACK_SIZE.
+#ifndef PERFIL_PILAS_H
+#define PERFIL_PILAS_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#define PERFIL_DURACION_MS        30000
+#define PERFIL_MARGEN_PORCIENTO   25      // Margen sobre la pila usada
+#define PERFIL_MARGEN_MINIMO      256     // Bytes, para las tareas que usan muy poco
+#define PERFIL_ALINEACION         16
+#define PILA_PERFIL               3072
+
+typedef struct {
+    const char *macro;          // Macro del header generado
+    uint32_t pila;              // Pila con la que corrió (bytes)
+    uint32_t libre;             // Marca de agua (bytes)
+    uint32_t tareas;            // Tareas que usan la macro (el ahorro se multiplica)
+} perfil_pila_t;
+
+// Pila usada más el margen, redondeada y nunca por debajo del mínimo de FreeRTOS
+static uint32_t pila_recomendada(uint32_t usada)
+{
+    uint32_t margen = usada * PERFIL_MARGEN_PORCIENTO / 100;
+    if (margen < PERFIL_MARGEN_MINIMO) {
+        margen = PERFIL_MARGEN_MINIMO;
+    }
+    uint32_t pila = (usada + margen + PERFIL_ALINEACION - 1) / PERFIL_ALINEACION * PERFIL_ALINEACION;
+    return pila < configMINIMAL_STACK_SIZE ? configMINIMAL_STACK_SIZE : pila;
+}
+
+/**
+ * Marca de agua de varias tareas que comparten una macro de pila
+ * Manda la que menos pila dejó libre; los handles NULL (tareas sin crear) no cuentan
+ *
+ * @param tareas: Handles de las tareas
+ * @param n: Cantidad de handles
+ * @param pila: Pila con la que corrieron, lo que se devuelve si no hay ninguna
+ * @return Bytes libres de la más exigida
+ */
+static uint32_t libre_minimo_pilas(const TaskHandle_t *tareas, size_t n, uint32_t pila)
+{
+    uint32_t libre_minimo = pila;
+    for (size_t i = 0; i < n; i++) {
+        if (tareas[i] != NULL) {
+            uint32_t libre = uxTaskGetStackHighWaterMark(tareas[i]);
+            if (libre < libre_minimo) {
+                libre_minimo = libre;
+            }
+        }
+    }
+    return libre_minimo;
+}
+
+/**
+ * Escribe el header de pilas con el ahorro de cada macro
+ *
+ * @param salida: Donde escribirlo (consola o archivo)
+ * @param archivo: Nombre del header, para el comentario inicial
+ * @param detalle: Con qué se perfiló (por ejemplo el modo de LEDs), o NULL
+ * @param perfiles: Una entrada por macro
+ * @param n: Cantidad de entradas
+ */
+static void escribir_header_pilas(FILE *salida, const char *archivo, const char *detalle,
+                                  const perfil_pila_t *perfiles, size_t n)
+{
+    long ahorro_total = 0;
+
+    fprintf(salida, "// %s: generado por MODO_PERFIL_PILAS tras %d ms de trabajo", archivo, PERFIL_DURACION_MS);
+    if (detalle != NULL) {
+        fprintf(salida, " (%s)", detalle);
+    }
+    fprintf(salida, "\n// Pila usada + %d%% (mínimo %d B), en bytes\n",
+            PERFIL_MARGEN_PORCIENTO, PERFIL_MARGEN_MINIMO);
+    fprintf(salida, "#pragma once\n");
+    for (size_t i = 0; i < n; i++) {
+        uint32_t usada = perfiles[i].pila - perfiles[i].libre;
+        uint32_t nueva = pila_recomendada(usada);
+        long ahorro = (long) perfiles[i].pila - (long) nueva;
+        uint32_t tareas = perfiles[i].tareas > 0 ? perfiles[i].tareas : 1;
+        ahorro_total += ahorro * (long) tareas;
+        fprintf(salida, "#define %-22s %5" PRIu32 "   // usada %" PRIu32 " de %" PRIu32 " B, ahorro %ld B",
+                perfiles[i].macro, nueva, usada, perfiles[i].pila, ahorro);
+        if (tareas > 1) {
+            fprintf(salida, " x %" PRIu32 " tareas", tareas);
+        }
+        fprintf(salida, "\n");
+    }
+    fprintf(salida, "// Ahorro total: %ld B\n", ahorro_total);
+}
+
+/**
+ * Imprime el header entre dos marcas para copiarlo junto al programa
+ * En el puerto Linux además lo escribe en el directorio de trabajo
+ *
+ * @param archivo: Nombre del header generado
+ * @param detalle: Con qué se perfiló, o NULL
+ * @param perfiles: Una entrada por macro
+ * @param n: Cantidad de entradas
+ */
+static void publicar_header_pilas(const char *archivo, const char *detalle,
+                                  const perfil_pila_t *perfiles, size_t n)
+{
+    printf("----- %s -----\n", archivo);
+    escribir_header_pilas(stdout, archivo, detalle, perfiles, n);
+    printf("----- fin de %s -----\n", archivo);
+#if CONFIG_IDF_TARGET_LINUX
+    FILE *salida = fopen(archivo, "w");
+    if (salida != NULL) {
+        escribir_header_pilas(salida, archivo, detalle, perfiles, n);
+        fclose(salida);
+        ESP_LOGI(TAG, "%s escrito en el directorio de trabajo", archivo);
+    }
+#endif
+}
+
+#endif // PERFIL_PILAS_H
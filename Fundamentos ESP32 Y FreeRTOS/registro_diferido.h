@@ -0,0 +1,257 @@
+// Registro diferido de logs (MODO_REGISTRO_DIFERIDO y MODO_BENCHMARK_REGISTRO)
+// para Leds e Interrupciones.c, Multitarea.c y Sincro Avanzada.c
+//
+// Va junto a los programas en main/, como traza_freertos.h. Cada programa lo
+// incluye una sola vez, después de definir TAG (el drenado escribe con él); las
+// funciones son static, así que no hace falta compilarlo aparte. El programa
+// define LOGI_DIFERIDO y PILA_DRENADO, y crea tarea_drenado_registro con
+// prioridad mínima guardando su handle en tarea_drenado.
+//
+// REGISTRAR_DIFERIDO no formatea ni escribe en la UART: guarda la dirección del
+// formato (el ID del mensaje), la marca de tiempo y hasta 3 argumentos crudos
+// en el anillo del núcleo que llama. tarea_drenado_registro, de prioridad
+// mínima, los convierte a texto cuando no hay nada más que hacer.
+// Los argumentos de texto deben ser constantes (se guarda el puntero), los
+// flotantes se guardan como float y no hay %lld. Solo desde tareas, no desde ISRs.
+#ifndef REGISTRO_DIFERIDO_H
+#define REGISTRO_DIFERIDO_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define REGISTRO_CAPACIDAD   64     // Registros por núcleo
+#define REGISTRO_MAX_ARGS    3
+
+typedef struct {
+    volatile uint32_t secuencia;        // Posición + 1 cuando el registro está completo
+    uint32_t marca_us;                  // Instante en que se registró
+    const char *formato;                // ID del mensaje: la dirección de su formato
+    uintptr_t args[REGISTRO_MAX_ARGS];  // Argumentos crudos (float como sus bits)
+} registro_t;
+
+// Anillo de un núcleo. Los productores reservan posición con compare-and-swap,
+// así que una tarea que se interrumpe a sí misma o que migra de núcleo no
+// corrompe nada; el anillo por núcleo solo evita que los núcleos compitan
+typedef struct {
+    uint32_t escritura;                 // Siguiente posición a reservar
+    uint32_t lectura;                   // Siguiente posición a drenar
+    uint32_t perdidos;                  // Descartados con el anillo lleno
+    registro_t registros[REGISTRO_CAPACIDAD];
+} anillo_registro_t;
+
+static anillo_registro_t anillos_registro[portNUM_PROCESSORS];
+static TaskHandle_t tarea_drenado = NULL;
+
+static inline uintptr_t arg_flotante(double v)
+{
+    float f = (float) v;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static inline uintptr_t arg_texto(const void *p)
+{
+    return (uintptr_t) p;
+}
+
+static inline uintptr_t arg_entero(uintptr_t v)
+{
+    return v;
+}
+
+// Convierte un argumento a su forma cruda según su tipo
+#define ARG_REGISTRO(x) _Generic((x), \
+    float: arg_flotante, double: arg_flotante, \
+    char *: arg_texto, const char *: arg_texto, \
+    default: arg_entero)(x)
+#define ARGS_REGISTRO(a, b, c, ...)  ARG_REGISTRO(a), ARG_REGISTRO(b), ARG_REGISTRO(c)
+
+// Registra siempre en el anillo (de 1 a 3 argumentos)
+#define REGISTRAR_DIFERIDO(formato, ...) \
+    registrar_diferido((formato), ARGS_REGISTRO(__VA_ARGS__, 0, 0, 0))
+
+/**
+ * Guarda un registro en el anillo del núcleo actual
+ * Si el anillo está lleno el registro se descarta y se cuenta: nunca bloquea
+ * 
+ * @param formato: Formato printf del mensaje (cadena constante)
+ * @param a0, a1, a2: Argumentos crudos
+ */
+static void registrar_diferido(const char *formato, uintptr_t a0, uintptr_t a1, uintptr_t a2)
+{
+    anillo_registro_t *anillo = &anillos_registro[xPortGetCoreID()];
+    uint32_t lectura;
+    uint32_t pos = __atomic_load_n(&anillo->escritura, __ATOMIC_RELAXED);
+    do {
+        lectura = __atomic_load_n(&anillo->lectura, __ATOMIC_ACQUIRE);
+        if (pos - lectura >= REGISTRO_CAPACIDAD) {
+            __atomic_fetch_add(&anillo->perdidos, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&anillo->escritura, &pos, pos + 1, true,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    
+    registro_t *r = &anillo->registros[pos % REGISTRO_CAPACIDAD];
+    r->marca_us = (uint32_t) esp_timer_get_time();
+    r->formato = formato;
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    __atomic_store_n(&r->secuencia, pos + 1, __ATOMIC_RELEASE);
+    
+    // Solo el primer registro de un anillo vacío despierta al drenado. La lectura
+    // se vuelve a leer después de reservar: si el drenado vació el anillo justo
+    // antes, o ve esta reserva como pendiente, o aquí se ve su lectura al día
+    if (pos == __atomic_load_n(&anillo->lectura, __ATOMIC_SEQ_CST) && tarea_drenado != NULL) {
+        xTaskNotifyGive(tarea_drenado);
+    }
+}
+
+/**
+ * Convierte un registro a texto
+ * Recorre el formato y aplica cada especificación a su argumento con el tipo
+ * que indica la conversión (f/e/g = float, s = texto, d/i = con signo, el resto
+ * sin signo; 'l' o 'z' = long o size_t)
+ * 
+ * @param texto: Destino
+ * @param tam: Tamaño del destino
+ * @param r: Registro a convertir
+ */
+static void formatear_registro(char *texto, size_t tam, const registro_t *r)
+{
+    size_t n = 0;
+    int arg = 0;
+    
+    for (const char *p = r->formato; *p != '\0' && n + 1 < tam; p++) {
+        if (*p != '%') {
+            texto[n++] = *p;
+            continue;
+        }
+        
+        // Copia la especificación completa: banderas, ancho, precisión y longitud
+        char spec[16];
+        size_t k = 0;
+        spec[k++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.lhz", *p) != NULL && k < sizeof(spec) - 2) {
+            spec[k++] = *p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        char conversion = *p;
+        spec[k++] = conversion;
+        spec[k] = '\0';
+        
+        if (conversion == '%') {
+            texto[n++] = '%';
+            continue;
+        }
+        
+        uintptr_t v = arg < REGISTRO_MAX_ARGS ? r->args[arg] : 0;
+        arg++;
+        bool largo = strchr(spec, 'l') != NULL;
+        bool tam_t = strchr(spec, 'z') != NULL;
+        int escritos;
+        if (conversion == 'f' || conversion == 'e' || conversion == 'g') {
+            uint32_t bits = (uint32_t) v;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            escritos = snprintf(texto + n, tam - n, spec, (double) f);
+        } else if (conversion == 's') {
+            escritos = snprintf(texto + n, tam - n, spec, (const char *) v);
+        } else if (conversion == 'd' || conversion == 'i') {
+            escritos = largo ? snprintf(texto + n, tam - n, spec, (long)(intptr_t) v)
+                             : snprintf(texto + n, tam - n, spec, (int) v);
+        } else if (tam_t) {
+            escritos = snprintf(texto + n, tam - n, spec, (size_t) v);
+        } else {
+            escritos = largo ? snprintf(texto + n, tam - n, spec, (unsigned long) v)
+                             : snprintf(texto + n, tam - n, spec, (unsigned) v);
+        }
+        if (escritos > 0) {
+            n += ((size_t) escritos < tam - n) ? (size_t) escritos : tam - n - 1;
+        }
+    }
+    texto[n] = '\0';
+}
+
+/**
+ * Saca el registro publicado más antiguo de todos los núcleos
+ * 
+ * @param copia: Destino del registro
+ * @return true si había un registro completo
+ */
+static bool sacar_registro(registro_t *copia)
+{
+    anillo_registro_t *elegido = NULL;
+    
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        anillo_registro_t *anillo = &anillos_registro[c];
+        uint32_t pos = anillo->lectura;
+        const registro_t *r = &anillo->registros[pos % REGISTRO_CAPACIDAD];
+        if (__atomic_load_n(&r->secuencia, __ATOMIC_ACQUIRE) != pos + 1) {
+            continue;   // Vacío, o el productor todavía no termina de escribirlo
+        }
+        if (elegido == NULL ||
+           (int32_t)(r->marca_us - elegido->registros[elegido->lectura % REGISTRO_CAPACIDAD].marca_us) < 0) {
+            elegido = anillo;
+        }
+    }
+    if (elegido == NULL) {
+        return false;
+    }
+    
+    *copia = elegido->registros[elegido->lectura % REGISTRO_CAPACIDAD];
+    // Libera la posición para los productores después de copiarla
+    __atomic_store_n(&elegido->lectura, elegido->lectura + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Tarea de drenado del registro diferido
+ * Escribe los registros en orden de marca de tiempo con ESP_LOGI. Duerme sin
+ * timeout hasta que un anillo vacío recibe un registro
+ */
+static void tarea_drenado_registro(void *pvParameters)
+{
+    char texto[128];
+    uint32_t perdidos_reportados = 0;
+    registro_t r;
+    
+    while (1) {
+        while (sacar_registro(&r)) {
+            formatear_registro(texto, sizeof(texto), &r);
+            ESP_LOGI(TAG, "[%" PRIu32 ".%03" PRIu32 " ms] %s", r.marca_us / 1000, r.marca_us % 1000, texto);
+        }
+        
+        uint32_t perdidos = 0;
+        bool pendientes = false;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);   // Pareja de la relectura del productor
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            perdidos += __atomic_load_n(&anillos_registro[c].perdidos, __ATOMIC_RELAXED);
+            pendientes |= __atomic_load_n(&anillos_registro[c].escritura, __ATOMIC_RELAXED) !=
+                          anillos_registro[c].lectura;
+        }
+        if (perdidos != perdidos_reportados) {
+            ESP_LOGW(TAG, "Registro diferido: %" PRIu32 " registros perdidos con el anillo lleno",
+                     perdidos - perdidos_reportados);
+            perdidos_reportados = perdidos;
+        }
+        
+        if (pendientes) {
+            vTaskDelay(1);  // Un productor reservó y todavía no publica
+        } else {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,220 @@
+// Anillo de la traza (MODO_TRAZA) para Multitarea.c y Sincro Avanzada.c
+//
+// El anillo, traza_evento, traza_tarea_creada y la tarea que vuelca la traza.
+// Va junto a traza_freertos.h, que tiene los ganchos; este header lo incluye
+// solo el programa, una vez y después de definir TAG y ARCHIVO_TRAZA:
+//
+//     #define ARCHIVO_TRAZA  "traza_programa.txt"
+//     #include "traza_anillo.h"
+//
+// El programa crea tarea_traza con PILA_TRAZA, le pasa lo que hace después del
+// volcado y nombra sus objetos con traza_nombrar
+
+#ifndef TRAZA_ANILLO_H
+#define TRAZA_ANILLO_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "traza_freertos.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#else
+#include "esp_attr.h"
+#include "esp_cpu.h"                  // Contador de ciclos para las marcas de tiempo
+#endif
+
+// Los ganchos de traza_freertos.h llaman a traza_evento desde el kernel: cambios
+// de tarea, envíos y recepciones en colas, semáforos y mutex, bloqueos e ISRs.
+// Cada evento reserva una posición en un anillo con un incremento atómico y
+// escribe marca de tiempo, núcleo, tipo y objeto; no hay bloqueos, así que se
+// puede llamar desde el cambio de contexto y desde ISRs. Si el anillo da la
+// vuelta se pisan los más viejos: el volcado tiene los últimos TRAZA_CAPACIDAD.
+// Pasados TRAZA_DURACION_MS se detiene y se vuelca como texto entre dos líneas
+// -----; convertir_traza.py lo pasa a JSON de Chrome/Perfetto.
+// En el puerto Linux además se escribe ARCHIVO_TRAZA
+
+#ifndef ARCHIVO_TRAZA
+#error "Definir ARCHIVO_TRAZA antes de incluir traza_anillo.h"
+#endif
+
+#define TRAZA_CAPACIDAD      2048       // Eventos (16 B cada uno en el chip)
+#define TRAZA_MAX_NOMBRES    32         // Tareas creadas y objetos nombrados
+#define TRAZA_DURACION_MS    20000
+#define PILA_TRAZA           3072
+
+// Reloj de las marcas: en el chip los ciclos de la CPU, pero los contadores de
+// ciclos de los dos núcleos no están sincronizados, así que con dos núcleos se
+// usa esp_timer; en la PC, nanosegundos del reloj monotónico
+#if CONFIG_IDF_TARGET_LINUX
+#define RELOJ_TRAZA_HZ     1000000000ULL
+#define BITS_MARCA_TRAZA   64
+static inline uint64_t marca_traza(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#elif CONFIG_FREERTOS_UNICORE
+#define RELOJ_TRAZA_HZ     (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000ULL)
+#define BITS_MARCA_TRAZA   32           // El contador de ciclos da la vuelta; el convertidor la suma
+static inline uint64_t IRAM_ATTR marca_traza(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+#else
+#define RELOJ_TRAZA_HZ     1000000ULL
+#define BITS_MARCA_TRAZA   64
+static inline uint64_t IRAM_ATTR marca_traza(void)
+{
+    return (uint64_t) esp_timer_get_time();
+}
+#endif
+
+typedef struct {
+    uint64_t marca;
+    const void *objeto;                 // Tarea, cola o semáforo
+    uint16_t dato;                      // Índice del nombre (TRAZA_CREA) o número de ISR
+    uint8_t tipo;
+    uint8_t nucleo;
+} evento_traza_t;
+
+// Nombre de una tarea (lo copia el gancho al crearla) o de un objeto (traza_nombrar)
+typedef struct {
+    const void *objeto;
+    char nombre[configMAX_TASK_NAME_LEN];
+    volatile bool listo;
+} nombre_traza_t;
+
+static evento_traza_t eventos_traza[TRAZA_CAPACIDAD];
+static uint32_t escritura_traza;                // Eventos reservados desde el arranque
+static volatile bool traza_activa = true;       // Desde antes de app_main
+static nombre_traza_t nombres_traza[TRAZA_MAX_NOMBRES];
+static uint32_t num_nombres_traza;
+
+static const char *const nombres_tipo_traza[NUM_TIPOS_TRAZA] = {
+    [TRAZA_CREA]           = "crea",
+    [TRAZA_ENTRA]          = "entra",
+    [TRAZA_SALE]           = "sale",
+    [TRAZA_COLA_ENVIA]     = "cola_envia",
+    [TRAZA_COLA_RECIBE]    = "cola_recibe",
+    [TRAZA_SEMAFORO_DA]    = "semaforo_da",
+    [TRAZA_SEMAFORO_TOMA]  = "semaforo_toma",
+    [TRAZA_BLOQUEO_ENVIA]  = "bloqueo_envia",
+    [TRAZA_BLOQUEO_RECIBE] = "bloqueo_recibe",
+    [TRAZA_ISR_ENTRA]      = "isr_entra",
+    [TRAZA_ISR_SALE]       = "isr_sale",
+};
+
+void IRAM_ATTR traza_evento(uint8_t tipo, const void *objeto, uint16_t dato)
+{
+    if (!__atomic_load_n(&traza_activa, __ATOMIC_RELAXED)) {
+        return;
+    }
+    uint32_t i = __atomic_fetch_add(&escritura_traza, 1, __ATOMIC_RELAXED);
+    evento_traza_t *e = &eventos_traza[i % TRAZA_CAPACIDAD];
+    e->marca = marca_traza();
+    e->objeto = objeto;
+    e->dato = dato;
+    e->tipo = tipo;
+    e->nucleo = (uint8_t) xPortGetCoreID();
+}
+
+// Guarda un nombre y devuelve su índice (TRAZA_MAX_NOMBRES si ya no caben)
+static uint16_t IRAM_ATTR guardar_nombre_traza(const void *objeto, const char *nombre)
+{
+    uint32_t i = __atomic_fetch_add(&num_nombres_traza, 1, __ATOMIC_RELAXED);
+    if (i >= TRAZA_MAX_NOMBRES) {
+        return TRAZA_MAX_NOMBRES;
+    }
+    nombre_traza_t *n = &nombres_traza[i];
+    n->objeto = objeto;
+    // Copia a mano: corre dentro de la sección crítica de xTaskCreate
+    size_t c = 0;
+    for (; c < sizeof(n->nombre) - 1 && nombre[c] != '\0'; c++) {
+        n->nombre[c] = nombre[c];
+    }
+    n->nombre[c] = '\0';
+    __atomic_store_n(&n->listo, true, __ATOMIC_RELEASE);
+    return (uint16_t) i;
+}
+
+void IRAM_ATTR traza_tarea_creada(const void *tarea, const char *nombre)
+{
+    traza_evento(TRAZA_CREA, tarea, guardar_nombre_traza(tarea, nombre));
+}
+
+// Nombre para las colas, semáforos y mutex del programa (las tareas ya lo tienen)
+static void traza_nombrar(const void *objeto, const char *nombre)
+{
+    guardar_nombre_traza(objeto, nombre);
+}
+
+/**
+ * Escribe la traza detenida como texto, una línea por registro:
+ * traza,reloj_hz=...,bits=...,eventos=...,sobrescritos=...
+ * nombre,índice,objeto,nombre
+ * evento,marca,núcleo,tipo,objeto,dato (del más viejo al más nuevo)
+ */
+static void escribir_traza(FILE *salida)
+{
+    uint32_t total = __atomic_load_n(&escritura_traza, __ATOMIC_ACQUIRE);
+    uint32_t primero = total > TRAZA_CAPACIDAD ? total - TRAZA_CAPACIDAD : 0;
+    uint32_t nombres = __atomic_load_n(&num_nombres_traza, __ATOMIC_ACQUIRE);
+    
+    fprintf(salida, "traza,reloj_hz=%llu,bits=%d,eventos=%" PRIu32 ",sobrescritos=%" PRIu32 "\n",
+            (unsigned long long) RELOJ_TRAZA_HZ, BITS_MARCA_TRAZA, total - primero, primero);
+    for (uint32_t i = 0; i < nombres && i < TRAZA_MAX_NOMBRES; i++) {
+        if (nombres_traza[i].listo) {
+            fprintf(salida, "nombre,%" PRIu32 ",%p,%s\n", i, nombres_traza[i].objeto, nombres_traza[i].nombre);
+        }
+    }
+    for (uint32_t i = primero; i < total; i++) {
+        const evento_traza_t *e = &eventos_traza[i % TRAZA_CAPACIDAD];
+        fprintf(salida, "evento,%llu,%u,%s,%p,%u\n", (unsigned long long) e->marca, e->nucleo,
+                e->tipo < NUM_TIPOS_TRAZA ? nombres_tipo_traza[e->tipo] : "?", e->objeto, e->dato);
+    }
+}
+
+// Lo que hace el programa después del volcado (en la PC, por ejemplo, terminar)
+typedef void (*fin_traza_t)(void);
+
+/**
+ * Deja correr la práctica, detiene la traza y la vuelca
+ *
+ * @param pvParameters: fin_traza_t que se llama tras el volcado, o NULL
+ */
+static void tarea_traza(void *pvParameters)
+{
+    fin_traza_t fin = (fin_traza_t) pvParameters;
+    
+    vTaskDelay(pdMS_TO_TICKS(TRAZA_DURACION_MS));
+    __atomic_store_n(&traza_activa, false, __ATOMIC_RELAXED);
+    // Un evento que ya había reservado su lugar termina de escribirse en nanosegundos
+    vTaskDelay(1);
+    
+    printf("----- traza -----\n");
+    escribir_traza(stdout);
+    printf("----- fin de traza -----\n");
+#if CONFIG_IDF_TARGET_LINUX
+    FILE *archivo = fopen(ARCHIVO_TRAZA, "w");
+    if (archivo != NULL) {
+        escribir_traza(archivo);
+        fclose(archivo);
+        ESP_LOGI(TAG, "%s escrito en el directorio de trabajo", ARCHIVO_TRAZA);
+    }
+#endif
+    if (fin != NULL) {
+        fin();
+    }
+    vTaskDelete(NULL);
+}
+
+#endif // TRAZA_ANILLO_H
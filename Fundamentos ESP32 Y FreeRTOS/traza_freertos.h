@@ -0,0 +1,69 @@
+// Ganchos de traza de FreeRTOS para MODO_TRAZA (Multitarea.c y Sincro Avanzada.c)
+//
+// Las macros trace... de FreeRTOS se expanden dentro del kernel (tasks.c y
+// queue.c), así que este header tiene que llegar a todos los componentes antes
+// que FreeRTOSConfig.h. En el CMakeLists.txt del proyecto, antes de project():
+//
+//     idf_build_set_property(COMPILE_OPTIONS
+//         "-include${CMAKE_CURRENT_LIST_DIR}/main/traza_freertos.h" APPEND)
+//
+// y configUSE_TRACE_FACILITY (CONFIG_FREERTOS_USE_TRACE_FACILITY) activo. No se
+// combina con SystemView ni con otra herramienta que defina las mismas macros.
+// traza_evento y traza_tarea_creada están en traza_anillo.h, que incluye solo
+// el programa: anotan en un anillo en memoria, no bloquean y se pueden llamar
+// desde ISRs y desde el cambio de contexto.
+#ifndef TRAZA_FREERTOS_H
+#define TRAZA_FREERTOS_H
+
+#include <stdint.h>
+
+// Tipos de evento (el volcado los escribe por nombre, no por número)
+typedef enum {
+    TRAZA_CREA,                 // Tarea creada; dato = índice de su nombre
+    TRAZA_ENTRA,                // La tarea empieza a correr en el núcleo
+    TRAZA_SALE,                 // La tarea deja el núcleo
+    TRAZA_COLA_ENVIA,
+    TRAZA_COLA_RECIBE,
+    TRAZA_SEMAFORO_DA,          // Semáforos y mutex (son colas sin datos)
+    TRAZA_SEMAFORO_TOMA,
+    TRAZA_BLOQUEO_ENVIA,        // La tarea se bloquea esperando lugar en la cola
+    TRAZA_BLOQUEO_RECIBE,       // La tarea se bloquea esperando un dato o el semáforo
+    TRAZA_ISR_ENTRA,            // dato = número de interrupción
+    TRAZA_ISR_SALE,
+    NUM_TIPOS_TRAZA
+} tipo_traza_t;
+
+void traza_evento(uint8_t tipo, const void *objeto, uint16_t dato);
+void traza_tarea_creada(const void *tarea, const char *nombre);
+
+// Con configUSE_TRACE_FACILITY cada cola guarda su tipo: las de datos son
+// queueQUEUE_TYPE_BASE, el resto son semáforos o mutex
+#define TRAZA_ES_COLA(cola)  ((cola)->ucQueueType == queueQUEUE_TYPE_BASE)
+
+#define traceTASK_CREATE(pxNewTCB) \
+    traza_tarea_creada((pxNewTCB), (pxNewTCB)->pcTaskName)
+#define traceTASK_SWITCHED_IN() \
+    traza_evento(TRAZA_ENTRA, xTaskGetCurrentTaskHandle(), 0)
+#define traceTASK_SWITCHED_OUT() \
+    traza_evento(TRAZA_SALE, xTaskGetCurrentTaskHandle(), 0)
+
+#define traceQUEUE_SEND(pxQueue) \
+    traza_evento(TRAZA_ES_COLA(pxQueue) ? TRAZA_COLA_ENVIA : TRAZA_SEMAFORO_DA, (pxQueue), 0)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)  traceQUEUE_SEND(pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue) \
+    traza_evento(TRAZA_ES_COLA(pxQueue) ? TRAZA_COLA_RECIBE : TRAZA_SEMAFORO_TOMA, (pxQueue), 0)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)  traceQUEUE_RECEIVE(pxQueue)
+// Las versiones nuevas del kernel toman los semáforos por aquí y no por traceQUEUE_RECEIVE
+#define traceQUEUE_SEMAPHORE_RECEIVE(pxQueue) \
+    traza_evento(TRAZA_SEMAFORO_TOMA, (pxQueue), 0)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+    traza_evento(TRAZA_BLOQUEO_ENVIA, (pxQueue), 0)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+    traza_evento(TRAZA_BLOQUEO_RECIBE, (pxQueue), 0)
+
+// Solo los puertos que llaman a estas macros en sus vectores registran las ISRs;
+// las ISRs propias pueden llamarlas al entrar y al salir
+#define traceISR_ENTER(n)  traza_evento(TRAZA_ISR_ENTRA, 0, (uint16_t) (n))
+#define traceISR_EXIT()    traza_evento(TRAZA_ISR_SALE, 0, 0)
+
+#endif // TRAZA_FREERTOS_H